@@ -9,6 +9,23 @@
 #include <curl/curl.h>
 #endif
 
+#include <pthread.h>
+#include <time.h>
+
+/* default size of keep-alive connection pool. */
+#define KII_CURL_POOL_DEFAULT_SIZE 4
+/* default idle period in second before pooled connection is closed. */
+#define KII_CURL_POOL_DEFAULT_IDLE_TIMEOUT 60
+/* max length of pool key. ("scheme://host:port") */
+#define KII_CURL_POOL_KEY_SIZE 256
+#define KII_CURL_DEFAULT_CONNECT_TIMEOUT 30000L /* in milliseconds */
+/* common headers of sdk and if-match. */
+#define KII_CURL_MAX_HEADERS 8
+/* CURLSSLOPT_* bits applied to every request. */
+#ifndef KII_CURL_SSL_OPTIONS
+#define KII_CURL_SSL_OPTIONS 0L
+#endif
+
 typedef enum adapter_error_code_t {
     AEC_OK = 0,
     AEC_FAIL,
@@ -16,8 +33,276 @@ typedef enum adapter_error_code_t {
     AEC_LOWMEMORY
 } adapter_error_code_t;
 
-static adapter_error_code_t adapter_error_code;
-static CURLcode curl_error_code;
+static long connect_timeout_ms = KII_CURL_DEFAULT_CONNECT_TIMEOUT;
+
+/* curl decompresses responses by itself if compression is enabled. */
+static kii_bool_t response_compression = KII_FALSE;
+static pthread_mutex_t compression_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static kii_ulong_t compressed_bytes = 0;
+static kii_ulong_t decompressed_bytes = 0;
+
+static kii_transport_profile_t transport_profile = KII_TRANSPORT_DEFAULT;
+
+#if LIBCURL_VERSION_NUM >= 0x072F00
+/* max concurrent streams of HTTP/2 connection used by async requests.
+ * 0 if async requests are sent by HTTP/1.1. */
+static kii_uint_t http2_max_streams = 0;
+#endif
+
+/* Name resolutions and TLS sessions shared by all handles of all threads,
+ * so that a thread reuses warm state obtained by others. Connections are
+ * shared by curl_pool instead, since curl doesn't support sharing its
+ * connection cache between concurrent threads. */
+static CURLSH* curl_share = NULL;
+static pthread_mutex_t curl_share_mutexes[CURL_LOCK_DATA_LAST];
+
+/* curl easy handle keeps its connection open after the transfer.
+ * Handles are pooled by host so that following requests to the same
+ * host can reuse warm connection without TCP and TLS handshake. */
+typedef struct prv_curl_pool_entry_t {
+    kii_char_t key[KII_CURL_POOL_KEY_SIZE];
+    CURL* curl;
+    time_t last_used;
+    kii_bool_t in_use;
+} prv_curl_pool_entry_t;
+
+typedef struct prv_curl_pool_t {
+    pthread_mutex_t mutex;
+    prv_curl_pool_entry_t* entries;
+    kii_uint_t size;
+    kii_uint_t idle_timeout;
+} prv_curl_pool_t;
+
+static prv_curl_pool_t curl_pool = {
+    PTHREAD_MUTEX_INITIALIZER,
+    NULL,
+    0,
+    KII_CURL_POOL_DEFAULT_IDLE_TIMEOUT
+};
+
+/* Extract "scheme://host:port" part of url as pool key.
+ * Returns KII_FALSE if key is too long to be pooled. */
+static kii_bool_t prv_curl_pool_key(
+        const kii_char_t* url,
+        kii_char_t* key,
+        size_t key_size)
+{
+    const kii_char_t* host = url;
+    size_t len = 0;
+
+    /* skip "scheme://" */
+    for (; *host != '\0'; ++host) {
+        if (host[0] == ':' && host[1] == '/' && host[2] == '/') {
+            host += 3;
+            break;
+        }
+    }
+    if (*host == '\0') {
+        host = url;
+    }
+    while (host[len] != '\0' && host[len] != '/') {
+        ++len;
+    }
+    len += (size_t)(host - url);
+    if (len >= key_size) {
+        return KII_FALSE;
+    }
+    kii_memcpy(key, url, len);
+    key[len] = '\0';
+    return KII_TRUE;
+}
+
+static void prv_curl_pool_close_entry(prv_curl_pool_entry_t* entry)
+{
+    curl_easy_setopt(entry->curl, CURLOPT_SHARE, NULL);
+    curl_easy_cleanup(entry->curl);
+    entry->curl = NULL;
+    entry->key[0] = '\0';
+    entry->last_used = 0;
+    entry->in_use = KII_FALSE;
+}
+
+/* Must be called with curl_pool.mutex locked. */
+static void prv_curl_pool_clear(void)
+{
+    kii_uint_t i = 0;
+    for (i = 0; i < curl_pool.size; ++i) {
+        if (curl_pool.entries[i].curl != NULL) {
+            /* entries in use must be returned before clear. */
+            M_KII_ASSERT(curl_pool.entries[i].in_use == KII_FALSE);
+            prv_curl_pool_close_entry(&curl_pool.entries[i]);
+        }
+    }
+    M_KII_FREE_NULLIFY(curl_pool.entries);
+    curl_pool.size = 0;
+}
+
+/* Must be called with curl_pool.mutex locked. */
+static kii_bool_t prv_curl_pool_resize(kii_uint_t size)
+{
+    prv_curl_pool_clear();
+    if (size == 0) {
+        return KII_TRUE;
+    }
+    curl_pool.entries = kii_malloc(sizeof(prv_curl_pool_entry_t) * size);
+    if (curl_pool.entries == NULL) {
+        return KII_FALSE;
+    }
+    kii_memset(curl_pool.entries, 0, sizeof(prv_curl_pool_entry_t) * size);
+    curl_pool.size = size;
+    return KII_TRUE;
+}
+
+/* Obtain curl handle for url.
+ * Idle handle connected to same host is preferred. If pool is full, handle
+ * which is not managed by the pool is returned. In both cases returned handle
+ * must be given back by prv_curl_pool_release(CURL*). */
+static CURL* prv_curl_pool_acquire(const kii_char_t* url)
+{
+    kii_char_t key[KII_CURL_POOL_KEY_SIZE];
+    prv_curl_pool_entry_t* found = NULL;
+    prv_curl_pool_entry_t* empty = NULL;
+    prv_curl_pool_entry_t* oldest = NULL;
+    time_t now = time(NULL);
+    kii_uint_t i = 0;
+    CURL* ret = NULL;
+
+    if (prv_curl_pool_key(url, key, sizeof(key)) == KII_FALSE) {
+        return curl_easy_init();
+    }
+
+    pthread_mutex_lock(&curl_pool.mutex);
+    for (i = 0; i < curl_pool.size; ++i) {
+        prv_curl_pool_entry_t* entry = &curl_pool.entries[i];
+        if (entry->in_use == KII_TRUE) {
+            continue;
+        }
+        /* close connections idle for too long. */
+        if (entry->curl != NULL &&
+                (kii_uint_t)(now - entry->last_used) >=
+                curl_pool.idle_timeout) {
+            prv_curl_pool_close_entry(entry);
+        }
+        if (entry->curl == NULL) {
+            if (empty == NULL) {
+                empty = entry;
+            }
+        } else if (kii_strncmp(entry->key, key, sizeof(key)) == 0) {
+            found = entry;
+            break;
+        } else if (oldest == NULL || entry->last_used < oldest->last_used) {
+            oldest = entry;
+        }
+    }
+
+    if (found == NULL) {
+        /* evict least recently used connection to other host. */
+        found = (empty != NULL) ? empty : oldest;
+        if (found != NULL) {
+            if (found->curl != NULL) {
+                prv_curl_pool_close_entry(found);
+            }
+            found->curl = curl_easy_init();
+            if (found->curl != NULL) {
+                kii_strncpy(found->key, key, sizeof(found->key));
+            } else {
+                found = NULL;
+            }
+        }
+    }
+
+    if (found != NULL) {
+        found->in_use = KII_TRUE;
+        ret = found->curl;
+    }
+    pthread_mutex_unlock(&curl_pool.mutex);
+
+    return (ret != NULL) ? ret : curl_easy_init();
+}
+
+static void prv_curl_pool_release(CURL* curl)
+{
+    kii_uint_t i = 0;
+
+    if (curl == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&curl_pool.mutex);
+    for (i = 0; i < curl_pool.size; ++i) {
+        prv_curl_pool_entry_t* entry = &curl_pool.entries[i];
+        if (entry->curl == curl) {
+            entry->in_use = KII_FALSE;
+            entry->last_used = time(NULL);
+            curl = NULL;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&curl_pool.mutex);
+
+    /* not managed by the pool. */
+    if (curl != NULL) {
+        curl_easy_cleanup(curl);
+    }
+}
+
+static void prv_curl_share_lock(
+        CURL* handle,
+        curl_lock_data data,
+        curl_lock_access access,
+        void* userptr)
+{
+    (void)handle;
+    (void)access;
+    (void)userptr;
+    pthread_mutex_lock(&curl_share_mutexes[data]);
+}
+
+static void prv_curl_share_unlock(
+        CURL* handle,
+        curl_lock_data data,
+        void* userptr)
+{
+    (void)handle;
+    (void)userptr;
+    pthread_mutex_unlock(&curl_share_mutexes[data]);
+}
+
+static kii_bool_t prv_curl_share_init(void)
+{
+    int i = 0;
+    curl_share = curl_share_init();
+    if (curl_share == NULL) {
+        return KII_FALSE;
+    }
+    for (i = 0; i < CURL_LOCK_DATA_LAST; ++i) {
+        pthread_mutex_init(&curl_share_mutexes[i], NULL);
+    }
+    curl_share_setopt(curl_share, CURLSHOPT_LOCKFUNC, prv_curl_share_lock);
+    curl_share_setopt(curl_share, CURLSHOPT_UNLOCKFUNC,
+            prv_curl_share_unlock);
+    curl_share_setopt(curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    return KII_TRUE;
+}
+
+/* Pooled handles must be cleaned up before. If handles of requests in
+ * flight still use the share, it is kept with its locks for them and
+ * reused by next kii_http_init. */
+static void prv_curl_share_cleanup(void)
+{
+    int i = 0;
+    if (curl_share == NULL) {
+        return;
+    }
+    if (curl_share_cleanup(curl_share) != CURLSHE_OK) {
+        return;
+    }
+    curl_share = NULL;
+    for (i = 0; i < CURL_LOCK_DATA_LAST; ++i) {
+        pthread_mutex_destroy(&curl_share_mutexes[i]);
+    }
+}
 
 static void prv_log_req_heder(struct curl_slist* header)
 {
@@ -27,59 +312,256 @@ static void prv_log_req_heder(struct curl_slist* header)
     }
 }
 
-static struct curl_slist* convert_request_headers(
-        json_t* request_headers)
+/* Request headers linked without copying them.
+ * Nodes refer lines of kii_http_headers_t, and headers added by adapter
+ * are appended to them by curl_slist_append. */
+typedef struct prv_curl_headers_t {
+    struct curl_slist nodes[KII_CURL_MAX_HEADERS];
+    kii_uint_t count;
+    struct curl_slist* list; /* nodes followed by appended headers. */
+} prv_curl_headers_t;
+
+static adapter_error_code_t prv_link_request_headers(
+        prv_curl_headers_t* headers,
+        const kii_http_headers_t* request_headers)
 {
-    struct curl_slist* ret = NULL;
-    const char* key = NULL;
-    json_t* value = NULL;
+    const kii_char_t* const* line = NULL;
 
-    json_object_foreach(request_headers, key, value) {
-        struct curl_slist* tmp = NULL;
-        kii_char_t* hdr = prv_new_header_string(key, json_string_value(value));
-        if (hdr == NULL) {
-            curl_slist_free_all(ret);
-            return NULL;
+    headers->count = 0;
+    headers->list = NULL;
+    for (line = request_headers->common; *line != NULL; ++line) {
+        if (headers->count == KII_CURL_MAX_HEADERS) {
+            return AEC_FAIL;
         }
-        tmp = curl_slist_append(ret, hdr);
-        kii_dispose_kii_char(hdr);
-        if (tmp == NULL) {
-            curl_slist_free_all(ret);
-            return NULL;
-        } else {
-            ret = tmp;
+        /* curl doesn't modify data. */
+        headers->nodes[headers->count++].data = (char*)*line;
+    }
+    if (request_headers->opt_extra != NULL) {
+        if (headers->count == KII_CURL_MAX_HEADERS) {
+            return AEC_FAIL;
+        }
+        headers->nodes[headers->count++].data =
+            (char*)request_headers->opt_extra;
+    }
+    if (headers->count > 0) {
+        kii_uint_t i = 0;
+        for (i = 0; i + 1 < headers->count; ++i) {
+            headers->nodes[i].next = &headers->nodes[i + 1];
         }
+        headers->nodes[headers->count - 1].next = NULL;
+        headers->list = &headers->nodes[0];
     }
+    return AEC_OK;
+}
 
-    return ret;
+/* Frees headers appended to the nodes. */
+static void prv_free_request_headers(prv_curl_headers_t* headers)
+{
+    if (headers->count > 0) {
+        curl_slist_free_all(headers->nodes[headers->count - 1].next);
+        headers->nodes[headers->count - 1].next = NULL;
+    } else {
+        curl_slist_free_all(headers->list);
+    }
+    headers->list = NULL;
+}
+
+/* Response body accumulated by callbackWrite.
+ * Tracks length and capacity so that appending chunk costs linear time
+ * and body containing NUL is kept as is. data is always NUL terminated.
+ * Body of successful response is passed to sink instead if it is given. */
+typedef struct prv_curl_resp_buffer_t {
+    CURL* curl;
+    kii_char_t* data;
+    size_t length;
+    size_t capacity;
+    const kii_http_sink_t* sink;
+    long status; /* checked at first chunk if sink is given. */
+    size_t received; /* including bytes passed to sink. */
+} prv_curl_resp_buffer_t;
+
+/* initial capacity of response buffer when Content-Length is unknown. */
+#define KII_CURL_RESP_BUFFER_MIN_SIZE 1024
+/* a few times of the largest chunk passed to write callback. */
+#define KII_CURL_RESP_BUFFER_MAX_PRESIZE (4 * CURL_MAX_WRITE_SIZE)
+
+/* Request body serialized by its producer.
+ * curl pulls request body while producer pushes it, so the body is
+ * serialized into a buffer before the transfer starts. It is written in
+ * place without intermediate copy made by json_dumps. */
+typedef struct prv_curl_req_buffer_t {
+    kii_char_t* data;
+    size_t length; /* compressed body may contain NUL. */
+    size_t capacity;
+    const kii_char_t* content_encoding; /* set by producer */
+    kii_bool_t borrowed; /* data is opt_buffer or opt_bytes of the body. */
+} prv_curl_req_buffer_t;
+
+#define KII_CURL_REQ_BUFFER_MIN_SIZE 1024
+
+static int prv_curl_req_buffer_write(
+        const char* buffer,
+        size_t size,
+        void* context)
+{
+    prv_curl_req_buffer_t* body = (prv_curl_req_buffer_t*)context;
+    if (body->length + size + 1 > body->capacity) {
+        size_t newCapacity = (body->capacity > 0) ?
+            body->capacity : KII_CURL_REQ_BUFFER_MIN_SIZE;
+        kii_char_t* newData = NULL;
+        while (newCapacity < body->length + size + 1) {
+            newCapacity *= 2;
+        }
+        newData = kii_realloc(body->data, newCapacity);
+        if (newData == NULL) {
+            return -1;
+        }
+        body->data = newData;
+        body->capacity = newCapacity;
+    }
+    kii_memcpy(&(body->data[body->length]), buffer, size);
+    body->length += size;
+    body->data[body->length] = '\0';
+    return 0;
+}
+
+static void prv_curl_req_buffer_dispose(prv_curl_req_buffer_t* buffer)
+{
+    if (buffer->borrowed == KII_FALSE) {
+        M_KII_FREE_NULLIFY(buffer->data);
+    }
+    buffer->data = NULL;
+}
+
+/* data of the buffer is NULL if the request has no body. */
+static adapter_error_code_t prv_curl_req_buffer_produce(
+        prv_curl_req_buffer_t* buffer,
+        const kii_http_body_t* body)
+{
+    int r = 0;
+
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+    buffer->content_encoding = NULL;
+    buffer->borrowed = KII_FALSE;
+    if (body == NULL) {
+        return AEC_OK;
+    }
+    if (body->opt_bytes != NULL) {
+        /* curl sends it from memory of caller without copy. */
+        buffer->data = (kii_char_t*)body->opt_bytes;
+        buffer->length = body->bytes_length;
+        buffer->borrowed = KII_TRUE;
+        return AEC_OK;
+    }
+    if (body->opt_buffer != NULL) {
+        buffer->data = *(body->opt_buffer);
+        buffer->capacity = *(body->opt_capacity);
+        buffer->borrowed = KII_TRUE;
+    }
+    /* empty body is sent as empty string. */
+    r = prv_curl_req_buffer_write("", 0, buffer);
+    if (r == 0) {
+        r = body->produce(body->data, prv_curl_req_buffer_write, buffer);
+    }
+    if (buffer->borrowed == KII_TRUE) {
+        /* grown buffer is kept by its owner. */
+        *(body->opt_buffer) = buffer->data;
+        *(body->opt_capacity) = buffer->capacity;
+    }
+    if (r != 0) {
+        prv_curl_req_buffer_dispose(buffer);
+        return AEC_LOWMEMORY;
+    }
+    buffer->content_encoding = body->content_encoding;
+    return AEC_OK;
+}
+
+static void prv_curl_resp_buffer_init(
+        prv_curl_resp_buffer_t* buffer,
+        CURL* curl,
+        const kii_http_sink_t* sink)
+{
+    buffer->curl = curl;
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->capacity = 0;
+    buffer->sink = sink;
+    buffer->status = 0;
+    buffer->received = 0;
+}
+
+/* Returns capacity for the first chunk.
+ * Presized from Content-Length so that whole body fits in one allocation.
+ * Presize is capped as Content-Length is not trusted, and buffer grows
+ * past the cap as body is received. */
+static size_t prv_curl_resp_buffer_initial_capacity(
+        prv_curl_resp_buffer_t* buffer)
+{
+#if LIBCURL_VERSION_NUM >= 0x073700
+    curl_off_t contentLength = -1;
+    if (curl_easy_getinfo(buffer->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T,
+                &contentLength) == CURLE_OK && contentLength > 0) {
+        if (contentLength >= KII_CURL_RESP_BUFFER_MAX_PRESIZE) {
+            return KII_CURL_RESP_BUFFER_MAX_PRESIZE;
+        }
+        return (size_t)contentLength + 1;
+    }
+#else
+    double contentLength = -1;
+    if (curl_easy_getinfo(buffer->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD,
+                &contentLength) == CURLE_OK && contentLength > 0) {
+        if (contentLength >= KII_CURL_RESP_BUFFER_MAX_PRESIZE) {
+            return KII_CURL_RESP_BUFFER_MAX_PRESIZE;
+        }
+        return (size_t)contentLength + 1;
+    }
+#endif
+    return KII_CURL_RESP_BUFFER_MIN_SIZE;
 }
 
 static size_t callbackWrite(char* ptr,
                             size_t size,
                             size_t nmemb,
-                            kii_char_t** respData)
+                            prv_curl_resp_buffer_t* buffer)
 {
     size_t dataLen = size * nmemb;
+    size_t required = 0;
     if (dataLen == 0) {
         return 0;
     }
-    if (*respData == NULL) { /* First time. */
-        *respData = kii_malloc(dataLen+1);
-        if (respData == NULL) {
-            return 0;
+    buffer->received += dataLen;
+    if (buffer->sink != NULL) {
+        if (buffer->status == 0) {
+            curl_easy_getinfo(buffer->curl, CURLINFO_RESPONSE_CODE,
+                    &(buffer->status));
         }
-        kii_memcpy(*respData, ptr, dataLen);
-        (*respData)[dataLen] = '\0';
-    } else {
-        size_t lastLen = kii_strlen(*respData);
-        size_t newLen = lastLen + dataLen;
-        kii_char_t* concat = kii_realloc(*respData, newLen + 1);
-        if (concat == NULL) {
+        if (buffer->status >= 200 && buffer->status < 300) {
+            buffer->sink->consume(ptr, dataLen, buffer->sink->context);
+            return dataLen;
+        }
+    }
+    required = buffer->length + dataLen + 1;
+    if (required > buffer->capacity) {
+        size_t newCapacity = buffer->capacity * 2;
+        kii_char_t* newData = NULL;
+        if (buffer->data == NULL) { /* First time. */
+            newCapacity = prv_curl_resp_buffer_initial_capacity(buffer);
+        }
+        if (newCapacity < required) {
+            newCapacity = required;
+        }
+        newData = kii_realloc(buffer->data, newCapacity);
+        if (newData == NULL) {
             return 0;
         }
-        kii_strncat(concat, ptr, dataLen);
-        *respData = concat;
+        buffer->data = newData;
+        buffer->capacity = newCapacity;
     }
+    kii_memcpy(buffer->data + buffer->length, ptr, dataLen);
+    buffer->length += dataLen;
+    buffer->data[buffer->length] = '\0';
     return dataLen;
 }
 
@@ -89,72 +571,13 @@ static size_t callback_header(
         size_t nitems,
         void *userdata)
 {
-    const char ETAG[] = "etag";
     size_t len = size * nitems;
-    size_t ret = len;
-    kii_char_t* line = kii_malloc(len + 1);
 
     M_KII_ASSERT(userdata != NULL);
+    M_KII_DEBUG(prv_log_no_LF("resp header: %.*s", (int)len, buffer));
 
-    if (line == NULL) {
-        return 0;
-    }
-
-    {
-        int i = 0;
-        kii_memcpy(line, buffer, len);
-        line[len] = '\0';
-        M_KII_DEBUG(prv_log_no_LF("resp header: %s", line));
-        /* Field name becomes upper case. */
-        for (i = 0; line[i] != '\0' && line[i] != ':'; ++i) {
-            line[i] = (char)kii_tolower(line[i]);
-        }
-    }
-
-    /* check http header name. */
-    if (kii_strncmp(line, ETAG, kii_strlen(ETAG)) == 0) {
-        json_t** json = userdata;
-        int i = 0;
-        kii_char_t* value = line;
-
-        /* change line feed code lasting end of this array to '\0'. */
-        for (i = (int)len; i >= 0; --i) {
-            if (line[i] == '\0') {
-                continue;
-            } else if (line[i] == '\r' || line[i] == '\n') {
-                line[i] = '\0';
-            } else {
-                break;
-            }
-        }
-
-        /* skip until ":". */
-        while (*value != ':') {
-            ++value;
-        }
-        /* skip ':' */
-        ++value;
-        /* skip spaces. */
-        while (*value == ' ') {
-            ++value;
-        }
-
-        if (*json == NULL) {
-            *json = json_object();
-            if (*json == NULL) {
-                ret = 0;
-                goto ON_EXIT;
-            }
-        }
-        if (json_object_set_new(*json, ETAG, json_string(value)) != 0) {
-            ret = 0;
-            goto ON_EXIT;
-        }
-    }
-
-ON_EXIT:
-    M_KII_FREE_NULLIFY(line);
-    return ret;
+    prv_parse_resp_header(buffer, len, (prv_kii_resp_headers_t*)userdata);
+    return len;
 }
 
 typedef enum {
@@ -166,65 +589,129 @@ typedef enum {
     HEAD
 } prv_kii_req_method_t;
 
-static adapter_error_code_t prv_execute_curl(CURL* curl,
+static kii_bool_t prv_parse_method(
+        const kii_char_t* http_method,
+        prv_kii_req_method_t* method)
+{
+    if (kii_strncmp(http_method, "DELETE", kii_strlen("DELETE")) == 0) {
+        *method = DELETE;
+    } else if (kii_strncmp(http_method, "GET", kii_strlen("GET")) == 0) {
+        *method = GET;
+    } else if (kii_strncmp(http_method, "HEAD", kii_strlen("HEAD")) == 0) {
+        *method = HEAD;
+    } else if (kii_strncmp(http_method, "PATCH", kii_strlen("PATCH")) == 0) {
+        *method = PATCH;
+    } else if (kii_strncmp(http_method, "POST", kii_strlen("POST")) == 0) {
+        *method = POST;
+    } else if (kii_strncmp(http_method, "PUT", kii_strlen("PUT")) == 0) {
+        *method = PUT;
+    } else {
+        return KII_FALSE;
+    }
+    return KII_TRUE;
+}
+
+static adapter_error_code_t prv_append_header(
+        struct curl_slist** request_headers,
+        const kii_char_t* header)
+{
+    struct curl_slist* tmp = curl_slist_append(*request_headers, header);
+    if (tmp == NULL) {
+        return AEC_LOWMEMORY;
+    }
+    *request_headers = tmp;
+    return AEC_OK;
+}
+
+/* Options of low latency transport profiles. */
+static adapter_error_code_t prv_setup_low_latency(CURL* curl,
+        prv_kii_req_method_t method,
+        const prv_curl_req_buffer_t* request_body,
+        struct curl_slist** request_headers)
+{
+    curl_easy_setopt(curl, CURLOPT_TCP_NODELAY, 1L);
+#if LIBCURL_VERSION_NUM >= 0x073100
+    /* ignored by curl if kernel doesn't support it. */
+    curl_easy_setopt(curl, CURLOPT_TCP_FASTOPEN, 1L);
+#endif
+    /* sessions are resumed by default. */
+    curl_easy_setopt(curl, CURLOPT_SSL_SESSIONID_CACHE, 1L);
+#if LIBCURL_VERSION_NUM >= 0x080B00
+    if (method == GET &&
+            transport_profile == KII_TRANSPORT_LOW_LATENCY_EARLY_DATA) {
+        curl_easy_setopt(curl, CURLOPT_SSL_OPTIONS,
+                (long)(KII_CURL_SSL_OPTIONS | CURLSSLOPT_EARLYDATA));
+    }
+#else
+    (void)method;
+#endif
+    /* body is sent without waiting for "100 Continue" from server. */
+    if (request_body->data != NULL) {
+        return prv_append_header(request_headers, "Expect:");
+    }
+    return AEC_OK;
+}
+
+static adapter_error_code_t prv_setup_curl(CURL* curl,
         const kii_char_t* url,
         prv_kii_req_method_t method,
-        const kii_char_t* request_body,
-        struct curl_slist* request_headers,
-        long* response_status_code,
-        kii_char_t** response_body,
-        json_t** response_headers)
+        const prv_curl_req_buffer_t* request_body,
+        struct curl_slist** request_headers,
+        prv_curl_resp_buffer_t* response_body,
+        prv_kii_resp_headers_t* response_headers,
+        const kii_http_sink_t* response_sink)
 {
     M_KII_ASSERT(curl != NULL);
     M_KII_ASSERT(url != NULL);
-    M_KII_ASSERT(request_headers != NULL);
-    M_KII_ASSERT(response_status_code != NULL);
+    M_KII_ASSERT(*request_headers != NULL);
 
     M_KII_DEBUG(prv_log("request url: %s", url));
     M_KII_DEBUG(prv_log("request method: %d", method));
-    M_KII_DEBUG(prv_log("request body: %s", request_body));
+    M_KII_DEBUG(prv_log("request body length: %lu",
+                (unsigned long)request_body->length));
 
-    curl_error_code = CURLE_COULDNT_CONNECT; /* set error code as default. */
-
-    /* reset previous session setting. */
+    /* reset previous session setting.
+     * live connections of the handle are kept. */
     curl_easy_reset(curl);
+    curl_easy_setopt(curl, CURLOPT_SSL_OPTIONS, (long)KII_CURL_SSL_OPTIONS);
 
     switch (method) {
         case POST:
-            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request_body);
-            if (request_body == NULL || kii_strlen(request_body) == 0) {
-                curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, 0);
-            }
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request_body->data);
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE,
+                    (long)request_body->length);
             break;
         case PUT:
             curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
-            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request_body);
-            if (request_body == NULL || kii_strlen(request_body) == 0) {
-                curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, 0);
-            }
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request_body->data);
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE,
+                    (long)request_body->length);
             break;
         case PATCH:
-            request_headers = curl_slist_append(request_headers,
-                    "X-HTTP-METHOD-OVERRIDE: PATCH");
-            if (request_headers == NULL) {
+            if (prv_append_header(request_headers,
+                        "X-HTTP-METHOD-OVERRIDE: PATCH") != AEC_OK) {
                 return AEC_LOWMEMORY;
             }
-            if (request_body != NULL) {
-                curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request_body);
+            if (request_body->data != NULL) {
+                curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request_body->data);
+                curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE,
+                        (long)request_body->length);
             }
             break;
         case DELETE:
-            M_KII_ASSERT(request_body == NULL);
+            M_KII_ASSERT(request_body->data == NULL);
             curl_easy_setopt(curl,CURLOPT_CUSTOMREQUEST,"DELETE");
             break;
         case GET:
             curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
-            if (request_body != NULL) {
-                curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request_body);
+            if (request_body->data != NULL) {
+                curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request_body->data);
+                curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE,
+                        (long)request_body->length);
             }
             break;
         case HEAD:
-            M_KII_ASSERT(request_body == NULL);
+            M_KII_ASSERT(request_body->data == NULL);
             curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "HEAD");
             curl_easy_setopt(curl, CURLOPT_NOBODY, 1);
             break;
@@ -232,25 +719,100 @@ static adapter_error_code_t prv_execute_curl(CURL* curl,
             M_KII_ASSERT(0); /* programing error */
             return AEC_FAIL;
     }
+    if (request_body->content_encoding != NULL) {
+        kii_char_t header[64];
+        sprintf(header, "Content-Encoding: %.32s",
+                request_body->content_encoding);
+        if (prv_append_header(request_headers, header) != AEC_OK) {
+            return AEC_LOWMEMORY;
+        }
+    }
+    if (transport_profile != KII_TRANSPORT_DEFAULT &&
+            prv_setup_low_latency(curl, method, request_body,
+                request_headers) != AEC_OK) {
+        return AEC_LOWMEMORY;
+    }
 
-    M_KII_DEBUG(prv_log_req_heder(request_headers));
+    M_KII_DEBUG(prv_log_req_heder(*request_headers));
 
     curl_easy_setopt(curl, CURLOPT_URL, url);
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, request_headers);
+    curl_easy_setopt(curl, CURLOPT_SHARE, curl_share);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, connect_timeout_ms);
+    if (response_compression == KII_TRUE) {
+        /* empty string means all encodings supported by the libcurl. */
+        curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+    }
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, *request_headers);
     curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, callbackWrite);
+    prv_curl_resp_buffer_init(response_body, curl, response_sink);
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, response_body);
     if (response_headers != NULL) {
         curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, callback_header);
-        *response_headers = NULL;
+        prv_init_resp_headers(response_headers);
         curl_easy_setopt(curl, CURLOPT_HEADERDATA, response_headers);
     }
+    return AEC_OK;
+}
+
+/* Count sizes of body before and after decompression by curl. */
+static void prv_curl_count_compression(
+        CURL* curl,
+        const prv_curl_resp_buffer_t* buffer,
+        const prv_kii_resp_headers_t* response_headers)
+{
+#if LIBCURL_VERSION_NUM >= 0x073700
+    curl_off_t downloaded = 0;
+    if (curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &downloaded)
+            != CURLE_OK) {
+        return;
+    }
+#else
+    double downloaded = 0;
+    if (curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD, &downloaded)
+            != CURLE_OK) {
+        return;
+    }
+#endif
+    if (response_compression == KII_FALSE || response_headers == NULL ||
+            response_headers->content_encoding[0] == '\0') {
+        return;
+    }
+    pthread_mutex_lock(&compression_stats_mutex);
+    compressed_bytes += (kii_ulong_t)downloaded;
+    decompressed_bytes += (kii_ulong_t)buffer->received;
+    pthread_mutex_unlock(&compression_stats_mutex);
+}
+
+static adapter_error_code_t prv_execute_curl(CURL* curl,
+        const kii_char_t* url,
+        prv_kii_req_method_t method,
+        const prv_curl_req_buffer_t* request_body,
+        struct curl_slist** request_headers,
+        long* response_status_code,
+        kii_char_t** response_body,
+        prv_kii_resp_headers_t* response_headers,
+        const kii_http_sink_t* response_sink)
+{
+    adapter_error_code_t ret = AEC_FAIL;
+    prv_curl_resp_buffer_t buffer;
+    CURLcode curlRet = CURLE_COULDNT_CONNECT;
+
+    M_KII_ASSERT(response_status_code != NULL);
+
+    ret = prv_setup_curl(curl, url, method, request_body, request_headers,
+            &buffer, response_headers, response_sink);
+    if (ret != AEC_OK) {
+        return ret;
+    }
 
-    curl_error_code = curl_easy_perform(curl);
-    switch (curl_error_code) {
+    curlRet = curl_easy_perform(curl);
+    *response_body = buffer.data;
+    switch (curlRet) {
         case CURLE_OK:
             M_KII_DEBUG(prv_log("response: %s", *response_body));
             curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE,
                     response_status_code);
+            prv_curl_count_compression(curl, &buffer, response_headers);
             return AEC_OK;
         default:
             return AEC_CURL;
@@ -259,64 +821,358 @@ static adapter_error_code_t prv_execute_curl(CURL* curl,
 
 kii_bool_t kii_http_init(void)
 {
+    kii_bool_t ret = KII_FALSE;
     CURLcode r = curl_global_init(CURL_GLOBAL_ALL);
-    return ((r == CURLE_OK) ? KII_TRUE : KII_FALSE);
+    if (r != CURLE_OK) {
+        return KII_FALSE;
+    }
+    if (curl_share == NULL && prv_curl_share_init() == KII_FALSE) {
+        curl_global_cleanup();
+        return KII_FALSE;
+    }
+    pthread_mutex_lock(&curl_pool.mutex);
+    curl_pool.idle_timeout = KII_CURL_POOL_DEFAULT_IDLE_TIMEOUT;
+    ret = prv_curl_pool_resize(KII_CURL_POOL_DEFAULT_SIZE);
+    pthread_mutex_unlock(&curl_pool.mutex);
+    return ret;
 }
 
 void kii_http_cleanup(void)
 {
+    pthread_mutex_lock(&curl_pool.mutex);
+    prv_curl_pool_clear();
+    pthread_mutex_unlock(&curl_pool.mutex);
+    prv_curl_share_cleanup();
     curl_global_cleanup();
 }
 
+kii_bool_t kii_http_set_connection_pool(
+        kii_uint_t max_connections,
+        kii_uint_t idle_timeout_in_second)
+{
+    kii_bool_t ret = KII_FALSE;
+    pthread_mutex_lock(&curl_pool.mutex);
+    curl_pool.idle_timeout = idle_timeout_in_second;
+    ret = prv_curl_pool_resize(max_connections);
+    pthread_mutex_unlock(&curl_pool.mutex);
+    return ret;
+}
+
+kii_bool_t kii_http_set_connect_timeout(
+        kii_uint_t timeout_in_millis)
+{
+    connect_timeout_ms = (long)timeout_in_millis;
+    return KII_TRUE;
+}
+
+kii_bool_t kii_http_set_response_compression(kii_bool_t enabled)
+{
+    response_compression = enabled;
+    return KII_TRUE;
+}
+
+void kii_http_get_compression_stats(
+        kii_ulong_t* compressed,
+        kii_ulong_t* decompressed)
+{
+    pthread_mutex_lock(&compression_stats_mutex);
+    *compressed = compressed_bytes;
+    *decompressed = decompressed_bytes;
+    pthread_mutex_unlock(&compression_stats_mutex);
+}
+
+kii_bool_t kii_http_set_transport_profile(kii_transport_profile_t profile)
+{
+    transport_profile = profile;
+    return KII_TRUE;
+}
+
+kii_bool_t kii_http_set_http2_multiplexing(kii_uint_t max_concurrent_streams)
+{
+#if LIBCURL_VERSION_NUM >= 0x074300
+    curl_version_info_data* info = curl_version_info(CURLVERSION_NOW);
+    if (max_concurrent_streams > 0 &&
+            (info->features & CURL_VERSION_HTTP2) == 0) {
+        /* libcurl is built without nghttp2. */
+        return KII_FALSE;
+    }
+    if (max_concurrent_streams > 0 && info->version_num < 0x074300) {
+        /* linked libcurl can't limit concurrent streams. */
+        return KII_FALSE;
+    }
+    http2_max_streams = max_concurrent_streams;
+    return KII_TRUE;
+#else
+    /* CURLMOPT_MAX_CONCURRENT_STREAMS is available since 7.67.0. */
+    return (max_concurrent_streams == 0) ? KII_TRUE : KII_FALSE;
+#endif
+}
+
 kii_bool_t kii_http_execute(
         const kii_char_t* http_method,
         const kii_char_t* url,
-        json_t* request_headers,
-        const kii_char_t* request_body,
+        const kii_http_headers_t* request_headers,
+        const kii_http_body_t* request_body,
         kii_int_t* status_code,
-        json_t** response_headers,
+        prv_kii_resp_headers_t* response_headers,
+        const kii_http_sink_t* response_sink,
         kii_char_t** response_body)
 {
     adapter_error_code_t ret = AEC_FAIL;
     prv_kii_req_method_t method;
-    struct curl_slist* headers = NULL;
+    prv_curl_headers_t headers;
+    prv_curl_req_buffer_t body;
     long http_status = 0;
     CURL* curl = NULL;
 
-    if (kii_strncmp(http_method, "DELETE", kii_strlen("DELETE")) == 0) {
-        method = DELETE;
-    } else if (kii_strncmp(http_method, "GET", kii_strlen("GET")) == 0) {
-        method = GET;
-    } else if (kii_strncmp(http_method, "HEAD", kii_strlen("HEAD")) == 0) {
-        method = HEAD;
-    } else if (kii_strncmp(http_method, "PATCH", kii_strlen("PATCH")) == 0) {
-        method = PATCH;
-    } else if (kii_strncmp(http_method, "POST", kii_strlen("POST")) == 0) {
-        method = POST;
-    } else if (kii_strncmp(http_method, "PUT", kii_strlen("PUT")) == 0) {
-        method = PUT;
-    } else {
+    headers.count = 0;
+    headers.list = NULL;
+    ret = prv_curl_req_buffer_produce(&body, request_body);
+    if (ret != AEC_OK) {
+        goto ON_EXIT;
+    }
+
+    if (prv_parse_method(http_method, &method) == KII_FALSE) {
         ret = AEC_FAIL;
         goto ON_EXIT;
     }
 
-    headers = convert_request_headers(request_headers);
-    if (headers == NULL) {
-        ret = AEC_LOWMEMORY;
+    ret = prv_link_request_headers(&headers, request_headers);
+    if (ret != AEC_OK) {
         goto ON_EXIT;
     }
 
-    curl = curl_easy_init();
+    curl = prv_curl_pool_acquire(url);
+    if (curl == NULL) {
+        ret = AEC_LOWMEMORY;
+        goto ON_EXIT;
+    }
 
-    ret = prv_execute_curl(curl, url, method, request_body, headers,
-            &http_status, response_body, response_headers);
+    ret = prv_execute_curl(curl, url, method, &body, &headers.list,
+            &http_status, response_body, response_headers, response_sink);
     *status_code = (kii_int_t)http_status;
 
 ON_EXIT:
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
+    prv_free_request_headers(&headers);
+    prv_curl_pool_release(curl);
+    prv_curl_req_buffer_dispose(&body);
 
-    adapter_error_code = ret;
     return (ret == AEC_OK) ? KII_TRUE : KII_FALSE;
 }
 
+
+/* Request executed by curl multi interface. */
+typedef struct prv_curl_async_req_t {
+    CURL* curl;
+    prv_curl_headers_t headers; /* referred by curl until done. */
+    prv_curl_req_buffer_t request_body; /* referred by curl until done. */
+    prv_curl_resp_buffer_t response_body;
+    prv_kii_resp_headers_t response_headers;
+    kii_http_completion_t completion;
+    void* userdata;
+    struct prv_curl_async_req_t* prev;
+    struct prv_curl_async_req_t* next;
+} prv_curl_async_req_t;
+
+typedef struct prv_kii_http_async_t {
+    CURLM* multi;
+    prv_curl_async_req_t* requests;
+    kii_uint_t count;
+    kii_uint_t http2_max_streams; /* applied to multi. */
+} prv_kii_http_async_t;
+
+static void prv_curl_async_unlink(
+        prv_kii_http_async_t* async,
+        prv_curl_async_req_t* req)
+{
+    if (req->prev != NULL) {
+        req->prev->next = req->next;
+    } else {
+        async->requests = req->next;
+    }
+    if (req->next != NULL) {
+        req->next->prev = req->prev;
+    }
+    --(async->count);
+}
+
+static void prv_curl_async_finish(
+        prv_kii_http_async_t* async,
+        prv_curl_async_req_t* req,
+        kii_bool_t succeeded)
+{
+    long http_status = 0;
+
+    if (succeeded == KII_TRUE) {
+        M_KII_DEBUG(prv_log("response: %s", req->response_body.data));
+        curl_easy_getinfo(req->curl, CURLINFO_RESPONSE_CODE, &http_status);
+        prv_curl_count_compression(req->curl, &req->response_body,
+                &req->response_headers);
+    }
+    curl_multi_remove_handle(async->multi, req->curl);
+    prv_curl_async_unlink(async, req);
+
+    req->completion(succeeded, (kii_int_t)http_status, &req->response_headers,
+            req->response_body.data, req->userdata);
+
+    curl_easy_cleanup(req->curl);
+    prv_free_request_headers(&req->headers);
+    prv_curl_req_buffer_dispose(&req->request_body);
+    M_KII_FREE_NULLIFY(req->response_body.data);
+    M_KII_FREE_NULLIFY(req);
+}
+
+kii_http_async_t kii_http_async_init(void)
+{
+    prv_kii_http_async_t* async = kii_malloc(sizeof(prv_kii_http_async_t));
+    if (async == NULL) {
+        return NULL;
+    }
+    async->multi = curl_multi_init();
+    if (async->multi == NULL) {
+        M_KII_FREE_NULLIFY(async);
+        return NULL;
+    }
+    async->requests = NULL;
+    async->count = 0;
+    async->http2_max_streams = 0;
+    return async;
+}
+
+/* Requests of async are multiplexed over single connection per host if
+ * HTTP/2 is enabled. Requests exceeding max streams wait in curl until
+ * preceding ones complete. */
+static void prv_curl_async_apply_http2(
+        prv_kii_http_async_t* async,
+        CURL* curl)
+{
+#if LIBCURL_VERSION_NUM >= 0x072F00
+    if (async->http2_max_streams != http2_max_streams) {
+        async->http2_max_streams = http2_max_streams;
+        curl_multi_setopt(async->multi, CURLMOPT_PIPELINING,
+                (http2_max_streams > 0) ?
+                (long)CURLPIPE_MULTIPLEX : (long)CURLPIPE_NOTHING);
+        curl_multi_setopt(async->multi, CURLMOPT_MAX_HOST_CONNECTIONS,
+                (http2_max_streams > 0) ? 1L : 0L);
+#if LIBCURL_VERSION_NUM >= 0x074300
+        curl_multi_setopt(async->multi, CURLMOPT_MAX_CONCURRENT_STREAMS,
+                (http2_max_streams > 0) ? (long)http2_max_streams : 100L);
+#endif
+    }
+    if (http2_max_streams > 0) {
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+        /* wait for connection in progress rather than opening another one,
+         * so that following requests are multiplexed on it. */
+        curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+    }
+#else
+    (void)async;
+    (void)curl;
+#endif
+}
+
+void kii_http_async_cleanup(kii_http_async_t async)
+{
+    if (async == NULL) {
+        return;
+    }
+    while (async->requests != NULL) {
+        prv_curl_async_finish(async, async->requests, KII_FALSE);
+    }
+    curl_multi_cleanup(async->multi);
+    M_KII_FREE_NULLIFY(async);
+}
+
+kii_bool_t kii_http_async_execute(
+        kii_http_async_t async,
+        const kii_char_t* http_method,
+        const kii_char_t* url,
+        const kii_http_headers_t* request_headers,
+        const kii_http_body_t* request_body,
+        const kii_http_sink_t* response_sink,
+        kii_http_completion_t completion,
+        void* userdata)
+{
+    prv_kii_req_method_t method;
+    prv_curl_async_req_t* req = NULL;
+
+    M_KII_ASSERT(async != NULL);
+    M_KII_ASSERT(completion != NULL);
+
+    if (prv_parse_method(http_method, &method) == KII_FALSE) {
+        return KII_FALSE;
+    }
+
+    req = kii_malloc(sizeof(prv_curl_async_req_t));
+    if (req == NULL) {
+        return KII_FALSE;
+    }
+    kii_memset(req, 0, sizeof(prv_curl_async_req_t));
+    req->completion = completion;
+    req->userdata = userdata;
+
+    req->curl = curl_easy_init();
+    if (req->curl == NULL ||
+            prv_link_request_headers(&req->headers, request_headers)
+            != AEC_OK) {
+        goto ON_ERROR;
+    }
+    if (prv_curl_req_buffer_produce(&req->request_body, request_body)
+            != AEC_OK) {
+        goto ON_ERROR;
+    }
+    if (prv_setup_curl(req->curl, url, method, &req->request_body,
+                &req->headers.list, &req->response_body,
+                &req->response_headers, response_sink) != AEC_OK) {
+        goto ON_ERROR;
+    }
+    prv_curl_async_apply_http2(async, req->curl);
+    curl_easy_setopt(req->curl, CURLOPT_PRIVATE, req);
+    if (curl_multi_add_handle(async->multi, req->curl) != CURLM_OK) {
+        goto ON_ERROR;
+    }
+
+    req->next = async->requests;
+    if (async->requests != NULL) {
+        async->requests->prev = req;
+    }
+    async->requests = req;
+    ++(async->count);
+    return KII_TRUE;
+
+ON_ERROR:
+    curl_easy_cleanup(req->curl);
+    prv_free_request_headers(&req->headers);
+    prv_curl_req_buffer_dispose(&req->request_body);
+    M_KII_FREE_NULLIFY(req);
+    return KII_FALSE;
+}
+
+kii_uint_t kii_http_async_poll(kii_http_async_t async, kii_int_t timeout_in_ms)
+{
+    int running = 0;
+    int left = 0;
+    CURLMsg* msg = NULL;
+
+    M_KII_ASSERT(async != NULL);
+
+    curl_multi_perform(async->multi, &running);
+    if (running > 0 && timeout_in_ms > 0) {
+        int numfds = 0;
+        curl_multi_wait(async->multi, NULL, 0, timeout_in_ms, &numfds);
+        curl_multi_perform(async->multi, &running);
+    }
+
+    while ((msg = curl_multi_info_read(async->multi, &left)) != NULL) {
+        prv_curl_async_req_t* req = NULL;
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char**)&req);
+        M_KII_ASSERT(req != NULL);
+        prv_curl_async_finish(async, req,
+                (msg->data.result == CURLE_OK) ? KII_TRUE : KII_FALSE);
+    }
+
+    return async->count;
+}
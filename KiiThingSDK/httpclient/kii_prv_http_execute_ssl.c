@@ -5,29 +5,55 @@
 
 #include <assert.h>
 #include <ctype.h>
+#include <errno.h>
+#include <limits.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 
 /* for UNIX like systems */
 #include <unistd.h>
+#include <fcntl.h>
 #include <netdb.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
+#include <pthread.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <time.h>
 /* Use OpenSSL */
 #include <openssl/crypto.h>
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 #include <openssl/rand.h>
+/* Use zlib to decompress response */
+#include <zlib.h>
 
 #define SOCKET_CLOSE(s) close(s)
 #define HTTP_CONFIG_DEFAULTPORT 80
+#define HTTP_CONFIG_DEFAULTSSLPORT 443
 #define HTTP_CONFIG_URLMAXPATH 256
-#define HTTP_EXCONFIG_PRINTBUFFER 1024 /* affect to stack size */
+#define HTTP_EXCONFIG_PRINTBUFFER 1024 /* initial size of write buffer */
+#define HTTP_EXCONFIG_COALESCEBODYSIZE (16 * 1024) /* one TLS record */
+/* body larger than HTTP_EXCONFIG_COALESCEBODYSIZE is sent in chunks. */
 #define HTTP_EXCONFIG_HEADERMAXCOUNT 1024
-#define HTTP_EXCONFIG_HEADERLINEBLOCKSIZE 256
+#define HTTP_EXCONFIG_READBUFFERSIZE (16 * 1024) /* per connection */
+#define HTTP_EXCONFIG_BODYMAXPRESIZE (4 * HTTP_EXCONFIG_READBUFFERSIZE)
+/* body buffer is reserved up to HTTP_EXCONFIG_BODYMAXPRESIZE from
+ * Content-Length, and grows as body is received beyond it. */
+#define HTTP_EXCONFIG_READTIMEOUT 60 /* in seconds */
+#define HTTP_EXCONFIG_SESSIONCACHESIZE 4
+#define HTTP_EXCONFIG_POOLSIZE 4 /* max idle connections */
+#define HTTP_EXCONFIG_POOLIDLETIMEOUT 60 /* in seconds */
+#define HTTP_EXCONFIG_CONNECTTIMEOUT 30000 /* in milliseconds */
+#define HTTP_EXCONFIG_CONNECTATTEMPTDELAY 250 /* in milliseconds */
+#define HTTP_EXCONFIG_CONNECTMAXADDRS 8 /* addresses tried per connect */
+#define HTTP_EXCONFIG_ASYNCMAXEVENTS 64 /* events handled per poll */
+#define HTTP_EXCONFIG_INFLATEBUFFERSIZE 4096 /* decompressed at once */
 
 typedef enum {
     HTTP_RESULT_OK = 0,
@@ -37,6 +63,7 @@ typedef enum {
     HTTP_RESULT_ERROR_URLSYNTAX,
     HTTP_RESULT_ERROR_INTERNAL,
     HTTP_RESULT_ERROR_CONNECTSSLSERVER,
+    HTTP_RESULT_ERROR_SENDING,
     HTTP_RESULT_ERROR_UNKNOWN
 } http_result_t;
 
@@ -46,21 +73,117 @@ typedef struct {
     kii_char_t path[HTTP_CONFIG_URLMAXPATH];
 } http_url_t;
 
-static http_result_t http_error_code;
+/* Buffer of data received from ssl connection.
+ * Data from begin to end is not consumed yet. */
+typedef struct {
+    SSL* ssl;
+    kii_int_t begin;
+    kii_int_t end;
+    kii_char_t data[HTTP_EXCONFIG_READBUFFERSIZE];
+} ssl_reader_t;
 
-static kii_char_t*
-skip_spaces(kii_char_t* line)
-{
-    int i = 0;
-    for (i = 0; line[i] != '\0'; ++i)
-    {
-        if (line[i] != ' ')
-        {
-            break;
-        }
-    }
-    return &line[i];
-}
+/* Buffer of request sent to ssl connection at once.
+ * Kept by connection to be reused by following requests. */
+typedef struct {
+    SSL* ssl;
+    kii_char_t* data;
+    kii_int_t length;
+    kii_int_t capacity;
+    /* handshake is deferred to send first data as TLS 1.3 early data. */
+    kii_int_t early_data;
+} ssl_writer_t;
+
+/* Receive state of a response. */
+typedef enum {
+    SSL_RESP_STATUS,
+    SSL_RESP_HEADER,
+    SSL_RESP_BODY, /* delimited by Content-Length */
+    SSL_RESP_CHUNK_SIZE,
+    SSL_RESP_CHUNK_DATA,
+    SSL_RESP_CHUNK_END,
+    SSL_RESP_TRAILER,
+    SSL_RESP_UNTIL_CLOSE, /* delimited by close of connection */
+    SSL_RESP_DONE
+} ssl_resp_state_t;
+
+/* Response parsed incrementally as data is received.
+ * Used by both of blocking and event driven requests. */
+typedef struct {
+    ssl_resp_state_t state;
+    const kii_char_t* method;
+    kii_int_t status;
+    prv_kii_resp_headers_t headers;
+    kii_int_t lines; /* received in current state */
+    kii_char_t* body;
+    kii_int_t bodylen;
+    kii_int_t capacity;
+    long remaining; /* of body or current chunk */
+    kii_int_t keep_alive;
+    const kii_http_sink_t* sink; /* NULL unless body is passed to it */
+    kii_int_t compressed; /* by Content-Encoding gzip or deflate */
+    kii_int_t inflating; /* inflater is initialized */
+    kii_int_t inflated; /* end of compressed stream is reached */
+    z_stream inflater;
+} ssl_response_t;
+
+/* Connection kept alive for following requests to the same host. */
+typedef struct {
+    kii_char_t host[256];
+    kii_int_t port;
+    kii_int_t sock;
+    time_t last_used;
+    ssl_reader_t reader; /* reader.ssl is ssl of this connection. */
+    ssl_writer_t writer; /* writer.ssl is the same as reader.ssl. */
+} ssl_connection_t;
+
+/* Idle connections. In-use connections are not held by the pool. */
+typedef struct {
+    pthread_mutex_t mutex;
+    ssl_connection_t** idles;
+    kii_uint_t size;
+    kii_uint_t idle_timeout;
+} ssl_pool_t;
+
+/* Shared by all connections. Created by kii_http_init. */
+static SSL_CTX* ssl_ctx = NULL;
+
+/* Writing to connection reset by server, such as pooled connection closed
+ * while it is idle, must not raise SIGPIPE which kills the process.
+ * Socket is made not to raise it if the platform has SO_NOSIGPIPE.
+ * Otherwise ssl sends by BIO using MSG_NOSIGNAL. If neither is available,
+ * application must ignore SIGPIPE. */
+#if !defined(SO_NOSIGPIPE) && defined(MSG_NOSIGNAL) && \
+    OPENSSL_VERSION_NUMBER >= 0x10100000L
+#define HTTP_SSL_NOSIGNAL_BIO
+/* Shared by all connections. Created by kii_http_init. */
+static BIO_METHOD* ssl_bio_method = NULL;
+#endif
+
+typedef struct {
+    kii_char_t host[256];
+    kii_int_t port;
+    SSL_SESSION* session;
+} ssl_session_entry_t;
+
+static ssl_session_entry_t ssl_sessions[HTTP_EXCONFIG_SESSIONCACHESIZE];
+static kii_int_t ssl_sessions_next = 0;
+static pthread_mutex_t ssl_sessions_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static kii_uint_t connect_timeout = HTTP_EXCONFIG_CONNECTTIMEOUT;
+static kii_transport_profile_t transport_profile = KII_TRANSPORT_DEFAULT;
+
+/* Accept-Encoding is sent if response compression is enabled. */
+static kii_int_t response_compression = 0;
+static pthread_mutex_t compression_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static kii_ulong_t compressed_bytes = 0;
+static kii_ulong_t decompressed_bytes = 0;
+
+static ssl_pool_t ssl_pool = {
+    PTHREAD_MUTEX_INITIALIZER,
+    NULL,
+    0,
+    HTTP_EXCONFIG_POOLIDLETIMEOUT
+};
 
 static kii_int_t
 parse_url(
@@ -74,6 +197,7 @@ parse_url(
     const kii_char_t* end2 = NULL;
     const kii_char_t* top3 = NULL;
     const kii_char_t* end3 = NULL;
+    kii_int_t default_port = HTTP_CONFIG_DEFAULTPORT;
     if (str == NULL)
         return 0; /* invalid URL string */
     end = str + strlen(str);
@@ -82,7 +206,10 @@ parse_url(
     if (strncmp(str, "http://", 7) == 0)
         top1 = &str[7];
     else if (strncmp(str, "https://", 8) == 0)
+    {
         top1 = &str[8];
+        default_port = HTTP_CONFIG_DEFAULTSSLPORT;
+    }
     if (top1 == NULL)
         return 0; /* unsupported schema */
     /* search end of HOST and PORT (end2) */
@@ -111,7 +238,7 @@ parse_url(
         return 0; /* too long PATH */
     /* copy to output */
     strncpy(url->host, top1, end1 - top1);
-    url->port = top2 ? atoi(top2) : HTTP_CONFIG_DEFAULTPORT;
+    url->port = top2 ? atoi(top2) : default_port;
     if (top3)
         strncpy(url->path, top3, end3 - top3);
     else
@@ -126,99 +253,396 @@ socket_close(
     SOCKET_CLOSE(sock);
 }
 
+/* Monotonic clock in milliseconds. */
+static long
+clock_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+/* Switch blocking mode of socket. Returns 0 on error. */
+static kii_int_t
+socket_set_blocking(
+        kii_int_t sock,
+        kii_int_t blocking)
+{
+    kii_int_t flags = fcntl(sock, F_GETFL, 0);
+    if (flags == -1)
+        return 0;
+    flags = blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK);
+    return (fcntl(sock, F_SETFL, flags) != -1);
+}
+
+/* Resolve hostname to IPv4 and IPv6 addresses.
+ * *result must be freed by freeaddrinfo. Returns 0 on error. */
+static kii_int_t
+socket_resolve(
+        const http_url_t* url,
+        struct addrinfo** result)
+{
+    struct addrinfo hints;
+    kii_char_t service[8];
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICSERV;
+    snprintf(service, sizeof(service), "%d", url->port);
+    *result = NULL;
+    return (getaddrinfo(url->host, service, &hints, result) == 0);
+}
+
+/* Options of low latency transport profiles.
+ * Errors are ignored since kernel may not support them. */
+static void
+socket_set_low_latency(
+        kii_int_t sock)
+{
+    int on = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+#ifdef TCP_FASTOPEN_CONNECT
+    /* ClientHello is sent with SYN if server has issued TFO cookie.
+     * connect completes immediately in that case. */
+    setsockopt(sock, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &on, sizeof(on));
+#endif
+}
+
+/* Start non-blocking connect.
+ * Returns socket connecting or connected, or -1 on error.
+ * *connected is set if connect completed immediately. */
+static kii_int_t
+socket_start_connect(
+        const struct addrinfo* ai,
+        kii_int_t* connected)
+{
+    kii_int_t sock;
+    *connected = 0;
+    sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (sock == -1)
+        return -1;
+    if (!socket_set_blocking(sock, 0))
+    {
+        socket_close(sock);
+        return -1;
+    }
+#ifdef SO_NOSIGPIPE
+    {
+        int on = 1;
+        setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+    }
+#endif
+    if (transport_profile != KII_TRANSPORT_DEFAULT)
+        socket_set_low_latency(sock);
+    if (connect(sock, ai->ai_addr, ai->ai_addrlen) == 0)
+        *connected = 1;
+    else if (errno != EINPROGRESS)
+    {
+        socket_close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+/* Order addresses so that address families alternate,
+ * starting with the family preferred by resolver. */
+static kii_int_t
+socket_sort_addresses(
+        struct addrinfo* result,
+        struct addrinfo** addrs,
+        kii_int_t max)
+{
+    struct addrinfo* preferred = result;
+    struct addrinfo* others = result;
+    kii_int_t family;
+    kii_int_t count = 0;
+    kii_int_t turn = 0;
+    if (result == NULL)
+        return 0;
+    family = result->ai_family;
+    while (count < max)
+    {
+        while (preferred != NULL && preferred->ai_family != family)
+            preferred = preferred->ai_next;
+        while (others != NULL && others->ai_family == family)
+            others = others->ai_next;
+        if (preferred == NULL && others == NULL)
+            break;
+        if ((turn == 0 && preferred != NULL) || others == NULL)
+        {
+            addrs[count++] = preferred;
+            preferred = preferred->ai_next;
+        }
+        else
+        {
+            addrs[count++] = others;
+            others = others->ai_next;
+        }
+        turn = !turn;
+    }
+    return count;
+}
+
+/* Connect to host by racing its addresses (Happy Eyeballs).
+ * A new attempt starts each HTTP_EXCONFIG_CONNECTATTEMPTDELAY or as soon as
+ * an attempt fails, and the first established connection wins.
+ * Whole attempts are bounded by connect_timeout. */
 static kii_int_t
 socket_connect(
         const http_url_t* url)
 {
     kii_int_t sock = -1;
-    struct hostent* entry;
-    in_addr_t address;
-    struct in_addr** p_addr;
-    struct sockaddr_in addr;
-    struct servent* service;
-    /* convert hostname to IP address */
-    if ((entry = gethostbyname(url->host)) != NULL)
-        address = (in_addr_t)entry->h_addr;
-    else if ((address = inet_addr(url->host)) == INADDR_NONE)
-    {
-        sock = -2;
-        goto END_FUNC;
-    }
-    service = getservbyname("https", "tcp");
-    /* create and connect socket to host */
-    for (p_addr = (struct in_addr**)entry->h_addr_list;
-            *p_addr != NULL; ++p_addr)
-    {
-        /* create socket */
-        sock = socket(PF_INET, SOCK_STREAM, 0);
-        if (sock == -1)
-            goto END_FUNC;
-        /* connect socket to host */
-        memset(&addr, 0, sizeof(addr));
-        addr.sin_family = AF_INET;
-        if (service != NULL)
+    struct addrinfo* result = NULL;
+    struct addrinfo* addrs[HTTP_EXCONFIG_CONNECTMAXADDRS];
+    struct pollfd fds[HTTP_EXCONFIG_CONNECTMAXADDRS];
+    kii_int_t naddrs;
+    kii_int_t nfds = 0;
+    kii_int_t next = 0;
+    long now;
+    long deadline;
+    long next_attempt;
+    kii_int_t i;
+
+    if (!socket_resolve(url, &result))
+        return -2;
+    naddrs = socket_sort_addresses(result, addrs,
+            HTTP_EXCONFIG_CONNECTMAXADDRS);
+
+    now = clock_now_ms();
+    deadline = now + (long)connect_timeout;
+    next_attempt = now;
+    while (sock < 0)
+    {
+        kii_int_t timeout;
+        kii_int_t nready;
+        now = clock_now_ms();
+        if (now >= deadline)
+            break;
+        /* start next attempt */
+        if (next < naddrs && (nfds == 0 || now >= next_attempt))
         {
-            addr.sin_port = service->s_port;
-            //addr.sin_port = htons(443);
+            kii_int_t connected = 0;
+            kii_int_t s = socket_start_connect(addrs[next++], &connected);
+            next_attempt = now + HTTP_EXCONFIG_CONNECTATTEMPTDELAY;
+            if (connected)
+                sock = s;
+            else if (s >= 0)
+            {
+                fds[nfds].fd = s;
+                fds[nfds].events = POLLOUT;
+                fds[nfds].revents = 0;
+                ++nfds;
+            }
+            continue;
         }
-        else
+        if (nfds == 0)
+            break; /* all attempts failed */
+        /* wait for any attempt completes */
+        timeout = (kii_int_t)(deadline - now);
+        if (next < naddrs && next_attempt - now < timeout)
+            timeout = (kii_int_t)(next_attempt - now);
+        nready = poll(fds, nfds, timeout);
+        if (nready < 0 && errno != EINTR)
+            break;
+        for (i = 0; nready > 0 && i < nfds; ++i)
         {
-            addr.sin_port = htons((uint16_t)url->port);
+            int error = 0;
+            socklen_t errlen = sizeof(error);
+            if (fds[i].revents == 0)
+                continue;
+            if (getsockopt(fds[i].fd, SOL_SOCKET, SO_ERROR, &error,
+                        &errlen) == 0 && error == 0)
+            {
+                sock = fds[i].fd;
+                fds[i] = fds[--nfds];
+                break;
+            }
+            /* failed. start next attempt without waiting. */
+            socket_close(fds[i].fd);
+            fds[i] = fds[--nfds];
+            --i;
+            next_attempt = now;
         }
-        memcpy(&addr.sin_addr, *p_addr, sizeof(struct in_addr));
-        if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) != -1)
-            goto END_FUNC; /* success */
+    }
+    /* cancel attempts lost the race */
+    for (i = 0; i < nfds; ++i)
+        socket_close(fds[i].fd);
+    freeaddrinfo(result);
+    if (sock < 0)
+        return -3; /* error becase of host down or timeout */
+    /* following I/O is blocking with its own timeout. */
+    if (!socket_set_blocking(sock, 1))
+    {
         socket_close(sock);
-        sock = -1;
+        return -1;
     }
-    sock = -3; /* error becase of host down */
-END_FUNC:
     return sock;
 }
 
-static void
-ssl_write(
-        SSL* ssl,
+/* Reserve free space of write buffer at least len bytes. */
+static kii_int_t
+ssl_writer_reserve(
+        ssl_writer_t* writer,
+        kii_int_t len)
+{
+    kii_char_t* newdata;
+    kii_int_t newcapacity = (writer->capacity > 0) ?
+        writer->capacity : HTTP_EXCONFIG_PRINTBUFFER;
+    if (writer->length + len <= writer->capacity)
+        return 1;
+    while (newcapacity < writer->length + len)
+        newcapacity *= 2;
+    newdata = kii_realloc(writer->data, newcapacity);
+    if (newdata == NULL)
+        return 0;
+    writer->data = newdata;
+    writer->capacity = newcapacity;
+    return 1;
+}
+
+static kii_int_t
+ssl_writer_append(
+        ssl_writer_t* writer,
+        const kii_char_t* ptr,
+        kii_int_t len)
+{
+    if (!ssl_writer_reserve(writer, len))
+        return 0;
+    memcpy(&writer->data[writer->length], ptr, len);
+    writer->length += len;
+    return 1;
+}
+
+/* Insert data at offset of write buffer. */
+static kii_int_t
+ssl_writer_insert(
+        ssl_writer_t* writer,
+        kii_int_t offset,
         const kii_char_t* ptr,
-        kii_int_t len,
-        kii_int_t binary)
+        kii_int_t len)
 {
-    SSL_write(ssl, ptr, len);
+    if (!ssl_writer_reserve(writer, len))
+        return 0;
+    memmove(&writer->data[offset + len], &writer->data[offset],
+            writer->length - offset);
+    memcpy(&writer->data[offset], ptr, len);
+    writer->length += len;
+    return 1;
 }
 
 static kii_int_t
 ssl_reqhdr_printf(
-        SSL* ssl,
+        ssl_writer_t* writer,
         const kii_char_t* fmt,
         ...)
 {
     kii_int_t retval;
     va_list list;
-    kii_char_t buf[HTTP_EXCONFIG_PRINTBUFFER];
-    /* format message */
+    /* format message into free space. retry once if it is too small. */
     va_start(list, fmt);
-    retval = vsnprintf(buf, sizeof(buf), fmt, list);
+    retval = vsnprintf(&writer->data[writer->length],
+            writer->capacity - writer->length, fmt, list);
     va_end(list);
-    /* FIXME: compare retval with sizeof(buf) */
-    ssl_write(ssl, (kii_char_t*)buf, retval, 0);
+    if (retval < 0)
+        return 0;
+    if (retval >= writer->capacity - writer->length)
+    {
+        if (!ssl_writer_reserve(writer, retval + 1))
+            return 0;
+        va_start(list, fmt);
+        retval = vsnprintf(&writer->data[writer->length],
+                writer->capacity - writer->length, fmt, list);
+        va_end(list);
+    }
+    writer->length += retval;
+    return 1;
+}
+
+#ifdef TLS1_3_VERSION
+/* Send data in the write buffer as early data and finish handshake.
+ * Data is left in the buffer if it is too large or rejected by server. */
+static kii_int_t
+ssl_writer_send_early_data(ssl_writer_t* writer)
+{
+    SSL_SESSION* session = SSL_get_session(writer->ssl);
+    size_t written = 0;
+    writer->early_data = 0;
+    if (session != NULL && writer->length <=
+            (kii_int_t)SSL_SESSION_get_max_early_data(session))
+    {
+        if (SSL_write_early_data(writer->ssl, writer->data, writer->length,
+                    &written) != 1)
+            return 0;
+    }
+    if (SSL_connect(writer->ssl) != 1)
+        return 0;
+    M_KII_DEBUG(prv_log("ssl early data status: %d",
+                SSL_get_early_data_status(writer->ssl)));
+    if (written > 0 &&
+            SSL_get_early_data_status(writer->ssl) == SSL_EARLY_DATA_ACCEPTED)
+        writer->length = 0;
+    return 1;
+}
+#endif
+
+/* Send whole data in the write buffer and clear it. */
+static kii_int_t
+ssl_writer_flush(ssl_writer_t* writer)
+{
+    kii_int_t retval = 1;
+#ifdef TLS1_3_VERSION
+    if (writer->early_data && !ssl_writer_send_early_data(writer))
+    {
+        writer->length = 0;
+        return 0;
+    }
+#endif
+    if (writer->length > 0)
+        retval = (SSL_write(writer->ssl, writer->data, writer->length) > 0);
+    writer->length = 0;
     return retval;
 }
 
+/* Move unread data to the top of read buffer. */
+static void
+ssl_reader_compact(ssl_reader_t* reader)
+{
+    if (reader->begin > 0)
+    {
+        memmove(reader->data, &reader->data[reader->begin],
+                reader->end - reader->begin);
+        reader->end -= reader->begin;
+        reader->begin = 0;
+    }
+}
+
+/* Whether SSL_read failed since connection was reset by server. */
 static kii_int_t
-ssl_readbyte(SSL* ssl)
+ssl_connection_reset(SSL* ssl, kii_int_t ret)
 {
-    /* detect read timeout */
+    return SSL_get_error(ssl, ret) == SSL_ERROR_SYSCALL && errno == ECONNRESET;
+}
+
+/* Fill read buffer by a SSL_read as large as free space of the buffer.
+ * Read timeout is applied to each fill.
+ * Returns 0 if connection is closed by server, or -4 if it is reset. */
+static kii_int_t
+ssl_reader_fill(ssl_reader_t* reader)
+{
+    kii_int_t len;
+    ssl_reader_compact(reader);
+    if (reader->end >= HTTP_EXCONFIG_READBUFFERSIZE)
+        return -3; /* too small buffer */
+    /* detect read timeout. records already decrypted by OpenSSL are not
+     * visible to poll. */
+    if (SSL_pending(reader->ssl) == 0)
     {
-        fd_set fds;
-        kii_int_t sock;
-        struct timeval timeout;
+        struct pollfd pfd;
         kii_int_t nfds;
-        FD_ZERO(&fds);
-        sock = SSL_get_fd(ssl);
-        FD_SET(sock, &fds);
-        timeout.tv_sec = 60;
-        timeout.tv_usec = 0;
-        nfds = select(sock + 1, &fds, NULL, NULL, &timeout);
+        pfd.fd = SSL_get_fd(reader->ssl);
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        nfds = poll(&pfd, 1, HTTP_EXCONFIG_READTIMEOUT * 1000);
         if (nfds == 0)
         {
             return -1; /* timeout error */
@@ -226,410 +650,1748 @@ ssl_readbyte(SSL* ssl)
         else if (nfds != 1)
             return -2; /* system problem, must not reached */
     }
-    /* read a byte from socket */
-    {
-        uint8_t buf[1];
-        kii_int_t len;
-        len = SSL_read(ssl, buf, 1);
-        if (len != 1)
-        {
-            return -3; /* system problem, must not reached */
-        }
-        return buf[0];
-    }
+    len = SSL_read(reader->ssl, &reader->data[reader->end],
+            HTTP_EXCONFIG_READBUFFERSIZE - reader->end);
+    if (len == 0)
+        return 0; /* connection closed */
+    else if (len < 0 && ssl_connection_reset(reader->ssl, len))
+        return -4;
+    else if (len < 0)
+        return -3; /* read error */
+    reader->end += len;
+    return len;
 }
 
+/* Take a line from read buffer without reading ssl connection.
+ * Line is parsed in place. *bufptr points to the line in the read buffer
+ * which is valid until next fill. CRLF is replaced with NUL.
+ * Returns length of the line, -1 if whole line is not received yet or
+ * -2 if the line is longer than the buffer. */
 static kii_int_t
-ssl_resphdr_readline(
-        SSL* ssl,
+ssl_reader_getline(
+        ssl_reader_t* reader,
         kii_char_t** bufptr)
 {
-    kii_int_t retval = -3; /* means too small buffer */
-    kii_int_t index = 0;
-    kii_int_t buflen = HTTP_EXCONFIG_HEADERLINEBLOCKSIZE;
-    *bufptr = kii_malloc(sizeof(kii_char_t) * buflen);
-    memset(*bufptr, 0, sizeof(kii_char_t) * buflen);
-    while (1)
+    kii_char_t* line = &reader->data[reader->begin];
+    kii_char_t* lf = memchr(line, '\n', reader->end - reader->begin);
+    kii_int_t len;
+    *bufptr = NULL;
+    if (lf == NULL)
     {
-        kii_int_t d1;
-        kii_char_t d;
-        d1 = ssl_readbyte(ssl);
-        if (d1 < 0)
-        {
-            retval = d1;
-            break;
-        }
-
-        d = d1;
+        if (reader->begin == 0 && reader->end >= HTTP_EXCONFIG_READBUFFERSIZE)
+            return -2;
+        return -1;
+    }
+    len = (kii_int_t)(lf - line);
+    reader->begin += len + 1;
+    /* NOTE: single LF is accepted as line terminator. */
+    if (len > 0 && line[len - 1] == '\r')
+        --len;
+    line[len] = '\0';
+    *bufptr = line;
+    return len;
+}
 
-        if (d1 == '\n')
+/* Grow body buffer geometrically to hold required bytes.
+ * Fails if required bytes in addition to current length don't fit in
+ * kii_int_t. */
+static kii_int_t
+ssl_body_reserve(
+        kii_char_t** body,
+        kii_int_t* capacity,
+        kii_int_t length,
+        kii_int_t required)
+{
+    kii_char_t* newbody;
+    kii_int_t newcapacity =
+        (*capacity > 0) ? *capacity : HTTP_EXCONFIG_READBUFFERSIZE;
+    if (required < 0 || required > INT_MAX - length)
+        return 0;
+    required += length;
+    if (required <= *capacity)
+        return 1;
+    while (newcapacity < required)
+    {
+        if (newcapacity > INT_MAX / 2)
         {
-            /* NOTE: this is invaild sequence as a line */
-            retval = index;
+            newcapacity = required;
             break;
         }
-        else if (d1 == '\r')
-        {
-            kii_int_t d2;
-            d2 = ssl_readbyte(ssl);
-            if (d2 < 0)
-            {
-                retval = d2;
-                break;
-            }
-            d = d2;
-            if (d2 == '\n')
-            {
-                retval = index;
-                if (index + 1 < buflen)
-                {
-                    (*bufptr)[index + 1] = '\0';
-                }
-                else
-                {
-                    *bufptr = kii_realloc(*bufptr,
-                            sizeof(kii_char_t) * (buflen + 1));
-                    (*bufptr)[index + 1] = '\0';
-                }
-                break;
-            }
-            else if (index + 1 < buflen)
-            {
-                (*bufptr)[index++] = (kii_char_t)d1;
-                (*bufptr)[index++] = (kii_char_t)d2;
-            }
-            else
-            {
-                /* too small buffer */
-                buflen += HTTP_EXCONFIG_HEADERLINEBLOCKSIZE;
-                *bufptr = kii_realloc(*bufptr, sizeof(kii_char_t) * buflen);
-                (*bufptr)[index++] = (kii_char_t)d1;
-                (*bufptr)[index++] = (kii_char_t)d2;
-            }
-        }
-        else if (index < buflen)
-            (*bufptr)[index++] = (kii_char_t)d1;
-        else
-        {
-            /* too small buffer */
-            buflen += HTTP_EXCONFIG_HEADERLINEBLOCKSIZE;
-            *bufptr = kii_realloc(*bufptr, sizeof(kii_char_t) * buflen);
-            (*bufptr)[index++] = (kii_char_t)d1;
-        }
-    }
-    if (retval <= 0)
-    {
-        M_KII_FREE_NULLIFY(*bufptr);
-        *bufptr = NULL;
+        newcapacity *= 2;
     }
-    return retval;
+    newbody = kii_realloc(*body, newcapacity);
+    if (newbody == NULL)
+        return 0;
+    *body = newbody;
+    *capacity = newcapacity;
+    return 1;
 }
 
+/* Format request line and headers in write buffer.
+ * Header is not terminated so that framing of body can be added. */
 static http_result_t
-ssl_send_request(
-        SSL* ssl,
+ssl_format_request(
+        ssl_writer_t* writer,
         const kii_char_t* method,
         const http_url_t* url,
-        json_t* request_headers,
-        const kii_char_t* req_bufptr)
+        const kii_http_headers_t* request_headers,
+        kii_int_t keep_alive)
 {
-    /* output HTTP request header to ssl socket */
-    kii_int_t with_data = 0;
     const kii_char_t* str_target = NULL;
     const kii_char_t* str_host = NULL;
-    const char* header_key = NULL;
-    json_t* header_value = NULL;
-    kii_int_t req_buflen = 0;
+    const kii_char_t* const* line = NULL;
 
-    if (req_bufptr != NULL)
-    {
-        with_data = 1;
-        req_buflen = (kii_int_t)kii_strlen(req_bufptr);
-    }
+    writer->length = 0;
+    if (!ssl_writer_reserve(writer, HTTP_EXCONFIG_PRINTBUFFER))
+        return HTTP_RESULT_ERROR_INTERNAL;
     /* FIXME: consider HTTP PROXY */
     str_target = url->path;
     str_host = url->host;
-    /* FIXME: consider error in send */
-    ssl_reqhdr_printf(ssl, "%s %s HTTP/1.1\r\n", method, str_target);
-    ssl_reqhdr_printf(ssl, "Host:%s\r\n", str_host);
-    json_object_foreach(request_headers, header_key, header_value)
+    if (!ssl_reqhdr_printf(writer, "%s %s HTTP/1.1\r\n", method, str_target))
+        return HTTP_RESULT_ERROR_INTERNAL;
+    if (!ssl_reqhdr_printf(writer, "Host:%s\r\n", str_host))
+        return HTTP_RESULT_ERROR_INTERNAL;
+    for (line = request_headers->common; *line != NULL; ++line)
+    {
+        if (!ssl_reqhdr_printf(writer, "%s\r\n", *line))
+            return HTTP_RESULT_ERROR_INTERNAL;
+        M_KII_DEBUG(prv_log("req header: %s", *line));
+    }
+    if (request_headers->opt_extra != NULL)
+    {
+        if (!ssl_reqhdr_printf(writer, "%s\r\n", request_headers->opt_extra))
+            return HTTP_RESULT_ERROR_INTERNAL;
+        M_KII_DEBUG(prv_log("req header: %s", request_headers->opt_extra));
+    }
+    if (response_compression)
     {
-        ssl_reqhdr_printf(ssl, "%s:%s\r\n", header_key,
-                json_string_value(header_value));
-        M_KII_DEBUG(prv_log("req header: %s:%s", header_key,
-                    json_string_value(header_value)));
+        if (!ssl_reqhdr_printf(writer, "Accept-Encoding:gzip, deflate\r\n"))
+            return HTTP_RESULT_ERROR_INTERNAL;
     }
     /* FIXME: implement send proxy authorization information */
-    ssl_reqhdr_printf(ssl, "Connection:close\r\n");
-    if (with_data)
+    /* HTTP/1.1 connection is kept alive unless closed explicitly. */
+    if (!keep_alive)
     {
-        ssl_reqhdr_printf(ssl, "Content-Length:%d\r\n", req_buflen);
+        if (!ssl_reqhdr_printf(writer, "Connection:close\r\n"))
+            return HTTP_RESULT_ERROR_INTERNAL;
     }
-    /* send request terminator */
-    ssl_reqhdr_printf(ssl, "\r\n");
-    /* send payload (ex. POST method) */
-    if (with_data)
-        ssl_write(ssl, req_bufptr, req_buflen, 1);
     return HTTP_RESULT_OK;
 }
 
-static http_result_t
-ssl_recv_response(
-        SSL* ssl,
-        kii_int_t* status,
-        kii_char_t** response_body,
-        json_t** response_headers)
-{
-    http_result_t retval = HTTP_RESULT_OK;
-    kii_int_t bodylen = -1;
-
-    /* receive and parse HTTP response header */
-    {
-        kii_int_t count;
-        /* fetch HTTP status code */
-        for (count = 0; count < HTTP_EXCONFIG_HEADERMAXCOUNT; ++count)
-        {
-            kii_char_t* line = NULL;
-            kii_int_t len;
-            len = ssl_resphdr_readline(ssl, &line);
-            if (len < 0)
-            {
-                /* FIXME: convert to socket read error */
-                retval = HTTP_RESULT_ERROR_RECEIVING;
-                M_KII_FREE_NULLIFY(line);
-                goto END_FUNC;
-            }
-            else if (len == 0)
-            {
-                M_KII_FREE_NULLIFY(line);
-                continue;
-            }
-            if (strncmp((char*)line, "HTTP/1.1 ", 9) != 0)
-            {
-                retval = HTTP_RESULT_ERROR_RESPONSEHEADER;
-                M_KII_FREE_NULLIFY(line);
-                goto END_FUNC;
-            }
-            else if (!isdigit((int)line[9]))
-            {
-                retval = HTTP_RESULT_ERROR_RESPONSEHEADER;
-                M_KII_FREE_NULLIFY(line);
-                goto END_FUNC;
-            }
-            else
-            {
-                *status = atoi((char*)&line[9]);
-                M_KII_FREE_NULLIFY(line);
-                if (*status == 100)
-                    continue;
-                else
-                    break;
-            }
-        }
-        if (count >= HTTP_EXCONFIG_HEADERMAXCOUNT)
-        {
-            retval = HTTP_RESULT_ERROR_RESPONSEHEADER;
-            goto END_FUNC;
-        }
-        /* fetch HTTP response header properties */
-        for (count = 0; count < HTTP_EXCONFIG_HEADERMAXCOUNT; ++count)
-        {
-            int i;
-            kii_char_t* line = NULL;
-            kii_int_t len;
-            len = ssl_resphdr_readline(ssl, &line);
-            if (len < 0)
-            {
-                /* FIXME: convert to socket read error */
-                retval = HTTP_RESULT_ERROR_RECEIVING;
-                M_KII_FREE_NULLIFY(line);
-                goto END_FUNC;
-            }
-            else if (len == 0)
-            {
-                M_KII_FREE_NULLIFY(line);
-                break;
-            }
+/* Body written to write buffer by producer of the body.
+ * Body up to HTTP_EXCONFIG_COALESCEBODYSIZE is sent with Content-Length in
+ * the same write as header. Larger body is sent in chunks while producer
+ * serializes it, if streaming is set. */
+typedef struct {
+    ssl_writer_t* writer;
+    const kii_http_body_t* body;
+    kii_int_t begin; /* offset of body not framed yet */
+    kii_int_t streaming;
+    kii_int_t chunked;
+    http_result_t result;
+} ssl_body_stream_t;
 
-            M_KII_DEBUG(prv_log("resp header: %s", line));
-            for (i = 0; line[i] != '\0' && line[i] != ':'; ++i) {
-                line[i] = (char)kii_tolower(line[i]);
-            }
-            if (strncmp((char*)line, "content-length:", 15) == 0)
-            {
-                /* FIXME: more strict check */
-                bodylen = atoi((char*)skip_spaces(&line[15]));
-            }
-            else if (response_headers != NULL &&
-                    strncmp((char*)line, "etag:", 5) == 0)
-            {
-                if (*response_headers == NULL)
-                    *response_headers = json_object();
-                if (json_object_set_new(*response_headers, "etag",
-                            json_string(skip_spaces(&line[5]))) != 0)
-                {
-                    retval = HTTP_RESULT_ERROR_RESPONSEHEADER;
-                    M_KII_FREE_NULLIFY(line);
-                    goto END_FUNC;
-                }
-            }
-            /* FIXME: parse other properties */
-            M_KII_FREE_NULLIFY(line);
-        }
-    }
-    /* receive HTTP response body */
-    if (response_body != NULL && bodylen > 0)
+/* Content-Encoding set by producer, or empty string. */
+static kii_int_t
+ssl_body_stream_encoding(
+        const kii_http_body_t* body,
+        kii_char_t* header)
+{
+    if (body->content_encoding == NULL)
     {
-        kii_char_t* wptr;
-        kii_char_t* end;
-        *response_body = kii_malloc(sizeof(kii_char_t) * (bodylen + 1));
-        wptr = *response_body;
-        end = wptr + bodylen;
-        for (; wptr < end; ++wptr)
-        {
-            kii_int_t d;
-            d = ssl_readbyte(ssl);
-            if (d < 0)
-            {
-                /* FIXME: convert to socket read error */
-                retval = HTTP_RESULT_ERROR_RECEIVING;
-                goto END_FUNC;
-            }
-            *wptr = (kii_char_t)d;
-        }
-        (*response_body)[bodylen] = '\0';
-        M_KII_DEBUG(prv_log("response: %s", *response_body));
+        header[0] = '\0';
+        return 0;
     }
-END_FUNC:
-    return retval;
+    return sprintf(header, "Content-Encoding:%.32s\r\n",
+            body->content_encoding);
 }
 
-static int32_t
-ssl_connect(kii_int_t socket, SSL_CTX** out_ctx, SSL** out_ssl)
+/* Frame body in the buffer as a chunk and send whole buffer. */
+static kii_int_t
+ssl_body_stream_flush(ssl_body_stream_t* stream)
 {
-    int32_t ret = 0;
-    SSL_load_error_strings();
-    SSL_library_init();
-
-    SSL_CTX *ctx = SSL_CTX_new(SSLv23_client_method());
-    if ( ctx == NULL )
+    ssl_writer_t* writer = stream->writer;
+    kii_char_t prefix[128];
+    kii_int_t prefixlen;
+    if (!stream->chunked)
     {
-        goto END_FUNC;
+        /* terminate header with framing of body. */
+        prefixlen = ssl_body_stream_encoding(stream->body, prefix);
+        prefixlen += sprintf(prefix + prefixlen,
+                "Transfer-Encoding:chunked\r\n\r\n%x\r\n",
+                writer->length - stream->begin);
+        stream->chunked = 1;
     }
-
-    SSL *ssl = SSL_new(ctx);
-    if ( ssl == NULL )
+    else
+        prefixlen = sprintf(prefix, "%x\r\n", writer->length - stream->begin);
+    if (!ssl_writer_insert(writer, stream->begin, prefix, prefixlen) ||
+            !ssl_writer_append(writer, "\r\n", 2))
     {
-        goto END_FUNC;
+        stream->result = HTTP_RESULT_ERROR_INTERNAL;
+        return 0;
     }
-
-    ret = SSL_set_fd(ssl, socket);
-    if (ret == 0)
+    if (!ssl_writer_flush(writer))
     {
-        goto END_FUNC;
+        stream->result = HTTP_RESULT_ERROR_SENDING;
+        return 0;
     }
+    stream->begin = 0;
+    return 1;
+}
 
-    RAND_poll();
-    while(RAND_status() == 0)
+/* Called by producer of body. */
+static int
+ssl_body_stream_write(
+        const char* buffer,
+        size_t size,
+        void* context)
+{
+    ssl_body_stream_t* stream = (ssl_body_stream_t*)context;
+    ssl_writer_t* writer = stream->writer;
+    if (!ssl_writer_append(writer, buffer, (kii_int_t)size))
     {
-        unsigned short rand_ret = rand() % 65536;
-        RAND_seed(&rand_ret, sizeof(rand_ret));
+        stream->result = HTTP_RESULT_ERROR_INTERNAL;
+        return -1;
     }
+    if (stream->streaming &&
+            writer->length - stream->begin >= HTTP_EXCONFIG_COALESCEBODYSIZE)
+        return ssl_body_stream_flush(stream) ? 0 : -1;
+    return 0;
+}
 
-    ret = SSL_connect(ssl);
+/* Send header in write buffer and then serialized body as is.
+ * Body is written from memory of caller without copying it to the
+ * buffer. */
+static http_result_t
+ssl_body_send_bytes(
+        ssl_writer_t* writer,
+        const kii_http_body_t* body)
+{
+    if (!ssl_reqhdr_printf(writer, "Content-Length:%lu\r\n\r\n",
+                (unsigned long)body->bytes_length))
+        return HTTP_RESULT_ERROR_INTERNAL;
+    if (!ssl_writer_flush(writer) || SSL_write(writer->ssl, body->opt_bytes,
+                (int)body->bytes_length) <= 0)
+        return HTTP_RESULT_ERROR_SENDING;
+    return HTTP_RESULT_OK;
+}
 
-END_FUNC:
-    if (ret != 0)
+/* Produce body into write buffer following header.
+ * Remains of body and its terminator are left in the buffer. */
+static http_result_t
+ssl_body_stream_produce(
+        ssl_writer_t* writer,
+        const kii_http_body_t* body,
+        kii_int_t streaming)
+{
+    ssl_body_stream_t stream;
+    kii_char_t prefix[128];
+    kii_int_t prefixlen;
+
+    if (body == NULL)
+        return ssl_writer_append(writer, "\r\n", 2) ?
+            HTTP_RESULT_OK : HTTP_RESULT_ERROR_INTERNAL;
+    /* large serialized body is framed by its length instead of chunks. */
+    if (streaming && body->opt_bytes != NULL &&
+            body->bytes_length > HTTP_EXCONFIG_COALESCEBODYSIZE)
+        return ssl_body_send_bytes(writer, body);
+    stream.writer = writer;
+    stream.body = body;
+    stream.begin = writer->length;
+    stream.streaming = streaming;
+    stream.chunked = 0;
+    stream.result = HTTP_RESULT_ERROR_INTERNAL;
+    if (body->produce(body->data, ssl_body_stream_write, &stream) != 0)
+        return stream.result;
+    if (stream.chunked)
+    {
+        if (writer->length > stream.begin &&
+                !ssl_body_stream_flush(&stream))
+            return stream.result;
+        if (!ssl_writer_append(writer, "0\r\n\r\n", 5))
+            return HTTP_RESULT_ERROR_INTERNAL;
+        return HTTP_RESULT_OK;
+    }
+    prefixlen = ssl_body_stream_encoding(body, prefix);
+    prefixlen += sprintf(prefix + prefixlen, "Content-Length:%d\r\n\r\n",
+            writer->length - stream.begin);
+    if (!ssl_writer_insert(writer, stream.begin, prefix, prefixlen))
+        return HTTP_RESULT_ERROR_INTERNAL;
+    return HTTP_RESULT_OK;
+}
+
+/* Request line, headers and small body are sent by one SSL_write
+ * so that they are packed in a TLS record. */
+static http_result_t
+ssl_send_request(
+        ssl_writer_t* writer,
+        const kii_char_t* method,
+        const http_url_t* url,
+        const kii_http_headers_t* request_headers,
+        const kii_http_body_t* request_body,
+        kii_int_t keep_alive)
+{
+    http_result_t retval;
+
+    retval = ssl_format_request(writer, method, url, request_headers,
+            keep_alive);
+    if (retval != HTTP_RESULT_OK)
+        return retval;
+    retval = ssl_body_stream_produce(writer, request_body, 1);
+    if (retval != HTTP_RESULT_OK)
+        return retval;
+    if (!ssl_writer_flush(writer))
+        return HTTP_RESULT_ERROR_SENDING;
+    return HTTP_RESULT_OK;
+}
+
+static void
+ssl_response_init(
+        ssl_response_t* resp,
+        const kii_char_t* method,
+        const kii_http_sink_t* sink)
+{
+    memset(resp, 0, sizeof(ssl_response_t));
+    resp->state = SSL_RESP_STATUS;
+    resp->method = method;
+    resp->sink = sink;
+    prv_init_resp_headers(&resp->headers);
+}
+
+static void
+ssl_response_dispose(ssl_response_t* resp)
+{
+    M_KII_FREE_NULLIFY(resp->body);
+    if (resp->inflating)
+        inflateEnd(&resp->inflater);
+    resp->inflating = 0;
+}
+
+/* Decide how the body is delimited after header is received. */
+static http_result_t
+ssl_response_begin_body(ssl_response_t* resp)
+{
+    resp->keep_alive = (resp->headers.connection_close == KII_FALSE);
+    /* only successful body is passed to sink. */
+    if (resp->status < 200 || resp->status >= 300)
+        resp->sink = NULL;
+    resp->compressed = response_compression &&
+        (strcasecmp(resp->headers.content_encoding, "gzip") == 0 ||
+         strcasecmp(resp->headers.content_encoding, "deflate") == 0);
+    if (strcmp(resp->method, "HEAD") == 0 || resp->status == 204 ||
+            resp->status == 304)
+    {
+        /* no body even if Content-Length is given. */
+        resp->state = SSL_RESP_DONE;
+    }
+    else if (resp->headers.chunked == KII_TRUE)
+    {
+        resp->state = SSL_RESP_CHUNK_SIZE;
+    }
+    else if (resp->headers.content_length >= 0)
+    {
+        resp->remaining = resp->headers.content_length;
+        if (resp->sink == NULL)
+        {
+            /* body must fit in buffer with terminating null. */
+            if (resp->remaining > INT_MAX - 1)
+                return HTTP_RESULT_ERROR_RESPONSEHEADER;
+            if (!ssl_body_reserve(&resp->body, &resp->capacity, 0,
+                        (resp->remaining < HTTP_EXCONFIG_BODYMAXPRESIZE) ?
+                        (kii_int_t)resp->remaining + 1 :
+                        HTTP_EXCONFIG_BODYMAXPRESIZE))
+                return HTTP_RESULT_ERROR_INTERNAL;
+        }
+        resp->state = (resp->remaining > 0) ? SSL_RESP_BODY : SSL_RESP_DONE;
+    }
+    else
+    {
+        /* delimited by close of connection. it can't be reused. */
+        resp->keep_alive = 0;
+        resp->state = SSL_RESP_UNTIL_CLOSE;
+    }
+    return HTTP_RESULT_OK;
+}
+
+/* Decompress body as it is received.
+ * Decompressed data is written to the body buffer directly, or passed to
+ * sink through small buffer, so that whole compressed body is never held. */
+static http_result_t
+ssl_response_inflate(
+        ssl_response_t* resp,
+        const kii_char_t* data,
+        kii_int_t len)
+{
+    kii_char_t buffer[HTTP_EXCONFIG_INFLATEBUFFERSIZE];
+    z_stream* inflater = &resp->inflater;
+    if (!resp->inflating)
+    {
+        memset(inflater, 0, sizeof(z_stream));
+        /* 15 + 32 detects gzip or zlib header automatically. */
+        if (inflateInit2(inflater, 15 + 32) != Z_OK)
+            return HTTP_RESULT_ERROR_INTERNAL;
+        resp->inflating = 1;
+    }
+    inflater->next_in = (Bytef*)data;
+    inflater->avail_in = (uInt)len;
+    /* data following end of compressed stream is ignored. */
+    while (inflater->avail_in > 0 && !resp->inflated)
+    {
+        kii_char_t* out = buffer;
+        kii_int_t produced;
+        kii_int_t r;
+        if (resp->sink == NULL)
+        {
+            if (!ssl_body_reserve(&resp->body, &resp->capacity,
+                    resp->bodylen, HTTP_EXCONFIG_INFLATEBUFFERSIZE + 1))
+                return HTTP_RESULT_ERROR_INTERNAL;
+            out = &resp->body[resp->bodylen];
+        }
+        inflater->next_out = (Bytef*)out;
+        inflater->avail_out = HTTP_EXCONFIG_INFLATEBUFFERSIZE;
+        r = inflate(inflater, Z_NO_FLUSH);
+        if (r == Z_STREAM_END)
+            resp->inflated = 1;
+        else if (r != Z_OK)
+            return HTTP_RESULT_ERROR_RECEIVING;
+        produced = HTTP_EXCONFIG_INFLATEBUFFERSIZE - inflater->avail_out;
+        if (resp->sink != NULL)
+            resp->sink->consume(out, produced, resp->sink->context);
+        else
+            resp->bodylen += produced;
+    }
+    return HTTP_RESULT_OK;
+}
+
+/* Move body in read buffer to response, at most max bytes.
+ * max is -1 if body continues until close of connection.
+ * If response has sink, body is passed to it directly from read buffer. */
+static http_result_t
+ssl_response_take_body(
+        ssl_response_t* resp,
+        ssl_reader_t* reader,
+        long max)
+{
+    kii_int_t available = reader->end - reader->begin;
+    if (max >= 0 && available > max)
+        available = (kii_int_t)max;
+    if (resp->compressed)
     {
-        *out_ctx = ctx;
-        *out_ssl = ssl;
+        http_result_t retval = ssl_response_inflate(resp,
+                &reader->data[reader->begin], available);
+        if (retval != HTTP_RESULT_OK)
+            return retval;
     }
+    else if (resp->sink != NULL)
+        resp->sink->consume(&reader->data[reader->begin], available,
+                resp->sink->context);
     else
     {
-        SSL_free(ssl); 
-        SSL_CTX_free(ctx);
+        if (!ssl_body_reserve(&resp->body, &resp->capacity,
+                    resp->bodylen, available + 1))
+            return HTTP_RESULT_ERROR_INTERNAL;
+        memcpy(&resp->body[resp->bodylen], &reader->data[reader->begin],
+                available);
+        resp->bodylen += available;
+    }
+    reader->begin += available;
+    if (max >= 0)
+        resp->remaining -= available;
+    return HTTP_RESULT_OK;
+}
+
+/* Parse data in read buffer as far as possible.
+ * HTTP_RESULT_OK with state other than SSL_RESP_DONE means more data is
+ * needed. */
+static http_result_t
+ssl_response_parse(
+        ssl_response_t* resp,
+        ssl_reader_t* reader)
+{
+    http_result_t retval = HTTP_RESULT_OK;
+    while (retval == HTTP_RESULT_OK && resp->state != SSL_RESP_DONE)
+    {
+        kii_char_t* line = NULL;
+        kii_char_t* end = NULL;
+        kii_int_t len = 0;
+        /* states before body and between chunks consume a line,
+         * states in body consume any data received. */
+        switch (resp->state)
+        {
+            case SSL_RESP_BODY:
+            case SSL_RESP_CHUNK_DATA:
+            case SSL_RESP_UNTIL_CLOSE:
+                if (reader->begin == reader->end)
+                    return HTTP_RESULT_OK;
+                break;
+            default:
+                len = ssl_reader_getline(reader, &line);
+                if (len == -1)
+                    return HTTP_RESULT_OK;
+                else if (len < 0)
+                    return HTTP_RESULT_ERROR_RESPONSEHEADER;
+                if (resp->state == SSL_RESP_STATUS ||
+                        resp->state == SSL_RESP_HEADER)
+                {
+                    if (++(resp->lines) > HTTP_EXCONFIG_HEADERMAXCOUNT)
+                        return HTTP_RESULT_ERROR_RESPONSEHEADER;
+                }
+                break;
+        }
+        switch (resp->state)
+        {
+            case SSL_RESP_STATUS:
+                /* fetch HTTP status code */
+                if (len == 0)
+                    break;
+                if (strncmp((char*)line, "HTTP/1.1 ", 9) != 0)
+                    retval = HTTP_RESULT_ERROR_RESPONSEHEADER;
+                else if (!isdigit((int)line[9]))
+                    retval = HTTP_RESULT_ERROR_RESPONSEHEADER;
+                else
+                {
+                    resp->status = atoi((char*)&line[9]);
+                    if (resp->status != 100)
+                    {
+                        resp->state = SSL_RESP_HEADER;
+                        resp->lines = 0;
+                    }
+                }
+                break;
+            case SSL_RESP_HEADER:
+                /* fetch HTTP response header properties */
+                if (len == 0)
+                {
+                    retval = ssl_response_begin_body(resp);
+                    break;
+                }
+                M_KII_DEBUG(prv_log("resp header: %s", line));
+                prv_parse_resp_header(line, len, &resp->headers);
+                break;
+            case SSL_RESP_BODY:
+                retval = ssl_response_take_body(resp, reader, resp->remaining);
+                if (resp->remaining == 0)
+                    resp->state = SSL_RESP_DONE;
+                break;
+            case SSL_RESP_CHUNK_SIZE:
+                /* chunk size in hex. chunk extension is ignored. */
+                errno = 0;
+                resp->remaining = strtol(line, &end, 16);
+                if (end == line || !isxdigit((unsigned char)line[0]) ||
+                        errno == ERANGE || resp->remaining < 0)
+                    retval = HTTP_RESULT_ERROR_RESPONSEHEADER;
+                else if (resp->remaining == 0)
+                    resp->state = SSL_RESP_TRAILER;
+                else
+                    resp->state = SSL_RESP_CHUNK_DATA;
+                break;
+            case SSL_RESP_CHUNK_DATA:
+                retval = ssl_response_take_body(resp, reader, resp->remaining);
+                if (resp->remaining == 0)
+                    resp->state = SSL_RESP_CHUNK_END;
+                break;
+            case SSL_RESP_CHUNK_END:
+                /* CRLF following chunk data */
+                if (len != 0)
+                    retval = HTTP_RESULT_ERROR_RECEIVING;
+                else
+                    resp->state = SSL_RESP_CHUNK_SIZE;
+                break;
+            case SSL_RESP_TRAILER:
+                /* skip trailer */
+                if (len == 0)
+                    resp->state = SSL_RESP_DONE;
+                break;
+            case SSL_RESP_UNTIL_CLOSE:
+                retval = ssl_response_take_body(resp, reader, -1);
+                break;
+            default:
+                break;
+        }
+    }
+    /* compressed body must not be truncated. */
+    if (retval == HTTP_RESULT_OK && resp->state == SSL_RESP_DONE &&
+            resp->inflating && !resp->inflated)
+        retval = HTTP_RESULT_ERROR_RECEIVING;
+    return retval;
+}
+
+/* Whether no byte of response is received yet. */
+static kii_int_t
+ssl_response_untouched(
+        const ssl_response_t* resp,
+        const ssl_reader_t* reader)
+{
+    return resp->state == SSL_RESP_STATUS && resp->lines == 0 &&
+        reader->begin == reader->end;
+}
+
+/* Whether request failed on pooled connection can be retried with new
+ * connection. Server may close idle connection at any time, but it may
+ * also have processed the request already. It is retried only if the
+ * request wasn't sent, or if the connection was closed or reset before
+ * any byte of response and the request is idempotent. Read timeout is
+ * never retried. */
+static kii_int_t
+ssl_request_retryable(
+        const kii_char_t* method,
+        http_result_t result,
+        kii_int_t closed)
+{
+    if (result == HTTP_RESULT_ERROR_SENDING)
+        return 1;
+    return closed && (strcmp(method, "GET") == 0 ||
+            strcmp(method, "HEAD") == 0 || strcmp(method, "PUT") == 0 ||
+            strcmp(method, "DELETE") == 0);
+}
+
+/* Called when server closed connection before response is completed. */
+static http_result_t
+ssl_response_eof(ssl_response_t* resp)
+{
+    if (resp->state != SSL_RESP_UNTIL_CLOSE)
+        return HTTP_RESULT_ERROR_RECEIVING;
+    resp->state = SSL_RESP_DONE;
+    if (resp->inflating && !resp->inflated)
+        return HTTP_RESULT_ERROR_RECEIVING;
+    return HTTP_RESULT_OK;
+}
+
+/* Hand NUL terminated body over to caller. */
+static void
+ssl_response_finish(
+        ssl_response_t* resp,
+        kii_char_t** response_body)
+{
+    if (resp->body != NULL)
+    {
+        resp->body[resp->bodylen] = '\0';
+        M_KII_DEBUG(prv_log("response: %s", resp->body));
+    }
+    if (response_body != NULL)
+    {
+        *response_body = resp->body;
+        resp->body = NULL;
+    }
+    if (resp->inflating)
+    {
+        pthread_mutex_lock(&compression_stats_mutex);
+        compressed_bytes += resp->inflater.total_in;
+        decompressed_bytes += resp->inflater.total_out;
+        pthread_mutex_unlock(&compression_stats_mutex);
+    }
+    ssl_response_dispose(resp);
+}
+
+/* Receive response by blocking read.
+ * *closed is set if connection is closed or reset before any byte of
+ * response. */
+static http_result_t
+ssl_recv_response(
+        ssl_reader_t* reader,
+        ssl_response_t* resp,
+        kii_int_t* closed)
+{
+    *closed = 0;
+    while (1)
+    {
+        kii_int_t r;
+        http_result_t retval = ssl_response_parse(resp, reader);
+        if (retval != HTTP_RESULT_OK || resp->state == SSL_RESP_DONE)
+            return retval;
+        r = ssl_reader_fill(reader);
+        if ((r == 0 || r == -4) && ssl_response_untouched(resp, reader))
+            *closed = 1;
+        if (r == 0)
+            return ssl_response_eof(resp);
+        else if (r < 0)
+            /* FIXME: convert to socket read error */
+            return HTTP_RESULT_ERROR_RECEIVING;
+    }
+}
+
+/* Called by OpenSSL when server issues new session.
+ * Sessions are cached per host and port so that following connections
+ * resume it and skip the full handshake. */
+static int
+ssl_session_cache_store(SSL* ssl, SSL_SESSION* session)
+{
+    const ssl_connection_t* conn = SSL_get_app_data(ssl);
+    ssl_session_entry_t* entry = NULL;
+    kii_int_t i;
+
+    if (conn == NULL)
+        return 0;
+    pthread_mutex_lock(&ssl_sessions_mutex);
+    for (i = 0; i < HTTP_EXCONFIG_SESSIONCACHESIZE; ++i)
+    {
+        if (ssl_sessions[i].session != NULL &&
+                ssl_sessions[i].port == conn->port &&
+                strcmp(ssl_sessions[i].host, conn->host) == 0)
+        {
+            entry = &ssl_sessions[i];
+            break;
+        }
+    }
+    if (entry == NULL)
+    {
+        /* replace entries in round robin. */
+        entry = &ssl_sessions[ssl_sessions_next];
+        ssl_sessions_next =
+            (ssl_sessions_next + 1) % HTTP_EXCONFIG_SESSIONCACHESIZE;
+    }
+    if (entry->session != NULL)
+        SSL_SESSION_free(entry->session);
+    strcpy(entry->host, conn->host);
+    entry->port = conn->port;
+    entry->session = session;
+    pthread_mutex_unlock(&ssl_sessions_mutex);
+    return 1; /* reference of the session is kept by the cache. */
+}
+
+static void
+ssl_session_cache_restore(SSL* ssl, const ssl_connection_t* conn)
+{
+    kii_int_t i;
+    pthread_mutex_lock(&ssl_sessions_mutex);
+    for (i = 0; i < HTTP_EXCONFIG_SESSIONCACHESIZE; ++i)
+    {
+        if (ssl_sessions[i].session != NULL &&
+                ssl_sessions[i].port == conn->port &&
+                strcmp(ssl_sessions[i].host, conn->host) == 0)
+        {
+            SSL_set_session(ssl, ssl_sessions[i].session);
+            break;
+        }
     }
+    pthread_mutex_unlock(&ssl_sessions_mutex);
+}
+
+static void
+ssl_session_cache_clear(void)
+{
+    kii_int_t i;
+    pthread_mutex_lock(&ssl_sessions_mutex);
+    for (i = 0; i < HTTP_EXCONFIG_SESSIONCACHESIZE; ++i)
+    {
+        if (ssl_sessions[i].session != NULL)
+            SSL_SESSION_free(ssl_sessions[i].session);
+        memset(&ssl_sessions[i], 0, sizeof(ssl_session_entry_t));
+    }
+    ssl_sessions_next = 0;
+    pthread_mutex_unlock(&ssl_sessions_mutex);
+}
+
+static void
+ssl_connection_close(ssl_connection_t* conn)
+{
+    if (conn->reader.ssl != NULL)
+        SSL_shutdown(conn->reader.ssl);
+    if (conn->sock >= 0)
+        socket_close(conn->sock);
+    SSL_free(conn->reader.ssl);
+    M_KII_FREE_NULLIFY(conn->writer.data);
+    M_KII_FREE_NULLIFY(conn);
+}
+
+/* Allocate connection to the host. It is not connected yet. */
+static http_result_t
+ssl_connection_new(const http_url_t* url, ssl_connection_t** out_conn)
+{
+    ssl_connection_t* conn = kii_malloc(sizeof(ssl_connection_t));
+    if (conn == NULL)
+        return HTTP_RESULT_ERROR_INTERNAL;
+    strcpy(conn->host, url->host);
+    conn->port = url->port;
+    conn->sock = -1;
+    conn->last_used = 0;
+    conn->reader.ssl = NULL;
+    conn->reader.begin = 0;
+    conn->reader.end = 0;
+    conn->writer.ssl = NULL;
+    conn->writer.data = NULL;
+    conn->writer.length = 0;
+    conn->writer.capacity = 0;
+    conn->writer.early_data = 0;
+    *out_conn = conn;
+    return HTTP_RESULT_OK;
+}
+
+#ifdef HTTP_SSL_NOSIGNAL_BIO
+/* Socket BIO of the connection set as data. It doesn't close socket. */
+static int
+ssl_bio_write(BIO* bio, const char* data, int length)
+{
+    ssl_connection_t* conn = BIO_get_data(bio);
+    int ret = (int)send(conn->sock, data, (size_t)length, MSG_NOSIGNAL);
+    BIO_clear_retry_flags(bio);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK ||
+                errno == EINTR))
+        BIO_set_retry_write(bio);
     return ret;
 }
 
+static int
+ssl_bio_read(BIO* bio, char* data, int length)
+{
+    ssl_connection_t* conn = BIO_get_data(bio);
+    int ret = (int)recv(conn->sock, data, (size_t)length, 0);
+    BIO_clear_retry_flags(bio);
+    if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK ||
+                errno == EINTR))
+        BIO_set_retry_read(bio);
+    return ret;
+}
+
+static int
+ssl_bio_puts(BIO* bio, const char* str)
+{
+    return ssl_bio_write(bio, str, (int)strlen(str));
+}
+
+static long
+ssl_bio_ctrl(BIO* bio, int cmd, long num, void* ptr)
+{
+    ssl_connection_t* conn = BIO_get_data(bio);
+    (void)num;
+    switch (cmd)
+    {
+        case BIO_C_GET_FD:
+            /* used by SSL_get_fd. */
+            if (ptr != NULL)
+                *(int*)ptr = conn->sock;
+            return conn->sock;
+        case BIO_CTRL_FLUSH:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static int
+ssl_bio_create(BIO* bio)
+{
+    BIO_set_init(bio, 1);
+    return 1;
+}
+
+static int
+ssl_bio_destroy(BIO* bio)
+{
+    (void)bio;
+    return 1;
+}
+
+static BIO_METHOD*
+ssl_bio_method_new(void)
+{
+    BIO_METHOD* method = BIO_meth_new(BIO_get_new_index() |
+            BIO_TYPE_SOURCE_SINK | BIO_TYPE_DESCRIPTOR, "kii socket");
+    if (method == NULL)
+        return NULL;
+    BIO_meth_set_write(method, ssl_bio_write);
+    BIO_meth_set_read(method, ssl_bio_read);
+    BIO_meth_set_puts(method, ssl_bio_puts);
+    BIO_meth_set_ctrl(method, ssl_bio_ctrl);
+    BIO_meth_set_create(method, ssl_bio_create);
+    BIO_meth_set_destroy(method, ssl_bio_destroy);
+    return method;
+}
+#endif
+
+/* Create ssl on the connected socket. Handshake is not started. */
+static int32_t
+ssl_connection_attach(ssl_connection_t* conn)
+{
+    int32_t ret = 0;
+#ifdef HTTP_SSL_NOSIGNAL_BIO
+    BIO* bio = NULL;
+#endif
+    SSL* ssl = SSL_new(ssl_ctx);
+    if (ssl == NULL)
+    {
+        return 0;
+    }
+    conn->reader.ssl = ssl;
+    conn->writer.ssl = ssl;
+
+#ifdef HTTP_SSL_NOSIGNAL_BIO
+    bio = BIO_new(ssl_bio_method);
+    if (bio == NULL)
+        return 0;
+    BIO_set_data(bio, conn);
+    SSL_set_bio(ssl, bio, bio);
+    ret = 1;
+#else
+    ret = SSL_set_fd(ssl, conn->sock);
+#endif
+    if (ret == 0)
+    {
+        return ret;
+    }
+
+    SSL_set_tlsext_host_name(ssl, conn->host);
+    SSL_set_app_data(ssl, (char*)conn);
+    ssl_session_cache_restore(ssl, conn);
+    return 1;
+}
+
+/* If early_data is set and session to be resumed allows it, handshake is
+ * deferred until first request is written. */
+static http_result_t
+ssl_connection_open(
+        const http_url_t* url,
+        kii_int_t early_data,
+        ssl_connection_t** out_conn)
+{
+    ssl_connection_t* conn = NULL;
+    if (ssl_connection_new(url, &conn) != HTTP_RESULT_OK)
+        return HTTP_RESULT_ERROR_INTERNAL;
+
+    /* connect to HTTP server */
+    conn->sock = socket_connect(url);
+    if (conn->sock < 0)
+    {
+        ssl_connection_close(conn);
+        return HTTP_RESULT_ERROR_CONNECTSERVER;
+    }
+    if (ssl_connection_attach(conn) != 1)
+    {
+        ssl_connection_close(conn);
+        return HTTP_RESULT_ERROR_CONNECTSSLSERVER;
+    }
+#ifdef TLS1_3_VERSION
+    if (early_data && SSL_get_session(conn->reader.ssl) != NULL &&
+            SSL_SESSION_get_max_early_data(
+                SSL_get_session(conn->reader.ssl)) > 0)
+    {
+        conn->writer.early_data = 1;
+        *out_conn = conn;
+        return HTTP_RESULT_OK;
+    }
+#endif
+    if (SSL_connect(conn->reader.ssl) != 1)
+    {
+        ssl_connection_close(conn);
+        return HTTP_RESULT_ERROR_CONNECTSSLSERVER;
+    }
+    M_KII_DEBUG(prv_log("ssl session reused: %d",
+                SSL_session_reused(conn->reader.ssl)));
+    *out_conn = conn;
+    return HTTP_RESULT_OK;
+}
+
+/* Idle connection must not be readable.
+ * Readable means the server closed it or sent unexpected data. */
+static kii_int_t
+ssl_connection_is_alive(ssl_connection_t* conn)
+{
+    struct pollfd pfd;
+    if (conn->reader.begin != conn->reader.end ||
+            SSL_pending(conn->reader.ssl) > 0)
+        return 0;
+    pfd.fd = conn->sock;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    return (poll(&pfd, 1, 0) == 0);
+}
+
+/* Close connections idle longer than timeout.
+ * Caller must lock ssl_pool.mutex. */
+static void
+ssl_pool_reap(time_t now)
+{
+    kii_uint_t i;
+    for (i = 0; i < ssl_pool.size; ++i)
+    {
+        ssl_connection_t* conn = ssl_pool.idles[i];
+        if (conn != NULL &&
+                now - conn->last_used >= (time_t)ssl_pool.idle_timeout)
+        {
+            ssl_connection_close(conn);
+            ssl_pool.idles[i] = NULL;
+        }
+    }
+}
+
+/* Caller must lock ssl_pool.mutex. */
+static void
+ssl_pool_clear(void)
+{
+    kii_uint_t i;
+    for (i = 0; i < ssl_pool.size; ++i)
+    {
+        if (ssl_pool.idles[i] != NULL)
+            ssl_connection_close(ssl_pool.idles[i]);
+    }
+    M_KII_FREE_NULLIFY(ssl_pool.idles);
+    ssl_pool.size = 0;
+}
+
+/* Caller must lock ssl_pool.mutex. */
+static kii_bool_t
+ssl_pool_resize(kii_uint_t size)
+{
+    ssl_pool_clear();
+    if (size == 0)
+        return KII_TRUE;
+    ssl_pool.idles = kii_malloc(sizeof(ssl_connection_t*) * size);
+    if (ssl_pool.idles == NULL)
+        return KII_FALSE;
+    memset(ssl_pool.idles, 0, sizeof(ssl_connection_t*) * size);
+    ssl_pool.size = size;
+    return KII_TRUE;
+}
+
+static kii_int_t
+ssl_pool_enabled(void)
+{
+    kii_int_t enabled;
+    pthread_mutex_lock(&ssl_pool.mutex);
+    enabled = (ssl_pool.size > 0);
+    pthread_mutex_unlock(&ssl_pool.mutex);
+    return enabled;
+}
+
+/* Take alive idle connection to the host out of the pool.
+ * Returns NULL if there is no such connection. */
+static ssl_connection_t*
+ssl_pool_acquire(const http_url_t* url)
+{
+    while (1)
+    {
+        ssl_connection_t* conn = NULL;
+        kii_uint_t i;
+        pthread_mutex_lock(&ssl_pool.mutex);
+        ssl_pool_reap(time(NULL));
+        for (i = 0; i < ssl_pool.size; ++i)
+        {
+            ssl_connection_t* idle = ssl_pool.idles[i];
+            if (idle != NULL && idle->port == url->port &&
+                    strcmp(idle->host, url->host) == 0)
+            {
+                conn = idle;
+                ssl_pool.idles[i] = NULL;
+                break;
+            }
+        }
+        pthread_mutex_unlock(&ssl_pool.mutex);
+        if (conn == NULL)
+            return NULL;
+        if (ssl_connection_is_alive(conn))
+            return conn;
+        ssl_connection_close(conn);
+    }
+}
+
+/* Put connection back to the pool.
+ * The oldest idle connection is closed if the pool is full. */
+static void
+ssl_pool_release(ssl_connection_t* conn)
+{
+    ssl_connection_t* closing = conn;
+    kii_uint_t i;
+    pthread_mutex_lock(&ssl_pool.mutex);
+    conn->last_used = time(NULL);
+    ssl_pool_reap(conn->last_used);
+    for (i = 0; i < ssl_pool.size; ++i)
+    {
+        if (ssl_pool.idles[i] == NULL)
+        {
+            ssl_pool.idles[i] = conn;
+            closing = NULL;
+            break;
+        }
+        if (closing == conn ||
+                ssl_pool.idles[i]->last_used < closing->last_used)
+            closing = ssl_pool.idles[i];
+    }
+    if (closing != NULL && closing != conn)
+    {
+        for (i = 0; i < ssl_pool.size; ++i)
+        {
+            if (ssl_pool.idles[i] == closing)
+                ssl_pool.idles[i] = conn;
+        }
+    }
+    pthread_mutex_unlock(&ssl_pool.mutex);
+    if (closing != NULL)
+        ssl_connection_close(closing);
+}
+
 static http_result_t
 request(const kii_char_t* method,
         const kii_char_t* urlstr,
-        json_t* request_headers,
-        const kii_char_t* request_body,
+        const kii_http_headers_t* request_headers,
+        const kii_http_body_t* request_body,
         kii_int_t* status_code,
-        json_t** response_headers,
+        prv_kii_resp_headers_t* response_headers,
+        const kii_http_sink_t* response_sink,
         kii_char_t** response_body)
 {
     http_result_t retval = HTTP_RESULT_ERROR_INTERNAL;
     http_url_t url;
-    kii_int_t sock = 0;
-    SSL_CTX* ctx = NULL;
-    SSL* ssl = NULL;
+    ssl_response_t resp;
+    ssl_connection_t* conn = NULL;
+    kii_int_t reused = 0;
+    kii_int_t closed = 0;
 
     M_KII_DEBUG(prv_log("request url: %s", urlstr));
     M_KII_DEBUG(prv_log("request method: %s", method));
-    M_KII_DEBUG(prv_log("request body: %s", request_body));
 
+    ssl_response_init(&resp, method, response_sink);
     if (!parse_url(&url, urlstr))
     {
         retval = HTTP_RESULT_ERROR_URLSYNTAX;
         goto END_FUNC;
     }
-    /* connect to HTTP server */
-    sock = socket_connect(&url);
-    if (sock < 0)
+    while (1)
     {
-        retval = HTTP_RESULT_ERROR_CONNECTSERVER;
-        goto END_FUNC;
+        /* connect to HTTP server unless alive connection is pooled. */
+        conn = ssl_pool_acquire(&url);
+        reused = (conn != NULL);
+        if (conn == NULL)
+        {
+            /* early data can be replayed. only safe request is sent. */
+            retval = ssl_connection_open(&url,
+                    transport_profile == KII_TRANSPORT_LOW_LATENCY_EARLY_DATA &&
+                    strcmp(method, "GET") == 0 && request_body == NULL,
+                    &conn);
+            if (retval != HTTP_RESULT_OK)
+                goto END_FUNC;
+        }
+        /* output HTTP request header to socket */
+        retval = ssl_send_request(&conn->writer, method, &url,
+                request_headers, request_body, ssl_pool_enabled());
+        /* receive HTTP response and parse it */
+        closed = 0;
+        if (retval == HTTP_RESULT_OK)
+            retval = ssl_recv_response(&conn->reader, &resp, &closed);
+        if (retval != HTTP_RESULT_OK && reused &&
+                ssl_request_retryable(method, retval, closed))
+        {
+            /* server closed pooled connection before responding.
+             * retry with new connection. */
+            ssl_connection_close(conn);
+            conn = NULL;
+            ssl_response_dispose(&resp);
+            ssl_response_init(&resp, method, response_sink);
+            continue;
+        }
+        break;
     }
-    if (ssl_connect(sock, &ctx, &ssl) != 1)
+    *status_code = resp.status;
+    if (response_headers != NULL)
+        *response_headers = resp.headers;
+    if (retval == HTTP_RESULT_OK)
+        ssl_response_finish(&resp, response_body);
+END_FUNC:
+    ssl_response_dispose(&resp);
+    if (conn != NULL)
     {
-        retval = HTTP_RESULT_ERROR_CONNECTSSLSERVER;
-        goto END_FUNC;
+        if (retval == HTTP_RESULT_OK && resp.keep_alive)
+            ssl_pool_release(conn);
+        else
+            ssl_connection_close(conn);
     }
-    /* output HTTP request header to socket */
-    retval = ssl_send_request(ssl, method, &url, request_headers, request_body);
-    if (retval != HTTP_RESULT_OK)
+    return retval;
+}
+
+kii_bool_t kii_http_init(void)
+{
+    kii_bool_t ret;
+    if (ssl_ctx != NULL)
+        return KII_TRUE; /* initialized already. */
+
+    SSL_load_error_strings();
+    SSL_library_init();
+
+    ssl_ctx = SSL_CTX_new(SSLv23_client_method());
+    if (ssl_ctx == NULL)
+        return KII_FALSE;
+#ifdef HTTP_SSL_NOSIGNAL_BIO
+    ssl_bio_method = ssl_bio_method_new();
+    if (ssl_bio_method == NULL)
     {
-        goto END_FUNC;
+        SSL_CTX_free(ssl_ctx);
+        ssl_ctx = NULL;
+        return KII_FALSE;
     }
-    /* receive HTTP response and parse it */
-    retval = ssl_recv_response(ssl, status_code, response_body,
-            response_headers);
-END_FUNC:
-    if (ssl != NULL)
-        SSL_shutdown(ssl);
-    if (sock >= 0)
-        socket_close(sock);
-    SSL_free(ssl);
-    SSL_CTX_free(ctx);
+#endif
+    /* sessions are cached by ssl_session_cache_store. */
+    SSL_CTX_set_session_cache_mode(ssl_ctx,
+            SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ssl_ctx, ssl_session_cache_store);
+#ifdef SSL_OP_IGNORE_UNEXPECTED_EOF
+    /* body delimited by close of connection may end without close_notify. */
+    SSL_CTX_set_options(ssl_ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
+#endif
+
+    RAND_poll();
+    while(RAND_status() == 0)
+    {
+        unsigned short rand_ret = rand() % 65536;
+        RAND_seed(&rand_ret, sizeof(rand_ret));
+    }
+
+    pthread_mutex_lock(&ssl_pool.mutex);
+    ssl_pool.idle_timeout = HTTP_EXCONFIG_POOLIDLETIMEOUT;
+    ret = ssl_pool_resize(HTTP_EXCONFIG_POOLSIZE);
+    pthread_mutex_unlock(&ssl_pool.mutex);
+    return ret;
+}
+
+void kii_http_cleanup(void)
+{
+    pthread_mutex_lock(&ssl_pool.mutex);
+    ssl_pool_clear();
+    pthread_mutex_unlock(&ssl_pool.mutex);
+    ssl_session_cache_clear();
+    SSL_CTX_free(ssl_ctx);
+    ssl_ctx = NULL;
+#ifdef HTTP_SSL_NOSIGNAL_BIO
+    BIO_meth_free(ssl_bio_method);
+    ssl_bio_method = NULL;
+#endif
     ERR_free_strings();
-    return retval;
 }
 
-kii_bool_t kii_http_init(void)
+kii_bool_t kii_http_set_connection_pool(
+        kii_uint_t max_connections,
+        kii_uint_t idle_timeout_in_second)
+{
+    kii_bool_t ret;
+    pthread_mutex_lock(&ssl_pool.mutex);
+    ssl_pool.idle_timeout = idle_timeout_in_second;
+    ret = ssl_pool_resize(max_connections);
+    pthread_mutex_unlock(&ssl_pool.mutex);
+    return ret;
+}
+
+kii_bool_t kii_http_set_connect_timeout(
+        kii_uint_t timeout_in_millis)
 {
-    // Nothing to implement.
+    connect_timeout = timeout_in_millis;
     return KII_TRUE;
 }
 
-void kii_http_cleanup(void)
+kii_bool_t kii_http_set_response_compression(kii_bool_t enabled)
+{
+    response_compression = (enabled == KII_TRUE);
+    return KII_TRUE;
+}
+
+void kii_http_get_compression_stats(
+        kii_ulong_t* compressed,
+        kii_ulong_t* decompressed)
+{
+    pthread_mutex_lock(&compression_stats_mutex);
+    *compressed = compressed_bytes;
+    *decompressed = decompressed_bytes;
+    pthread_mutex_unlock(&compression_stats_mutex);
+}
+
+kii_bool_t kii_http_set_transport_profile(kii_transport_profile_t profile)
+{
+    transport_profile = profile;
+    return KII_TRUE;
+}
+
+/* HTTP/2 is not implemented by this adapter. */
+kii_bool_t kii_http_set_http2_multiplexing(kii_uint_t max_concurrent_streams)
 {
-    // Nothing to implement.
+    return (max_concurrent_streams == 0) ? KII_TRUE : KII_FALSE;
 }
 
 kii_bool_t kii_http_execute(
         const kii_char_t* http_method,
         const kii_char_t* url,
-        json_t* request_headers,
-        const kii_char_t* request_body,
+        const kii_http_headers_t* request_headers,
+        const kii_http_body_t* request_body,
         kii_int_t* status_code,
-        json_t** response_headers,
+        prv_kii_resp_headers_t* response_headers,
+        const kii_http_sink_t* response_sink,
         kii_char_t** response_body)
 {
-    http_error_code = request(http_method, url, request_headers, request_body,
-            status_code, response_headers, response_body);
-    return (http_error_code == HTTP_RESULT_OK) ? KII_TRUE : KII_FALSE;
+    http_result_t result = request(http_method, url, request_headers,
+            request_body, status_code, response_headers, response_sink,
+            response_body);
+    return (result == HTTP_RESULT_OK) ? KII_TRUE : KII_FALSE;
 }
  
+
+/* Event driven requests.
+ * Sockets of the requests are non-blocking and watched by epoll owned by
+ * kii_http_async_t. Each request proceeds as a state machine whenever
+ * OpenSSL can make progress without blocking, so that a thread calling
+ * kii_http_async_poll drives any number of requests. */
+typedef enum {
+    SSL_ASYNC_CONNECTING,
+    SSL_ASYNC_HANDSHAKING,
+    SSL_ASYNC_SENDING,
+    SSL_ASYNC_RECEIVING,
+    SSL_ASYNC_DONE
+} ssl_async_state_t;
+
+typedef struct prv_ssl_async_request_t {
+    struct prv_kii_http_async_t* async;
+    ssl_async_state_t state;
+    http_result_t result;
+    http_url_t url;
+    const kii_char_t* method;
+    const kii_http_headers_t* request_headers;
+    const kii_http_body_t* request_body;
+    const kii_http_sink_t* response_sink;
+    ssl_connection_t* conn;
+    kii_int_t reused;
+    struct addrinfo* addresses;
+    struct addrinfo* next_address; /* tried next while connecting */
+    uint32_t events; /* watched by epoll. 0 if not watched. */
+    long deadline; /* of current state in milliseconds */
+    ssl_response_t response;
+    kii_http_completion_t completion;
+    void* userdata;
+    struct prv_ssl_async_request_t* next;
+} prv_ssl_async_request_t;
+
+typedef struct prv_kii_http_async_t {
+    kii_int_t epfd;
+    prv_ssl_async_request_t* requests; /* including finished ones */
+    kii_uint_t count;
+} prv_kii_http_async_t;
+
+static kii_int_t
+ssl_async_watch(prv_ssl_async_request_t* req, uint32_t events)
+{
+    struct epoll_event ev;
+    kii_int_t op = (req->events == 0) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+    if (req->events == events)
+        return 1;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.ptr = req;
+    if (epoll_ctl(req->async->epfd, op, req->conn->sock, &ev) == -1)
+        return 0;
+    req->events = events;
+    return 1;
+}
+
+static void
+ssl_async_unwatch(prv_ssl_async_request_t* req)
+{
+    struct epoll_event ev;
+    if (req->events == 0)
+        return;
+    memset(&ev, 0, sizeof(ev));
+    epoll_ctl(req->async->epfd, EPOLL_CTL_DEL, req->conn->sock, &ev);
+    req->events = 0;
+}
+
+/* Watch socket as OpenSSL wants after non-blocking call returned r.
+ * Error queue of the thread must be cleared before the call, as errors
+ * left by other connections make SSL_get_error report SSL_ERROR_SSL.
+ * Returns 0 if r is an error other than WANT_READ or WANT_WRITE. */
+static kii_int_t
+ssl_async_want(prv_ssl_async_request_t* req, kii_int_t r)
+{
+    switch (SSL_get_error(req->conn->reader.ssl, r))
+    {
+        case SSL_ERROR_WANT_READ:
+            return ssl_async_watch(req, EPOLLIN);
+        case SSL_ERROR_WANT_WRITE:
+            return ssl_async_watch(req, EPOLLOUT);
+        default:
+            return 0;
+    }
+}
+
+static void
+ssl_async_finish(prv_ssl_async_request_t* req, http_result_t result)
+{
+    if (req->conn != NULL)
+    {
+        ssl_async_unwatch(req);
+        /* connections in the pool are used in blocking manner. */
+        if (result == HTTP_RESULT_OK && req->response.keep_alive &&
+                socket_set_blocking(req->conn->sock, 1))
+            ssl_pool_release(req->conn);
+        else
+            ssl_connection_close(req->conn);
+        req->conn = NULL;
+    }
+    if (req->addresses != NULL)
+    {
+        freeaddrinfo(req->addresses);
+        req->addresses = NULL;
+    }
+    req->result = result;
+    req->state = SSL_ASYNC_DONE;
+}
+
+/* Format whole request in write buffer to send it by a SSL_write. */
+static void
+ssl_async_send(prv_ssl_async_request_t* req)
+{
+    ssl_writer_t* writer = &req->conn->writer;
+    /* body is not streamed since producer can't wait for socket. */
+    if (ssl_format_request(writer, req->method, &req->url,
+                req->request_headers, ssl_pool_enabled()) != HTTP_RESULT_OK ||
+            ssl_body_stream_produce(writer, req->request_body, 0) !=
+            HTTP_RESULT_OK)
+    {
+        ssl_async_finish(req, HTTP_RESULT_ERROR_INTERNAL);
+        return;
+    }
+    req->state = SSL_ASYNC_SENDING;
+    req->deadline = clock_now_ms() + HTTP_EXCONFIG_READTIMEOUT * 1000L;
+}
+
+/* Start request on pooled connection or new one. */
+static void
+ssl_async_start(prv_ssl_async_request_t* req)
+{
+    ssl_response_init(&req->response, req->method, req->response_sink);
+    req->conn = ssl_pool_acquire(&req->url);
+    req->reused = (req->conn != NULL);
+    if (req->conn != NULL)
+    {
+        if (socket_set_blocking(req->conn->sock, 0))
+            ssl_async_send(req);
+        else
+            ssl_async_finish(req, HTTP_RESULT_ERROR_INTERNAL);
+        return;
+    }
+    if (ssl_connection_new(&req->url, &req->conn) != HTTP_RESULT_OK)
+    {
+        ssl_async_finish(req, HTTP_RESULT_ERROR_INTERNAL);
+        return;
+    }
+    /* FIXME: name resolution blocks. */
+    if (req->addresses == NULL &&
+            !socket_resolve(&req->url, &req->addresses))
+    {
+        ssl_async_finish(req, HTTP_RESULT_ERROR_CONNECTSERVER);
+        return;
+    }
+    req->next_address = req->addresses;
+    req->state = SSL_ASYNC_CONNECTING;
+    req->deadline = clock_now_ms() + (long)connect_timeout;
+}
+
+/* closed is set if connection is closed or reset before any byte of
+ * response. */
+static void
+ssl_async_fail(
+        prv_ssl_async_request_t* req,
+        http_result_t result,
+        kii_int_t closed)
+{
+    if (req->reused && ssl_request_retryable(req->method, result, closed))
+    {
+        /* server closed pooled connection before responding.
+         * retry with new connection. */
+        ssl_async_unwatch(req);
+        ssl_connection_close(req->conn);
+        req->conn = NULL;
+        ssl_response_dispose(&req->response);
+        ssl_async_start(req);
+        return;
+    }
+    ssl_async_finish(req, result);
+}
+
+/* Try addresses of the host in order.
+ * FIXME: unlike socket_connect, an attempt is not raced with the next
+ * address, so an unreachable address takes up connect timeout.
+ * Returns 1 if connected, 0 if waiting, or -1 if all addresses failed. */
+static kii_int_t
+ssl_async_connect(prv_ssl_async_request_t* req)
+{
+    ssl_connection_t* conn = req->conn;
+    while (1)
+    {
+        if (conn->sock >= 0)
+        {
+            struct pollfd pfd;
+            int error = 0;
+            socklen_t errlen = sizeof(error);
+            pfd.fd = conn->sock;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+            if (poll(&pfd, 1, 0) == 0)
+                return ssl_async_watch(req, EPOLLOUT) ? 0 : -1;
+            if (getsockopt(conn->sock, SOL_SOCKET, SO_ERROR, &error,
+                        &errlen) == 0 && error == 0)
+                return 1;
+            /* failed. try next address. */
+            ssl_async_unwatch(req);
+            socket_close(conn->sock);
+            conn->sock = -1;
+        }
+        if (req->next_address == NULL)
+            return -1;
+        {
+            kii_int_t connected = 0;
+            conn->sock = socket_start_connect(req->next_address, &connected);
+            req->next_address = req->next_address->ai_next;
+        }
+    }
+}
+
+/* Proceed request as far as possible without blocking. */
+static void
+ssl_async_step(prv_ssl_async_request_t* req)
+{
+    while (req->state != SSL_ASYNC_DONE)
+    {
+        ssl_connection_t* conn = req->conn;
+        http_result_t result;
+        kii_int_t r;
+        switch (req->state)
+        {
+            case SSL_ASYNC_CONNECTING:
+                r = ssl_async_connect(req);
+                if (r == 0)
+                    return;
+                else if (r < 0)
+                    ssl_async_finish(req, HTTP_RESULT_ERROR_CONNECTSERVER);
+                else if (ssl_connection_attach(conn) != 1)
+                    ssl_async_finish(req, HTTP_RESULT_ERROR_CONNECTSSLSERVER);
+                else
+                    req->state = SSL_ASYNC_HANDSHAKING;
+                break;
+            case SSL_ASYNC_HANDSHAKING:
+                ERR_clear_error();
+                r = SSL_connect(conn->reader.ssl);
+                if (r == 1)
+                {
+                    M_KII_DEBUG(prv_log("ssl session reused: %d",
+                                SSL_session_reused(conn->reader.ssl)));
+                    ssl_async_send(req);
+                }
+                else if (!ssl_async_want(req, r))
+                    ssl_async_finish(req, HTTP_RESULT_ERROR_CONNECTSSLSERVER);
+                else
+                    return;
+                break;
+            case SSL_ASYNC_SENDING:
+                /* retried with the same buffer until it is sent. */
+                ERR_clear_error();
+                r = SSL_write(conn->writer.ssl, conn->writer.data,
+                        conn->writer.length);
+                if (r > 0)
+                {
+                    conn->writer.length = 0;
+                    req->state = SSL_ASYNC_RECEIVING;
+                }
+                else if (!ssl_async_want(req, r))
+                    ssl_async_fail(req, HTTP_RESULT_ERROR_SENDING, 0);
+                else
+                    return;
+                break;
+            case SSL_ASYNC_RECEIVING:
+                result = ssl_response_parse(&req->response, &conn->reader);
+                if (result != HTTP_RESULT_OK)
+                {
+                    ssl_async_fail(req, result, 0);
+                    break;
+                }
+                else if (req->response.state == SSL_RESP_DONE)
+                {
+                    ssl_async_finish(req, HTTP_RESULT_OK);
+                    break;
+                }
+                ssl_reader_compact(&conn->reader);
+                ERR_clear_error();
+                r = SSL_read(conn->reader.ssl,
+                        &conn->reader.data[conn->reader.end],
+                        HTTP_EXCONFIG_READBUFFERSIZE - conn->reader.end);
+                if (r > 0)
+                {
+                    conn->reader.end += r;
+                    req->deadline = clock_now_ms() +
+                        HTTP_EXCONFIG_READTIMEOUT * 1000L;
+                }
+                else if (r == 0 || SSL_get_error(conn->reader.ssl, r) ==
+                        SSL_ERROR_ZERO_RETURN)
+                {
+                    kii_int_t closed = ssl_response_untouched(
+                            &req->response, &conn->reader);
+                    result = ssl_response_eof(&req->response);
+                    if (result == HTTP_RESULT_OK)
+                        ssl_async_finish(req, result);
+                    else
+                        ssl_async_fail(req, result, closed);
+                }
+                else if (ssl_connection_reset(conn->reader.ssl, r))
+                    ssl_async_fail(req, HTTP_RESULT_ERROR_RECEIVING,
+                            ssl_response_untouched(&req->response,
+                                &conn->reader));
+                else if (!ssl_async_want(req, r))
+                    ssl_async_fail(req, HTTP_RESULT_ERROR_RECEIVING, 0);
+                else
+                    return;
+                break;
+            default:
+                return;
+        }
+    }
+}
+
+static void
+ssl_async_complete(prv_ssl_async_request_t* req, kii_bool_t succeeded)
+{
+    kii_char_t* body = NULL;
+    if (succeeded == KII_TRUE)
+        ssl_response_finish(&req->response, &body);
+    req->completion(succeeded, req->response.status, &req->response.headers,
+            body, req->userdata);
+    M_KII_FREE_NULLIFY(body);
+    ssl_response_dispose(&req->response);
+    M_KII_FREE_NULLIFY(req);
+}
+
+kii_http_async_t kii_http_async_init(void)
+{
+    prv_kii_http_async_t* async = kii_malloc(sizeof(prv_kii_http_async_t));
+    if (async == NULL)
+        return NULL;
+    async->epfd = epoll_create(HTTP_EXCONFIG_ASYNCMAXEVENTS);
+    if (async->epfd == -1)
+    {
+        M_KII_FREE_NULLIFY(async);
+        return NULL;
+    }
+    async->requests = NULL;
+    async->count = 0;
+    return async;
+}
+
+void kii_http_async_cleanup(kii_http_async_t async)
+{
+    if (async == NULL)
+        return;
+    while (async->requests != NULL)
+    {
+        prv_ssl_async_request_t* req = async->requests;
+        async->requests = req->next;
+        if (req->state != SSL_ASYNC_DONE)
+            ssl_async_finish(req, HTTP_RESULT_ERROR_UNKNOWN);
+        ssl_async_complete(req, KII_FALSE);
+    }
+    close(async->epfd);
+    M_KII_FREE_NULLIFY(async);
+}
+
+kii_bool_t kii_http_async_execute(
+        kii_http_async_t async,
+        const kii_char_t* http_method,
+        const kii_char_t* url,
+        const kii_http_headers_t* request_headers,
+        const kii_http_body_t* request_body,
+        const kii_http_sink_t* response_sink,
+        kii_http_completion_t completion,
+        void* userdata)
+{
+    prv_ssl_async_request_t* req = NULL;
+
+    M_KII_ASSERT(async != NULL);
+    M_KII_ASSERT(completion != NULL);
+
+    M_KII_DEBUG(prv_log("request url: %s", url));
+    M_KII_DEBUG(prv_log("request method: %s", http_method));
+
+    req = kii_malloc(sizeof(prv_ssl_async_request_t));
+    if (req == NULL)
+        return KII_FALSE;
+    memset(req, 0, sizeof(prv_ssl_async_request_t));
+    req->async = async;
+    req->method = http_method;
+    req->request_headers = request_headers;
+    req->request_body = request_body;
+    req->response_sink = response_sink;
+    req->completion = completion;
+    req->userdata = userdata;
+    ssl_response_init(&req->response, http_method, response_sink);
+
+    req->next = async->requests;
+    async->requests = req;
+    ++(async->count);
+
+    /* errors are reported by completion as well. */
+    if (!parse_url(&req->url, url))
+    {
+        ssl_async_finish(req, HTTP_RESULT_ERROR_URLSYNTAX);
+        return KII_TRUE;
+    }
+    ssl_async_start(req);
+    ssl_async_step(req);
+    return KII_TRUE;
+}
+
+kii_uint_t kii_http_async_poll(kii_http_async_t async, kii_int_t timeout_in_ms)
+{
+    struct epoll_event events[HTTP_EXCONFIG_ASYNCMAXEVENTS];
+    prv_ssl_async_request_t* req;
+    prv_ssl_async_request_t* done = NULL;
+    prv_ssl_async_request_t** link;
+    kii_int_t nevents;
+    kii_int_t i;
+    long now;
+
+    M_KII_ASSERT(async != NULL);
+
+    if (async->requests == NULL)
+        return 0;
+    /* wait for sockets, but not beyond deadline of any request. */
+    now = clock_now_ms();
+    for (req = async->requests; req != NULL; req = req->next)
+    {
+        long wait = 0;
+        if (req->state != SSL_ASYNC_DONE && req->deadline > now)
+            wait = req->deadline - now;
+        if (timeout_in_ms < 0 || wait < timeout_in_ms)
+            timeout_in_ms = (kii_int_t)wait;
+    }
+    nevents = epoll_wait(async->epfd, events, HTTP_EXCONFIG_ASYNCMAXEVENTS,
+            timeout_in_ms);
+    for (i = 0; i < nevents; ++i)
+        ssl_async_step((prv_ssl_async_request_t*)events[i].data.ptr);
+
+    now = clock_now_ms();
+    for (req = async->requests; req != NULL; req = req->next)
+    {
+        if (req->state == SSL_ASYNC_DONE || now < req->deadline)
+            continue;
+        if (req->state == SSL_ASYNC_CONNECTING)
+            ssl_async_finish(req, HTTP_RESULT_ERROR_CONNECTSERVER);
+        else if (req->state == SSL_ASYNC_HANDSHAKING)
+            ssl_async_finish(req, HTTP_RESULT_ERROR_CONNECTSSLSERVER);
+        else
+            ssl_async_finish(req, HTTP_RESULT_ERROR_RECEIVING);
+    }
+
+    /* completion may start new requests. They are delivered by next poll. */
+    link = &async->requests;
+    while (*link != NULL)
+    {
+        req = *link;
+        if (req->state == SSL_ASYNC_DONE)
+        {
+            *link = req->next;
+            req->next = done;
+            done = req;
+        }
+        else
+            link = &req->next;
+    }
+    while (done != NULL)
+    {
+        req = done;
+        done = req->next;
+        --(async->count);
+        ssl_async_complete(req,
+                (req->result == HTTP_RESULT_OK) ? KII_TRUE : KII_FALSE);
+    }
+    return async->count;
+}
@@ -10,6 +10,299 @@
 #include "kii_prv_utils.h"
 #include "kii_prv_types.h"
 
+#include <pthread.h>
+#include <zlib.h>
+
+/* level of request body compression.
+ * the fastest one saves most of bytes of repetitive json. */
+#define KII_GZIP_LEVEL 1
+/* compressed data is passed to adapter in this size. */
+#define KII_GZIP_BUFFER_SIZE 4096
+
+/* Result of the last api called on a thread.
+ * Allocated when the thread fails first time, and freed when the thread
+ * exits. */
+typedef struct prv_kii_last_error_t {
+    const prv_kii_app_t* app;
+    kii_ulong_t app_generation; /* generation of app */
+    kii_error_code_t result;
+    kii_error_t error;
+} prv_kii_last_error_t;
+
+static pthread_key_t last_error_key;
+static pthread_once_t last_error_once = PTHREAD_ONCE_INIT;
+static kii_bool_t last_error_key_created = KII_FALSE;
+
+/* Guards request_bytes and request_compressed_bytes of apps. */
+static pthread_mutex_t request_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Guards header_sets of apps and references to the sets. */
+static pthread_mutex_t header_sets_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Guards in_use of request contexts. */
+static pthread_mutex_t req_context_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Generation of the last app initialized. Guarded by app_generation_mutex.
+ */
+static kii_ulong_t app_generation = 0;
+static pthread_mutex_t app_generation_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#define KII_HEADER_APPID "x-kii-appid:"
+#define KII_HEADER_APPKEY "x-kii-appkey:"
+#define KII_HEADER_AUTHORIZATION "authorization:bearer "
+#define KII_HEADER_CONTENT_TYPE "content-type:"
+#define KII_HEADER_IF_MATCH "if-match:"
+#define KII_HEADER_IF_NONE_MATCH_ANY "if-none-match:*"
+
+/* Common headers of requests with the same access token and content type.
+ * Built once and never modified, so that requests in flight share it
+ * regardless of threads. Strings of lines are allocated together with the
+ * set, and the set is freed when the last reference is released. */
+typedef struct prv_kii_header_set_t {
+    kii_uint_t refs; /* guarded by header_sets_mutex */
+    const kii_char_t* access_token; /* in authorization line. NULL if absent */
+    const kii_char_t* content_type; /* in content-type line. NULL if absent */
+    const kii_char_t* lines[5]; /* terminated by NULL */
+} prv_kii_header_set_t;
+
+/* Buffers in which requests are built.
+ * Request context of app is reused by its requests, so that requests after
+ * the buffers are grown don't allocate them. It is used by a request at a
+ * time and the others build in buffers of their own. */
+typedef struct prv_kii_req_context_t {
+    kii_char_t* url;
+    size_t url_capacity;
+    kii_char_t* extra_header; /* if-match */
+    size_t extra_header_capacity;
+    kii_char_t* body; /* used by adapter which buffers request body. */
+    size_t body_capacity;
+    kii_char_t* gzip_pending; /* body up to compression threshold */
+    size_t gzip_pending_capacity;
+    /* reset for each compressed body once it is initialized. */
+    z_stream gzip_stream;
+    kii_bool_t gzip_initialized;
+    kii_bool_t in_use; /* guarded by req_context_mutex */
+    /* disabled while in use. freed by the request using it. guarded by
+     * req_context_mutex. */
+    kii_bool_t detached;
+} prv_kii_req_context_t;
+
+/* Arguments of prv_build_url_with_prefix to build url of request in its
+ * context. */
+#define M_KII_REQ_URL(req) &((req)->context->url), \
+    &((req)->context->url_capacity), (req)->app->base_url, \
+    (req)->app->base_url_length
+
+static void prv_kii_create_last_error_key(void)
+{
+    if (pthread_key_create(&last_error_key, kii_free) == 0) {
+        last_error_key_created = KII_TRUE;
+    }
+}
+
+/* Returns NULL if the calling thread has never failed and create is
+ * KII_FALSE, or if allocation failed. */
+static prv_kii_last_error_t* prv_kii_thread_last_error(kii_bool_t create)
+{
+    prv_kii_last_error_t* last = NULL;
+
+    pthread_once(&last_error_once, prv_kii_create_last_error_key);
+    if (last_error_key_created == KII_FALSE) {
+        return NULL;
+    }
+    last = pthread_getspecific(last_error_key);
+    if (last != NULL || create == KII_FALSE) {
+        return last;
+    }
+    last = kii_malloc(sizeof(prv_kii_last_error_t));
+    if (last == NULL) {
+        return NULL;
+    }
+    kii_memset(last, 0, sizeof(prv_kii_last_error_t));
+    if (pthread_setspecific(last_error_key, last) != 0) {
+        M_KII_FREE_NULLIFY(last);
+    }
+    return last;
+}
+
+/* Copy "name:value" line to dst and returns where next line starts. */
+static kii_char_t* prv_kii_put_header_line(
+        kii_char_t* dst,
+        const kii_char_t* name,
+        size_t name_length,
+        const kii_char_t* value)
+{
+    size_t valueLength = kii_strlen(value);
+
+    kii_memcpy(dst, name, name_length);
+    kii_memcpy(&dst[name_length], value, valueLength + 1);
+    return &dst[name_length + valueLength + 1];
+}
+
+static prv_kii_header_set_t* prv_kii_new_header_set(
+        const prv_kii_app_t* app,
+        const kii_char_t* opt_access_token,
+        const kii_char_t* opt_content_type)
+{
+    prv_kii_header_set_t* set = NULL;
+    kii_char_t* dst = NULL;
+    size_t size = sizeof(prv_kii_header_set_t);
+    kii_int_t i = 0;
+
+    size += sizeof(KII_HEADER_APPID) + kii_strlen(app->app_id);
+    size += sizeof(KII_HEADER_APPKEY) + kii_strlen(app->app_key);
+    if (opt_access_token != NULL) {
+        size += sizeof(KII_HEADER_AUTHORIZATION) +
+            kii_strlen(opt_access_token);
+    }
+    if (opt_content_type != NULL) {
+        size += sizeof(KII_HEADER_CONTENT_TYPE) +
+            kii_strlen(opt_content_type);
+    }
+
+    set = kii_malloc(size);
+    if (set == NULL) {
+        return NULL;
+    }
+    kii_memset(set, 0, sizeof(prv_kii_header_set_t));
+    set->refs = 1;
+
+    dst = (kii_char_t*)&set[1];
+    set->lines[i++] = dst;
+    dst = prv_kii_put_header_line(dst, KII_HEADER_APPID,
+            sizeof(KII_HEADER_APPID) - 1, app->app_id);
+    set->lines[i++] = dst;
+    dst = prv_kii_put_header_line(dst, KII_HEADER_APPKEY,
+            sizeof(KII_HEADER_APPKEY) - 1, app->app_key);
+    if (opt_access_token != NULL) {
+        set->lines[i++] = dst;
+        set->access_token = &dst[sizeof(KII_HEADER_AUTHORIZATION) - 1];
+        dst = prv_kii_put_header_line(dst, KII_HEADER_AUTHORIZATION,
+                sizeof(KII_HEADER_AUTHORIZATION) - 1, opt_access_token);
+    }
+    if (opt_content_type != NULL) {
+        set->lines[i++] = dst;
+        set->content_type = &dst[sizeof(KII_HEADER_CONTENT_TYPE) - 1];
+        dst = prv_kii_put_header_line(dst, KII_HEADER_CONTENT_TYPE,
+                sizeof(KII_HEADER_CONTENT_TYPE) - 1, opt_content_type);
+    }
+    set->lines[i] = NULL;
+    return set;
+}
+
+/* NULL equals to NULL only. */
+static kii_bool_t prv_kii_header_value_equals(
+        const kii_char_t* value1,
+        const kii_char_t* value2)
+{
+    if (value1 == NULL || value2 == NULL) {
+        return (value1 == value2) ? KII_TRUE : KII_FALSE;
+    }
+    return (kii_strncmp(value1, value2, kii_strlen(value1) + 1) == 0) ?
+        KII_TRUE : KII_FALSE;
+}
+
+/* Must be called with header_sets_mutex locked. */
+static void prv_kii_unref_header_set(prv_kii_header_set_t* set)
+{
+    if (set != NULL && --(set->refs) == 0) {
+        M_KII_FREE_NULLIFY(set);
+    }
+}
+
+static void prv_kii_release_header_set(prv_kii_header_set_t* set)
+{
+    pthread_mutex_lock(&header_sets_mutex);
+    prv_kii_unref_header_set(set);
+    pthread_mutex_unlock(&header_sets_mutex);
+}
+
+/* Returns common headers of the request shared with preceding requests of
+ * the app, or newly built ones if app has not cached them yet.
+ * Returned set must be released by prv_kii_release_header_set. */
+static prv_kii_header_set_t* prv_kii_acquire_header_set(
+        prv_kii_app_t* app,
+        const kii_char_t* opt_access_token,
+        const kii_char_t* opt_content_type)
+{
+    prv_kii_header_set_t* set = NULL;
+    kii_uint_t i = 0;
+
+    pthread_mutex_lock(&header_sets_mutex);
+    for (i = 0; i < KII_HEADER_SETS; ++i) {
+        set = app->header_sets[i];
+        if (set != NULL &&
+                prv_kii_header_value_equals(set->access_token,
+                    opt_access_token) == KII_TRUE &&
+                prv_kii_header_value_equals(set->content_type,
+                    opt_content_type) == KII_TRUE) {
+            ++(set->refs);
+            pthread_mutex_unlock(&header_sets_mutex);
+            return set;
+        }
+    }
+    pthread_mutex_unlock(&header_sets_mutex);
+
+    /* built outside of lock. if other thread builds the same set at the
+     * same time, both of them are cached and used. */
+    set = prv_kii_new_header_set(app, opt_access_token, opt_content_type);
+    if (set == NULL) {
+        return NULL;
+    }
+    pthread_mutex_lock(&header_sets_mutex);
+    /* requests in flight keep replaced set until they complete. */
+    prv_kii_unref_header_set(app->header_sets[app->next_header_set]);
+    app->header_sets[app->next_header_set] = set;
+    app->next_header_set = (app->next_header_set + 1) % KII_HEADER_SETS;
+    ++(set->refs);
+    pthread_mutex_unlock(&header_sets_mutex);
+    return set;
+}
+
+/* Returns NULL if app has no request context or it is in use. */
+static prv_kii_req_context_t* prv_kii_acquire_req_context(prv_kii_app_t* app)
+{
+    prv_kii_req_context_t* context = NULL;
+
+    pthread_mutex_lock(&req_context_mutex);
+    if (app->req_context != NULL && app->req_context->in_use == KII_FALSE) {
+        context = app->req_context;
+        context->in_use = KII_TRUE;
+    }
+    pthread_mutex_unlock(&req_context_mutex);
+    return context;
+}
+
+static void prv_kii_free_req_buffers(prv_kii_req_context_t* context)
+{
+    M_KII_FREE_NULLIFY(context->url);
+    M_KII_FREE_NULLIFY(context->extra_header);
+    M_KII_FREE_NULLIFY(context->body);
+    M_KII_FREE_NULLIFY(context->gzip_pending);
+    context->url_capacity = 0;
+    context->extra_header_capacity = 0;
+    context->body_capacity = 0;
+    context->gzip_pending_capacity = 0;
+    if (context->gzip_initialized == KII_TRUE) {
+        deflateEnd(&(context->gzip_stream));
+        context->gzip_initialized = KII_FALSE;
+    }
+}
+
+static void prv_kii_release_req_context(prv_kii_req_context_t* context)
+{
+    kii_bool_t detached = KII_FALSE;
+
+    pthread_mutex_lock(&req_context_mutex);
+    context->in_use = KII_FALSE;
+    detached = context->detached;
+    pthread_mutex_unlock(&req_context_mutex);
+    if (detached == KII_TRUE) {
+        prv_kii_free_req_buffers(context);
+        M_KII_FREE_NULLIFY(context);
+    }
+}
+
 kii_error_code_t kii_global_init(void)
 {
     kii_bool_t r = kii_http_init();
@@ -18,9 +311,58 @@ kii_error_code_t kii_global_init(void)
 
 void kii_global_cleanup(void)
 {
+    prv_kii_last_error_t* last = prv_kii_thread_last_error(KII_FALSE);
+
+    /* other threads free theirs when they exit. */
+    if (last != NULL) {
+        pthread_setspecific(last_error_key, NULL);
+        M_KII_FREE_NULLIFY(last);
+    }
     kii_http_cleanup();
 }
 
+kii_error_code_t kii_global_set_connection_pool(
+        kii_uint_t max_connections,
+        kii_uint_t idle_timeout_in_second)
+{
+    kii_bool_t r = kii_http_set_connection_pool(max_connections,
+            idle_timeout_in_second);
+    return ((r == KII_TRUE) ? KIIE_OK : KIIE_LOWMEMORY);
+}
+
+kii_error_code_t kii_global_set_connect_timeout(kii_uint_t timeout_in_millis)
+{
+    kii_bool_t r = kii_http_set_connect_timeout(timeout_in_millis);
+    return ((r == KII_TRUE) ? KIIE_OK : KIIE_FAIL);
+}
+
+kii_error_code_t kii_global_set_response_compression(kii_bool_t enabled)
+{
+    kii_bool_t r = kii_http_set_response_compression(enabled);
+    return ((r == KII_TRUE) ? KIIE_OK : KIIE_FAIL);
+}
+
+kii_error_code_t kii_global_set_http2_multiplexing(
+        kii_uint_t max_concurrent_streams)
+{
+    kii_bool_t r = kii_http_set_http2_multiplexing(max_concurrent_streams);
+    return ((r == KII_TRUE) ? KIIE_OK : KIIE_FAIL);
+}
+
+kii_error_code_t kii_global_set_transport_profile(
+        kii_transport_profile_t profile)
+{
+    kii_bool_t r = kii_http_set_transport_profile(profile);
+    return ((r == KII_TRUE) ? KIIE_OK : KIIE_FAIL);
+}
+
+void kii_global_get_compression_stats(kii_compression_stats_t* out_stats)
+{
+    M_KII_ASSERT(out_stats != NULL);
+    kii_http_get_compression_stats(&(out_stats->compressed_bytes),
+            &(out_stats->decompressed_bytes));
+}
+
 void kii_dispose_kii_char(kii_char_t* char_ptr)
 {
     M_KII_FREE_NULLIFY(char_ptr);
@@ -50,7 +392,17 @@ kii_app_t kii_init_app(const kii_char_t* app_id,
     if (app == NULL) {
         return app;
     }
-    app->last_result = KIIE_OK;
+    app->async = NULL;
+    app->disposing = KII_FALSE;
+    app->compress_threshold = 0;
+    app->request_bytes = 0;
+    app->request_compressed_bytes = 0;
+    kii_memset(app->header_sets, 0, sizeof(app->header_sets));
+    app->next_header_set = 0;
+    app->req_context = NULL;
+    pthread_mutex_lock(&app_generation_mutex);
+    app->generation = ++app_generation;
+    pthread_mutex_unlock(&app_generation_mutex);
     app->app_id = kii_strdup(app_id);
     if (app->app_id == NULL) {
         M_KII_FREE_NULLIFY(app);
@@ -72,19 +424,92 @@ kii_app_t kii_init_app(const kii_char_t* app_id,
         return app;
     }
 
+    /* shared by urls of all requests. */
+    app->base_url = prv_build_url(site_url, "apps", app_id, NULL);
+    if (app->base_url == NULL) {
+        M_KII_FREE_NULLIFY(app->app_id);
+        M_KII_FREE_NULLIFY(app->app_key);
+        M_KII_FREE_NULLIFY(app->site_url);
+        M_KII_FREE_NULLIFY(app);
+        return app;
+    }
+    app->base_url_length = kii_strlen(app->base_url);
+
     return app;
 }
 
+void kii_app_set_request_compression(kii_app_t app,
+                                     kii_uint_t threshold_in_bytes)
+{
+    M_KII_ASSERT(app != NULL);
+    app->compress_threshold = threshold_in_bytes;
+}
+
+kii_error_code_t kii_app_set_request_context(kii_app_t app,
+                                             kii_bool_t enabled)
+{
+    prv_kii_req_context_t* context = NULL;
+
+    M_KII_ASSERT(app != NULL);
+    if (enabled == KII_FALSE) {
+        pthread_mutex_lock(&req_context_mutex);
+        context = app->req_context;
+        app->req_context = NULL;
+        if (context != NULL && context->in_use == KII_TRUE) {
+            /* request in flight frees it when it completes. */
+            context->detached = KII_TRUE;
+            context = NULL;
+        }
+        pthread_mutex_unlock(&req_context_mutex);
+        if (context != NULL) {
+            prv_kii_free_req_buffers(context);
+            M_KII_FREE_NULLIFY(context);
+        }
+        return KIIE_OK;
+    }
+    if (app->req_context == NULL) {
+        context = kii_malloc(sizeof(prv_kii_req_context_t));
+        if (context == NULL) {
+            return KIIE_LOWMEMORY;
+        }
+        kii_memset(context, 0, sizeof(prv_kii_req_context_t));
+        pthread_mutex_lock(&req_context_mutex);
+        app->req_context = context;
+        pthread_mutex_unlock(&req_context_mutex);
+    }
+    return KIIE_OK;
+}
+
+void kii_app_get_request_compression_stats(kii_app_t app,
+                                           kii_compression_stats_t* out_stats)
+{
+    M_KII_ASSERT(app != NULL);
+    M_KII_ASSERT(out_stats != NULL);
+    pthread_mutex_lock(&request_stats_mutex);
+    out_stats->compressed_bytes = app->request_compressed_bytes;
+    out_stats->decompressed_bytes = app->request_bytes;
+    pthread_mutex_unlock(&request_stats_mutex);
+}
+
 kii_error_t* kii_get_last_error(kii_app_t app)
 {
-    switch (app->last_result) {
+    prv_kii_last_error_t* last = prv_kii_thread_last_error(KII_FALSE);
+
+    /* errors of disposed app are not returned for new app allocated at the
+     * same address. */
+    if (last == NULL || last->app != app ||
+            last->app_generation != app->generation) {
+        return NULL;
+    }
+    switch (last->result) {
         case KIIE_OK:
         case KIIE_LOWMEMORY:
         case KIIE_RESPWRITE:
         case KIIE_ADAPTER:
+        case KIIE_TRUNCATED:
             return NULL;
         case KIIE_FAIL:
-            return &(app->last_error);
+            return &(last->error);
         default:
             /* this is programming error. */
             M_KII_ASSERT(0);
@@ -108,24 +533,49 @@ static void prv_kii_set_info_in_error(
     }
 }
 
+/* Kept for each thread, so that threads sharing app don't overwrite
+ * errors of each other. */
 static void prv_kii_set_last_error(
         prv_kii_app_t* app,
         kii_error_code_t error_code,
         kii_error_t* new_error)
 {
+    prv_kii_last_error_t* last = NULL;
+
     M_KII_ASSERT(app != NULL);
-    app->last_result = error_code;
-    if (app != NULL) {
-        prv_kii_set_info_in_error(&(app->last_error),
-              new_error->status_code, new_error->error_code);
-    }
+    /* successful calls on a thread never failed don't need the record. */
+    last = prv_kii_thread_last_error(
+            (error_code == KIIE_FAIL) ? KII_TRUE : KII_FALSE);
+    if (last == NULL) {
+        return;
+    }
+    last->app = app;
+    last->app_generation = app->generation;
+    last->result = error_code;
+    prv_kii_set_info_in_error(&(last->error),
+          new_error->status_code, new_error->error_code);
 }
 
 void kii_dispose_app(kii_app_t app)
 {
+    kii_uint_t i = 0;
+
+    /* cancel requests in flight without notifying. */
+    app->disposing = KII_TRUE;
+    if (app->async != NULL) {
+        kii_http_async_cleanup(app->async);
+        app->async = NULL;
+    }
+    pthread_mutex_lock(&header_sets_mutex);
+    for (i = 0; i < KII_HEADER_SETS; ++i) {
+        prv_kii_unref_header_set(app->header_sets[i]);
+    }
+    pthread_mutex_unlock(&header_sets_mutex);
+    kii_app_set_request_context(app, KII_FALSE);
     M_KII_FREE_NULLIFY(app->app_id);
     M_KII_FREE_NULLIFY(app->app_key);
     M_KII_FREE_NULLIFY(app->site_url);
+    M_KII_FREE_NULLIFY(app->base_url);
     M_KII_FREE_NULLIFY(app);
 }
 
@@ -133,6 +583,7 @@ void kii_dispose_bucket(kii_bucket_t bucket)
 {
     M_KII_FREE_NULLIFY(bucket->bucket_name);
     M_KII_FREE_NULLIFY(bucket->kii_thing_id);
+    M_KII_FREE_NULLIFY(bucket->path);
     M_KII_FREE_NULLIFY(bucket);
 }
 
@@ -140,6 +591,7 @@ void kii_dispose_topic(kii_topic_t topic)
 {
     M_KII_FREE_NULLIFY(topic->topic_name);
     M_KII_FREE_NULLIFY(topic->kii_thing_id);
+    M_KII_FREE_NULLIFY(topic->path);
     M_KII_FREE_NULLIFY(topic);
 }
 
@@ -154,39 +606,16 @@ void kii_dispose_mqtt_endpoint(kii_mqtt_endpoint_t* endpoint)
     M_KII_FREE_NULLIFY(endpoint);
 }
 
-json_t* prv_create_common_header_json_object(
-        const kii_app_t app,
-        const kii_char_t* opt_access_token,
-        const kii_char_t* opt_content_type)
+void kii_dispose_object_results(kii_object_result_t* results, size_t count)
 {
-    json_t* ret = NULL;
-    kii_int_t json_set_result = 0;
-
-    ret = json_object();
-    if (ret == NULL) {
-        return NULL;
-    }
+    size_t i = 0;
 
-    json_set_result = 0;
-    json_set_result |= json_object_set_new(ret, "x-kii-appid",
-            json_string(app->app_id));
-    json_set_result |= json_object_set_new(ret, "x-kii-appkey",
-            json_string(app->app_key));
-    if (opt_access_token != NULL) {
-        kii_char_t tmp[1024];
-        sprintf(tmp, "bearer %s", opt_access_token);
-        json_set_result |= json_object_set_new(ret, "authorization",
-                json_string(tmp));
-    }
-    if (opt_content_type != NULL) {
-        json_set_result |= json_object_set_new(ret, "content-type",
-                json_string(opt_content_type));
-    }
-    if (json_set_result != 0) {
-        json_decref(ret);
-        return NULL;
+    for (i = 0; i < count; ++i) {
+        M_KII_FREE_NULLIFY(results[i].object_id);
+        M_KII_FREE_NULLIFY(results[i].etag);
+        json_decref(results[i].contents);
+        results[i].contents = NULL;
     }
-    return ret;
 }
 
 kii_error_code_t prv_parse_response_error_code(
@@ -200,13 +629,12 @@ kii_error_code_t prv_parse_response_error_code(
 
     if (response_body != NULL) {
         json_error_t jErr;
+        /* body which is not json, such as error page of proxy, is used as
+         * error code as is. */
         errJson = json_loads(response_body, 0, &jErr);
-        if (errJson == NULL) {
-            return KIIE_LOWMEMORY;
-        }
     }
     errorCodeJson = json_object_get(errJson, "errorCode");
-    if (errorCodeJson != NULL) {
+    if (json_string_value(errorCodeJson) != NULL) {
         error_code = json_string_value(errorCodeJson);
     } else {
         error_code = response_body;
@@ -248,7 +676,7 @@ static kii_error_code_t prv_prepare_register_thing_request_data(
         const kii_char_t* thing_password,
         const kii_char_t* opt_thing_type,
         const json_t* user_data,
-        kii_char_t** out_string)
+        json_t** out_json)
 {
     kii_error_code_t ret = KIIE_FAIL;
     json_t* reqJson = NULL;
@@ -273,8 +701,9 @@ static kii_error_code_t prv_prepare_register_thing_request_data(
         goto ON_EXIT;
     }
 
-    *out_string = json_dumps(reqJson, 0);
-    ret = (*out_string == NULL) ? KIIE_LOWMEMORY : KIIE_OK;
+    *out_json = reqJson;
+    reqJson = NULL;
+    ret = KIIE_OK;
 
 ON_EXIT:
     json_decref(reqJson);
@@ -282,204 +711,624 @@ ON_EXIT:
     return ret;
 }
 
-static kii_error_code_t prv_parse_register_thing_response(
+/* Request to Kii Cloud.
+ * Prepared by prv_prepare_xxx functions and executed by prv_kii_execute or
+ * prv_kii_execute_async. Output parameters of the api are kept here so that
+ * the response can be parsed after asynchronous completion. */
+typedef struct prv_kii_req_t prv_kii_req_t;
+
+typedef kii_error_code_t (*prv_kii_resp_parser_t)(
+        prv_kii_req_t* req,
         kii_int_t respCode,
+        const prv_kii_resp_headers_t* respHdr,
         const kii_char_t* respData,
-        kii_thing_t* out_thing,
-        kii_char_t** out_access_token,
-        kii_error_t* err)
+        kii_error_t* err);
+
+struct prv_kii_req_t {
+    prv_kii_app_t* app;
+    const kii_char_t* method;
+    /* request context of app, or own_buffers if it is disabled or in use. */
+    prv_kii_req_context_t* context;
+    prv_kii_req_context_t own_buffers;
+    kii_char_t* url; /* in context */
+    prv_kii_header_set_t* header_set;
+    /* if-match in context or if-none-match. */
+    const kii_char_t* extra_header;
+    kii_http_headers_t http_headers;
+    json_t* body;
+    /* serialized json sent instead of body. owned by caller. */
+    const kii_char_t* raw_body;
+    size_t raw_body_length;
+    kii_http_body_t http_body;
+    kii_uint_t compress_threshold; /* 0 if body is not compressed. */
+    prv_kii_resp_parser_t parser;
+    /* successful response is parsed as json while it is received. */
+    kii_bool_t json_response;
+    prv_kii_json_parser_t resp_json;
+    kii_http_sink_t resp_sink;
+
+    kii_thing_t* out_thing;
+    kii_char_t** out_access_token;
+    kii_char_t** out_object_id;
+    kii_char_t** out_etag;
+    json_t** out_contents;
+    kii_char_t* out_buffer; /* receives response not parsed as json. */
+    size_t out_buffer_size;
+    size_t* out_length;
+    kii_char_t* out_etag_buffer;
+    kii_bool_t* out_is_subscribed;
+    kii_char_t** out_installation_id;
+    kii_mqtt_endpoint_t** out_endpoint;
+    kii_uint_t* out_retry_after_in_second;
+
+    kii_callback_t callback;
+    void* userdata;
+};
+
+static void prv_kii_init_req(
+        prv_kii_req_t* req,
+        kii_app_t app,
+        const kii_char_t* method,
+        prv_kii_resp_parser_t parser)
 {
-    kii_error_code_t ret = KIIE_FAIL;
-    json_t* respJson = NULL;
-    json_error_t jErr;
-
-    if (respCode < 200 || respCode >= 300) {
-        ret = prv_parse_response_error_code(respCode, respData, err);
-        goto ON_EXIT;
+    kii_memset(req, 0, sizeof(prv_kii_req_t));
+    req->app = app;
+    req->method = method;
+    req->parser = parser;
+    req->context = prv_kii_acquire_req_context(app);
+    if (req->context == NULL) {
+        req->context = &(req->own_buffers);
     }
+}
+
+static void prv_kii_dispose_req_data(prv_kii_req_t* req)
+{
+    if (req->context == &(req->own_buffers)) {
+        prv_kii_free_req_buffers(req->context);
+    } else if (req->context != NULL) {
+        prv_kii_release_req_context(req->context);
+    }
+    req->context = NULL;
+    req->url = NULL;
+    prv_kii_release_header_set(req->header_set);
+    req->header_set = NULL;
+    req->extra_header = NULL;
+    json_decref(req->body);
+    req->body = NULL;
+    req->raw_body = NULL;
+    prv_dispose_json_parser(&(req->resp_json));
+}
 
-    respJson = json_loads(respData, 0, &jErr);
+/* Serialized json passed through gzip on its way to adapter.
+ * Body up to threshold is kept as is and sent without compression. Once
+ * serialized body exceeds threshold, it is compressed while serialization
+ * continues, so that whole body is never held in either form.
+ * Pending body and deflate stream are kept in request context, so that
+ * requests using context of app don't allocate them again. */
+typedef struct prv_kii_gzip_writer_t {
+    prv_kii_req_t* req;
+    kii_http_body_write_t write;
+    void* context;
+    kii_char_t* pending; /* body up to threshold. in request context. */
+    size_t length;
+    size_t total;
+    size_t sent; /* added to stats of app when body is finished. */
+    z_stream* stream; /* in request context. */
+    kii_bool_t deflating;
+} prv_kii_gzip_writer_t;
+
+static int prv_kii_gzip_deflate(
+        prv_kii_gzip_writer_t* gzip,
+        const char* buffer,
+        size_t size,
+        int flush)
+{
+    kii_char_t out[KII_GZIP_BUFFER_SIZE];
+    int r = Z_OK;
+
+    gzip->stream->next_in = (Bytef*)buffer;
+    gzip->stream->avail_in = (uInt)size;
+    do {
+        size_t produced = 0;
+        gzip->stream->next_out = (Bytef*)out;
+        gzip->stream->avail_out = sizeof(out);
+        r = deflate(gzip->stream, flush);
+        if (r != Z_OK && r != Z_STREAM_END && r != Z_BUF_ERROR) {
+            return -1;
+        }
+        produced = sizeof(out) - gzip->stream->avail_out;
+        if (produced > 0 && gzip->write(out, produced, gzip->context) != 0) {
+            return -1;
+        }
+        gzip->sent += produced;
+    } while (gzip->stream->avail_out == 0 ||
+            (flush == Z_FINISH && r != Z_STREAM_END));
+    return 0;
+}
 
-    if (respJson == NULL) {
-        ret = KIIE_LOWMEMORY;
+static int prv_kii_gzip_write(
+        const char* buffer,
+        size_t size,
+        void* context)
+{
+    prv_kii_gzip_writer_t* gzip = (prv_kii_gzip_writer_t*)context;
+    prv_kii_req_context_t* buffers = gzip->req->context;
+    size_t threshold = gzip->req->compress_threshold;
+
+    gzip->total += size;
+    if (gzip->deflating == KII_TRUE) {
+        return prv_kii_gzip_deflate(gzip, buffer, size, Z_NO_FLUSH);
+    }
+    if (gzip->length + size <= threshold) {
+        if (prv_reserve_buffer(&(buffers->gzip_pending),
+                    &(buffers->gzip_pending_capacity), threshold) ==
+                KII_FALSE) {
+            return -1;
+        }
+        gzip->pending = buffers->gzip_pending;
+        kii_memcpy(&(gzip->pending[gzip->length]), buffer, size);
+        gzip->length += size;
+        return 0;
+    }
+
+    if (buffers->gzip_initialized == KII_TRUE) {
+        if (deflateReset(&(buffers->gzip_stream)) != Z_OK) {
+            return -1;
+        }
     } else {
-        const kii_char_t* accessToken = json_string_value(
-                json_object_get(respJson, "_accessToken"));
-        const kii_char_t* thingId = json_string_value(
-                json_object_get(respJson, "_thingID"));
-        if (accessToken != NULL && thingId != NULL) {
-            ret = KIIE_OK;
-            *out_access_token = kii_strdup(accessToken);
-            *out_thing = (kii_thing_t)prv_kii_init_thing(thingId);
-            if (*out_access_token == NULL || *out_thing == NULL) {
-                M_KII_FREE_NULLIFY(*out_access_token);
-                M_KII_FREE_NULLIFY(*out_thing);
-                ret = KIIE_LOWMEMORY;
-            }
-        } else {
-            prv_kii_set_info_in_error(err, (int)respCode, KII_ECODE_PARSE);
-            ret = KIIE_FAIL;
+        /* 15 + 16 means gzip format. */
+        kii_memset(&(buffers->gzip_stream), 0, sizeof(z_stream));
+        if (deflateInit2(&(buffers->gzip_stream), KII_GZIP_LEVEL, Z_DEFLATED,
+                    15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            return -1;
         }
+        buffers->gzip_initialized = KII_TRUE;
+    }
+    gzip->stream = &(buffers->gzip_stream);
+    gzip->deflating = KII_TRUE;
+    /* adapter reads encoding before it frames the body. */
+    gzip->req->http_body.content_encoding = "gzip";
+    if (gzip->length > 0 && prv_kii_gzip_deflate(gzip, gzip->pending,
+                gzip->length, Z_NO_FLUSH) != 0) {
+        return -1;
+    }
+    gzip->length = 0;
+    return prv_kii_gzip_deflate(gzip, buffer, size, Z_NO_FLUSH);
+}
+
+static int prv_kii_dump_body(
+        prv_kii_req_t* req,
+        kii_http_body_write_t write,
+        void* context)
+{
+    if (req->body != NULL) {
+        return json_dump_callback(req->body, write, context, 0);
     }
+    return write(req->raw_body, req->raw_body_length, context);
+}
 
-ON_EXIT:
-    json_decref(respJson);
+static int prv_kii_produce_body(
+        const void* data,
+        kii_http_body_write_t write,
+        void* context)
+{
+    prv_kii_req_t* req = (prv_kii_req_t*)data;
+    prv_kii_gzip_writer_t gzip;
+    int ret = 0;
+
+    /* produced again if adapter retries the request. */
+    req->http_body.content_encoding = NULL;
+    if (req->compress_threshold == 0) {
+        return prv_kii_dump_body(req, write, context);
+    }
+
+    kii_memset(&gzip, 0, sizeof(prv_kii_gzip_writer_t));
+    gzip.req = req;
+    gzip.write = write;
+    gzip.context = context;
+    ret = prv_kii_dump_body(req, prv_kii_gzip_write, &gzip);
+    if (ret == 0) {
+        if (gzip.deflating == KII_TRUE) {
+            ret = prv_kii_gzip_deflate(&gzip, NULL, 0, Z_FINISH);
+        } else if (gzip.length > 0) {
+            ret = write(gzip.pending, gzip.length, context);
+            gzip.sent += gzip.length;
+        }
+    }
+    pthread_mutex_lock(&request_stats_mutex);
+    req->app->request_bytes += gzip.total;
+    req->app->request_compressed_bytes += gzip.sent;
+    pthread_mutex_unlock(&request_stats_mutex);
     return ret;
 }
 
-kii_error_code_t kii_register_thing(kii_app_t app,
-                                    const kii_char_t* vendor_thing_id,
-                                    const kii_char_t* thing_password,
-                                    const kii_char_t* opt_thing_type,
-                                    const json_t* user_data,
-                                    kii_thing_t* out_thing,
-                                    kii_char_t** out_access_token)
+static const kii_http_headers_t* prv_kii_req_headers(prv_kii_req_t* req)
 {
-    kii_char_t *reqUrl = NULL;
-    json_t* headers = NULL;
-    kii_char_t* reqStr = NULL;
-    kii_int_t respCode = 0;
-    kii_char_t* respData = NULL;
-    kii_error_t err;
-    kii_error_code_t ret = KIIE_FAIL;
+    req->http_headers.common = req->header_set->lines;
+    req->http_headers.opt_extra = req->extra_header;
+    return &(req->http_headers);
+}
 
-    M_KII_ASSERT(app != NULL);
-    M_KII_ASSERT(kii_strlen(app->app_id)>0);
-    M_KII_ASSERT(kii_strlen(app->app_key)>0);
-    M_KII_ASSERT(kii_strlen(app->site_url)>0);
-    M_KII_ASSERT(vendor_thing_id != NULL);
-    M_KII_ASSERT(thing_password != NULL);
-    M_KII_ASSERT(out_thing !=NULL);
+/* Request body is serialized by adapter while it is sent.
+ * Returns NULL if the request has no body. */
+static const kii_http_body_t* prv_kii_req_body(prv_kii_req_t* req)
+{
+    if (req->body == NULL && req->raw_body == NULL) {
+        return NULL;
+    }
+    req->http_body.produce = prv_kii_produce_body;
+    req->http_body.data = req;
+    req->http_body.content_encoding = NULL;
+    req->http_body.opt_bytes = NULL;
+    req->http_body.bytes_length = 0;
+    if (req->raw_body != NULL && req->compress_threshold == 0) {
+        req->http_body.opt_bytes = req->raw_body;
+        req->http_body.bytes_length = req->raw_body_length;
+    }
+    req->http_body.opt_buffer = &(req->context->body);
+    req->http_body.opt_capacity = &(req->context->body_capacity);
+    return &(req->http_body);
+}
 
-    kii_memset(&err, 0, sizeof(kii_error_t));
+static void prv_kii_consume_json(
+        const char* buffer,
+        size_t size,
+        void* context)
+{
+    /* error is detected when the parser is finished. */
+    prv_feed_json_parser((prv_kii_json_parser_t*)context, buffer, size);
+}
 
-    /* prepare URL */
-    reqUrl = prv_build_url(app->site_url, "apps", app->app_id, "things",
-            NULL);
-    if (reqUrl == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-    
-    /* prepare headers */
-    headers = prv_create_common_header_json_object(app, NULL,
-            "application/vnd.kii.ThingRegistrationAndAuthorizationRequest+json");
-    if (headers == NULL) {;
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-    
-    /* prepare request data */
-    ret = prv_prepare_register_thing_request_data(vendor_thing_id,
-            thing_password, opt_thing_type, user_data, &reqStr);
-    if (ret != KIIE_OK) {
-        goto ON_EXIT;
-    }
-    if (kii_http_execute("POST", reqUrl, headers, reqStr, &respCode, NULL,
-                    &respData) == KII_FALSE) {
-        ret = KIIE_ADAPTER;
-        goto ON_EXIT;
-    }
+static void prv_kii_discard(
+        const char* buffer,
+        size_t size,
+        void* context)
+{
+    /* successful response is not used unless it is json. */
+    (void)buffer;
+    (void)size;
+    (void)context;
+}
 
-    ret = prv_parse_register_thing_response(respCode, respData, out_thing,
-            out_access_token, &err);
-ON_EXIT:
-    json_decref(headers);
-    M_KII_FREE_NULLIFY(reqStr);
-    M_KII_FREE_NULLIFY(respData);
-    M_KII_FREE_NULLIFY(reqUrl);
+/* Copies response to out_buffer as long as it fits, while counting the
+ * length of whole response. */
+static void prv_kii_copy_to_buffer(
+        const char* buffer,
+        size_t size,
+        void* context)
+{
+    prv_kii_req_t* req = (prv_kii_req_t*)context;
+    size_t length = *(req->out_length);
 
-    prv_kii_set_last_error(app, ret, &err);
+    if (length + 1 < req->out_buffer_size) {
+        size_t copied = req->out_buffer_size - 1 - length;
+        if (copied > size) {
+            copied = size;
+        }
+        kii_memcpy(&(req->out_buffer[length]), buffer, copied);
+    }
+    *(req->out_length) = length + size;
+}
 
-    return ret;
+/* Successful response is parsed while it is received if it is json, or
+ * copied to out_buffer. Otherwise it is discarded instead of being held by
+ * adapter. */
+static const kii_http_sink_t* prv_kii_resp_sink(prv_kii_req_t* req)
+{
+    if (req->out_length != NULL) {
+        *(req->out_length) = 0;
+        req->resp_sink.consume = prv_kii_copy_to_buffer;
+        req->resp_sink.context = req;
+        return &(req->resp_sink);
+    }
+    if (req->json_response == KII_FALSE) {
+        req->resp_sink.consume = prv_kii_discard;
+        req->resp_sink.context = NULL;
+        return &(req->resp_sink);
+    }
+    prv_init_json_parser(&(req->resp_json));
+    req->resp_sink.consume = prv_kii_consume_json;
+    req->resp_sink.context = &(req->resp_json);
+    return &(req->resp_sink);
 }
 
+/* Returns json of successful response or NULL if it is not valid json.
+ * respData is not NULL if adapter returned the body as string instead of
+ * consuming it by the sink. Returned value must be decref'ed. */
+static json_t* prv_kii_resp_json(prv_kii_req_t* req, const kii_char_t* respData)
+{
+    json_error_t jErr;
+    if (respData != NULL) {
+        return json_loads(respData, 0, &jErr);
+    }
+    return prv_finish_json_parser(&(req->resp_json));
+}
 
-kii_bucket_t kii_init_thing_bucket(const kii_thing_t thing,
-                                   const kii_char_t* bucket_name)
+static kii_error_code_t prv_kii_execute(
+        prv_kii_req_t* req,
+        kii_error_code_t prepared)
 {
-    prv_kii_bucket_t* retval = NULL;
-    kii_char_t* thing_id = NULL;
-    kii_char_t* bucket_name_str = NULL;
+    kii_error_code_t ret = prepared;
+    prv_kii_resp_headers_t respHdr;
+    kii_int_t respCode = 0;
+    kii_char_t* respData = NULL;
+    kii_error_t err;
 
-    M_KII_ASSERT(thing != NULL);
-    M_KII_ASSERT(thing->kii_thing_id != NULL);
-    M_KII_ASSERT(kii_strlen(thing->kii_thing_id) > 0);
-    M_KII_ASSERT(bucket_name != NULL);
-    M_KII_ASSERT(kii_strlen(bucket_name) > 0);
-    
-    retval = kii_malloc(sizeof(prv_kii_bucket_t));
-    thing_id = kii_strdup(thing->kii_thing_id);
-    bucket_name_str =  kii_strdup(bucket_name);
+    kii_memset(&err, 0, sizeof(kii_error_t));
 
-    if (retval == NULL || thing_id == NULL ||
-            bucket_name_str == NULL) {
-        M_KII_FREE_NULLIFY(retval);
-        M_KII_FREE_NULLIFY(thing_id);
-        M_KII_FREE_NULLIFY(bucket_name_str);
-        return NULL;
+    if (ret == KIIE_OK) {
+        if (kii_http_execute(req->method, req->url, prv_kii_req_headers(req),
+                    prv_kii_req_body(req), &respCode, &respHdr,
+                    prv_kii_resp_sink(req), &respData) == KII_FALSE) {
+            ret = KIIE_ADAPTER;
+        } else {
+            ret = req->parser(req, respCode, &respHdr, respData, &err);
+        }
     }
-    retval->kii_thing_id = thing_id;
-    retval->bucket_name = bucket_name_str;
-    return retval;
+
+    M_KII_FREE_NULLIFY(respData);
+    prv_kii_dispose_req_data(req);
+
+    prv_kii_set_last_error(req->app, ret, &err);
+
+    return ret;
 }
 
-static kii_error_code_t prv_parse_create_new_object_response(
+static void prv_kii_on_http_completion(
+        kii_bool_t succeeded,
+        kii_int_t status_code,
+        const prv_kii_resp_headers_t* response_headers,
+        kii_char_t* response_body,
+        void* userdata)
+{
+    prv_kii_req_t* req = userdata;
+    prv_kii_app_t* app = req->app;
+    kii_error_code_t ret = KIIE_ADAPTER;
+    kii_error_t err;
+
+    kii_memset(&err, 0, sizeof(kii_error_t));
+
+    /* requests cancelled by kii_dispose_app don't notify. */
+    if (app->disposing == KII_FALSE) {
+        if (succeeded == KII_TRUE) {
+            ret = req->parser(req, status_code, response_headers,
+                    response_body, &err);
+        }
+        prv_kii_set_last_error(app, ret, &err);
+        req->callback(app, ret, req->userdata);
+    }
+
+    prv_kii_dispose_req_data(req);
+    M_KII_FREE_NULLIFY(req);
+}
+
+/* Starts prepared request on async. Request data is moved to the started
+ * request, so that req only needs to be disposed. */
+static kii_error_code_t prv_kii_start_async(
+        prv_kii_req_t* req,
+        kii_http_async_t async,
+        kii_callback_t callback,
+        void* userdata)
+{
+    prv_kii_app_t* app = req->app;
+    prv_kii_req_t* copy = NULL;
+
+    copy = kii_malloc(sizeof(prv_kii_req_t));
+    if (copy == NULL) {
+        return KIIE_LOWMEMORY;
+    }
+    kii_memcpy(copy, req, sizeof(prv_kii_req_t));
+    if (copy->context == &(req->own_buffers)) {
+        copy->context = &(copy->own_buffers);
+    }
+    copy->callback = callback;
+    copy->userdata = userdata;
+    if (kii_http_async_execute(async, copy->method, copy->url,
+                prv_kii_req_headers(copy), prv_kii_req_body(copy),
+                prv_kii_resp_sink(copy),
+                prv_kii_on_http_completion, copy) == KII_FALSE) {
+        M_KII_FREE_NULLIFY(copy);
+        return KIIE_ADAPTER;
+    }
+    /* request data is owned by the copy until completion. */
+    kii_memset(req, 0, sizeof(prv_kii_req_t));
+    req->app = app;
+    return KIIE_OK;
+}
+
+static kii_error_code_t prv_kii_execute_async(
+        prv_kii_req_t* req,
+        kii_error_code_t prepared,
+        kii_callback_t callback,
+        void* userdata)
+{
+    prv_kii_app_t* app = req->app;
+    kii_error_code_t ret = prepared;
+    kii_error_t err;
+
+    M_KII_ASSERT(callback != NULL);
+
+    kii_memset(&err, 0, sizeof(kii_error_t));
+
+    if (ret != KIIE_OK) {
+        goto ON_EXIT;
+    }
+    if (app->async == NULL) {
+        app->async = kii_http_async_init();
+        if (app->async == NULL) {
+            ret = KIIE_LOWMEMORY;
+            goto ON_EXIT;
+        }
+    }
+    ret = prv_kii_start_async(req, app->async, callback, userdata);
+
+ON_EXIT:
+    prv_kii_dispose_req_data(req);
+    prv_kii_set_last_error(app, ret, &err);
+    return ret;
+}
+
+kii_uint_t kii_app_poll(kii_app_t app, kii_int_t timeout_in_ms)
+{
+    M_KII_ASSERT(app != NULL);
+    if (app->async == NULL) {
+        return 0;
+    }
+    return kii_http_async_poll(app->async, timeout_in_ms);
+}
+
+void kii_app_run(kii_app_t app)
+{
+    while (kii_app_poll(app, 1000) > 0) {
+        /* nothing to do. */
+    }
+}
+
+typedef struct prv_kii_batch_t prv_kii_batch_t;
+
+/* Prepares request of index th item in batch. */
+typedef kii_error_code_t (*prv_kii_batch_prepare_t)(
+        prv_kii_req_t* req,
+        const prv_kii_batch_t* batch,
+        size_t index);
+
+/* Requests of batch apis which are run by prv_kii_run_batch. */
+struct prv_kii_batch_t {
+    prv_kii_app_t* app;
+    const kii_char_t* access_token;
+    kii_bucket_t bucket;
+    const void* items; /* array given to batch api. */
+    size_t count;
+    kii_object_result_t* results; /* count results. */
+    prv_kii_batch_prepare_t prepare;
+};
+
+static void prv_kii_on_batch_item(
+        kii_app_t app,
+        kii_error_code_t result,
+        void* userdata)
+{
+    kii_object_result_t* item = userdata;
+    kii_error_t* err = NULL;
+
+    item->result = result;
+    err = kii_get_last_error(app);
+    if (err != NULL) {
+        kii_memcpy(&(item->error), err, sizeof(kii_error_t));
+    }
+}
+
+/* Runs requests of batch on private async so that blocking batch apis are
+ * thread safe like other blocking apis. */
+static kii_error_code_t prv_kii_run_batch(
+        const prv_kii_batch_t* batch,
+        kii_uint_t max_parallel)
+{
+    kii_http_async_t async = NULL;
+    kii_object_result_t* failed = NULL;
+    kii_error_code_t ret = KIIE_OK;
+    kii_error_t err;
+    kii_uint_t inFlight = 0;
+    size_t next = 0;
+    size_t i = 0;
+
+    M_KII_ASSERT(max_parallel > 0);
+    M_KII_ASSERT(batch->count == 0 || batch->results != NULL);
+
+    kii_memset(&err, 0, sizeof(kii_error_t));
+    /* every item is cleared before dispatch so that items failed before
+     * they are sent have no details and outputs. */
+    for (i = 0; i < batch->count; ++i) {
+        kii_object_result_t* item = &(batch->results[i]);
+        item->result = KIIE_OK;
+        kii_memset(&(item->error), 0, sizeof(kii_error_t));
+        item->object_id = NULL;
+        item->etag = NULL;
+        item->contents = NULL;
+    }
+
+    async = kii_http_async_init();
+    if (async == NULL) {
+        ret = KIIE_LOWMEMORY;
+        for (i = 0; i < batch->count; ++i) {
+            batch->results[i].result = ret;
+        }
+        goto ON_EXIT;
+    }
+    while (next < batch->count || inFlight > 0) {
+        while (next < batch->count && inFlight < max_parallel) {
+            prv_kii_req_t req;
+            kii_object_result_t* item = &(batch->results[next]);
+            kii_error_code_t started = batch->prepare(&req, batch, next);
+            if (started == KIIE_OK) {
+                started = prv_kii_start_async(&req, async,
+                        prv_kii_on_batch_item, item);
+            }
+            prv_kii_dispose_req_data(&req);
+            if (started == KIIE_OK) {
+                ++inFlight;
+            } else {
+                item->result = started;
+            }
+            ++next;
+        }
+        inFlight = kii_http_async_poll(async, 1000);
+    }
+    kii_http_async_cleanup(async);
+
+    for (i = 0; i < batch->count; ++i) {
+        if (batch->results[i].result != KIIE_OK) {
+            failed = &(batch->results[i]);
+            ret = failed->result;
+            break;
+        }
+    }
+
+ON_EXIT:
+    prv_kii_set_last_error(batch->app, ret,
+            (failed != NULL) ? &(failed->error) : &err);
+    return ret;
+}
+
+static kii_error_code_t prv_parse_register_thing_response(
+        prv_kii_req_t* req,
         kii_int_t respCode,
+        const prv_kii_resp_headers_t* respHdr,
         const kii_char_t* respData,
-        const json_t* respHdr,
-        kii_char_t** out_object_id,
-        kii_char_t** out_etag,
         kii_error_t* err)
 {
     kii_error_code_t ret = KIIE_FAIL;
     json_t* respJson = NULL;
 
+    (void)respHdr;
     if (respCode < 200 || respCode >= 300) {
         ret = prv_parse_response_error_code(respCode, respData, err);
         goto ON_EXIT;
     }
 
-    /* Check response header */
-    if (out_etag != NULL && respHdr != NULL) {
-        const kii_char_t* etag =
-            json_string_value(json_object_get(respHdr, "etag"));
-        if (etag != NULL) {
-            *out_etag = kii_strdup(etag);
-            if (*out_etag == NULL) {
+    respJson = prv_kii_resp_json(req, respData);
+
+    if (respJson == NULL) {
+        ret = KIIE_LOWMEMORY;
+    } else {
+        const kii_char_t* accessToken = json_string_value(
+                json_object_get(respJson, "_accessToken"));
+        const kii_char_t* thingId = json_string_value(
+                json_object_get(respJson, "_thingID"));
+        if (accessToken != NULL && thingId != NULL) {
+            ret = KIIE_OK;
+            *(req->out_access_token) = kii_strdup(accessToken);
+            *(req->out_thing) = (kii_thing_t)prv_kii_init_thing(thingId);
+            if (*(req->out_access_token) == NULL ||
+                    *(req->out_thing) == NULL) {
+                M_KII_FREE_NULLIFY(*(req->out_access_token));
+                M_KII_FREE_NULLIFY(*(req->out_thing));
                 ret = KIIE_LOWMEMORY;
-                goto ON_EXIT;
             }
         } else {
             prv_kii_set_info_in_error(err, (int)respCode, KII_ECODE_PARSE);
             ret = KIIE_FAIL;
-            goto ON_EXIT;
-        }
-    }
-
-    /* Check response data */
-    if (out_object_id != NULL) {
-        json_error_t jErr;
-        respJson = json_loads(respData, 0, &jErr);
-        if (respJson == NULL) {
-            ret = KIIE_LOWMEMORY;
-            goto ON_EXIT;
-        } else  {
-            const kii_char_t* objectID = json_string_value(json_object_get(
-                    respJson, "objectID"));
-            if (objectID != NULL) {
-                *out_object_id = kii_strdup(objectID);
-                ret = (*out_object_id != NULL) ? KIIE_OK : KIIE_LOWMEMORY;
-                goto ON_EXIT;
-            } else {
-                prv_kii_set_info_in_error(err, (int)respCode, KII_ECODE_PARSE);
-                ret = KIIE_FAIL;
-                goto ON_EXIT;
-            }
         }
-    } else {
-        ret = KIIE_OK;
-        goto ON_EXIT;
     }
 
 ON_EXIT:
@@ -487,83 +1336,176 @@ ON_EXIT:
     return ret;
 }
 
-kii_error_code_t kii_create_new_object(kii_app_t app,
-                                       const kii_char_t* access_token,
-                                       const kii_bucket_t bucket,
-                                       const json_t* contents,
-                                       kii_char_t** out_object_id,
-                                       kii_char_t** out_etag)
+static kii_error_code_t prv_prepare_register_thing(
+        prv_kii_req_t* req,
+        kii_app_t app,
+        const kii_char_t* vendor_thing_id,
+        const kii_char_t* thing_password,
+        const kii_char_t* opt_thing_type,
+        const json_t* user_data,
+        kii_thing_t* out_thing,
+        kii_char_t** out_access_token)
 {
-    kii_char_t *reqUrl = NULL;
-    json_t* headers = NULL;
-    kii_char_t* reqStr = NULL;
-    json_t* respHdr = NULL;
-    kii_int_t respCode = 0;
-    kii_char_t* respData = NULL;
-    kii_error_t err;
-    kii_error_code_t ret = KIIE_FAIL;
-
     M_KII_ASSERT(app != NULL);
     M_KII_ASSERT(kii_strlen(app->app_id)>0);
     M_KII_ASSERT(kii_strlen(app->app_key)>0);
     M_KII_ASSERT(kii_strlen(app->site_url)>0);
-    M_KII_ASSERT(bucket != NULL);
-    M_KII_ASSERT(kii_strlen(bucket->kii_thing_id) > 0);
-    M_KII_ASSERT(kii_strlen(bucket->bucket_name) > 0);
-    M_KII_ASSERT(access_token != NULL);
-    M_KII_ASSERT(contents != NULL);
+    M_KII_ASSERT(vendor_thing_id != NULL);
+    M_KII_ASSERT(thing_password != NULL);
+    M_KII_ASSERT(out_thing !=NULL);
 
-    kii_memset(&err, 0, sizeof(kii_error_t));
+    prv_kii_init_req(req, app, "POST", prv_parse_register_thing_response);
+    req->out_thing = out_thing;
+    req->out_access_token = out_access_token;
+    req->json_response = KII_TRUE;
 
     /* prepare URL */
-    reqUrl = prv_build_url(app->site_url, "apps", app->app_id, "things",
-            bucket->kii_thing_id, "buckets", bucket->bucket_name,
-            "objects", NULL);
-    if (reqUrl == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
+    req->url = prv_build_url_with_prefix(M_KII_REQ_URL(req), NULL, 0,
+            "things", NULL);
+    if (req->url == NULL) {
+        return KIIE_LOWMEMORY;
     }
 
     /* prepare headers */
-    headers = prv_create_common_header_json_object(app, access_token,
-            "application/json");
-    if (headers == NULL) {;
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
+    req->header_set = prv_kii_acquire_header_set(app, NULL,
+            "application/vnd.kii.ThingRegistrationAndAuthorizationRequest+json");
+    if (req->header_set == NULL) {
+        return KIIE_LOWMEMORY;
     }
 
-    reqStr = json_dumps(contents, 0);
-    if (reqStr == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
+    /* prepare request data */
+    return prv_prepare_register_thing_request_data(vendor_thing_id,
+            thing_password, opt_thing_type, user_data, &(req->body));
+}
 
-    if (kii_http_execute("POST", reqUrl, headers, reqStr, &respCode, &respHdr,
-                &respData) == KII_FALSE) {
-        ret = KIIE_ADAPTER;
-        goto ON_EXIT; 
-    }
+kii_error_code_t kii_register_thing(kii_app_t app,
+                                    const kii_char_t* vendor_thing_id,
+                                    const kii_char_t* thing_password,
+                                    const kii_char_t* opt_thing_type,
+                                    const json_t* user_data,
+                                    kii_thing_t* out_thing,
+                                    kii_char_t** out_access_token)
+{
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_register_thing(&req, app,
+            vendor_thing_id, thing_password, opt_thing_type, user_data,
+            out_thing, out_access_token);
+    return prv_kii_execute(&req, ret);
+}
 
-    ret = prv_parse_create_new_object_response(respCode, respData, respHdr,
-            out_object_id, out_etag, &err);
+kii_error_code_t kii_register_thing_async(kii_app_t app,
+                                          const kii_char_t* vendor_thing_id,
+                                          const kii_char_t* thing_password,
+                                          const kii_char_t* opt_thing_type,
+                                          const json_t* user_data,
+                                          kii_thing_t* out_thing,
+                                          kii_char_t** out_access_token,
+                                          kii_callback_t callback,
+                                          void* userdata)
+{
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_register_thing(&req, app,
+            vendor_thing_id, thing_password, opt_thing_type, user_data,
+            out_thing, out_access_token);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
+}
 
-ON_EXIT:
-    M_KII_FREE_NULLIFY(reqUrl);
-    json_decref(headers);
-    M_KII_FREE_NULLIFY(reqStr);
-    json_decref(respHdr);
-    M_KII_FREE_NULLIFY(respData);
+kii_bucket_t kii_init_thing_bucket(const kii_thing_t thing,
+                                   const kii_char_t* bucket_name)
+{
+    prv_kii_bucket_t* retval = NULL;
+    kii_char_t* thing_id = NULL;
+    kii_char_t* bucket_name_str = NULL;
+    kii_char_t* path = NULL;
 
-    prv_kii_set_last_error(app, ret, &err);
+    M_KII_ASSERT(thing != NULL);
+    M_KII_ASSERT(thing->kii_thing_id != NULL);
+    M_KII_ASSERT(kii_strlen(thing->kii_thing_id) > 0);
+    M_KII_ASSERT(bucket_name != NULL);
+    M_KII_ASSERT(kii_strlen(bucket_name) > 0);
+    
+    retval = kii_malloc(sizeof(prv_kii_bucket_t));
+    thing_id = kii_strdup(thing->kii_thing_id);
+    bucket_name_str =  kii_strdup(bucket_name);
+    /* urls of requests for the bucket start with this. */
+    path = prv_build_url("things", thing->kii_thing_id, "buckets",
+            bucket_name, NULL);
 
-    return ret;
+    if (retval == NULL || thing_id == NULL ||
+            bucket_name_str == NULL || path == NULL) {
+        M_KII_FREE_NULLIFY(retval);
+        M_KII_FREE_NULLIFY(thing_id);
+        M_KII_FREE_NULLIFY(bucket_name_str);
+        M_KII_FREE_NULLIFY(path);
+        return NULL;
+    }
+    retval->kii_thing_id = thing_id;
+    retval->bucket_name = bucket_name_str;
+    retval->path = path;
+    retval->path_length = kii_strlen(path);
+    return retval;
 }
 
-static kii_error_code_t prv_parse_create_new_object_with_id_response(
+/* Parse response of the request which returns only status. */
+static kii_error_code_t prv_parse_status_response(
+        prv_kii_req_t* req,
         kii_int_t respCode,
+        const prv_kii_resp_headers_t* respHdr,
+        const kii_char_t* respData,
+        kii_error_t* err)
+{
+    (void)req;
+    (void)respHdr;
+    if (respCode < 200 || respCode >= 300) {
+        return prv_parse_response_error_code(respCode, respData, err);
+    }
+    return KIIE_OK;
+}
+
+/* Parse response of the request which creates resource.
+ * 409 means the resource has been created already. */
+static kii_error_code_t prv_parse_create_status_response(
+        prv_kii_req_t* req,
+        kii_int_t respCode,
+        const prv_kii_resp_headers_t* respHdr,
+        const kii_char_t* respData,
+        kii_error_t* err)
+{
+    (void)req;
+    (void)respHdr;
+    if (respCode < 200 || (respCode >= 300 && respCode != 409)) {
+        return prv_parse_response_error_code(respCode, respData, err);
+    }
+    return KIIE_OK;
+}
+
+/* Parse response of the request checking subscription.
+ * 404 means not subscribed. */
+static kii_error_code_t prv_parse_is_subscribed_response(
+        prv_kii_req_t* req,
+        kii_int_t respCode,
+        const prv_kii_resp_headers_t* respHdr,
+        const kii_char_t* respData,
+        kii_error_t* err)
+{
+    (void)respHdr;
+    if (respCode < 200 || respCode >= 300) {
+        if (respCode == 404) {
+            *(req->out_is_subscribed) = KII_FALSE;
+            return KIIE_OK;
+        }
+        return prv_parse_response_error_code(respCode, respData, err);
+    }
+    *(req->out_is_subscribed) = KII_TRUE;
+    return KIIE_OK;
+}
+
+/* Parse response of the request which updates object and returns etag. */
+static kii_error_code_t prv_parse_etag_response(
+        prv_kii_req_t* req,
+        kii_int_t respCode,
+        const prv_kii_resp_headers_t* respHdr,
         const kii_char_t* respData,
-        const json_t* respHdr,
-        kii_char_t** out_etag,
         kii_error_t* err)
 {
     kii_error_code_t ret = KIIE_FAIL;
@@ -573,12 +1515,10 @@ static kii_error_code_t prv_parse_create_new_object_with_id_response(
     }
 
     /* Check response header */
-    if (out_etag != NULL && respHdr != NULL) {
-        const kii_char_t* etag = json_string_value(json_object_get(respHdr,
-                "etag"));
-        if (etag != NULL) {
-            *out_etag = kii_strdup(etag);
-            if (*out_etag == NULL) {
+    if (req->out_etag != NULL) {
+        if (respHdr->etag[0] != '\0') {
+            *(req->out_etag) = kii_strdup(respHdr->etag);
+            if (*(req->out_etag) == NULL) {
                 ret = KIIE_LOWMEMORY;
             } else {
                 ret = KIIE_OK;
@@ -594,22 +1534,46 @@ static kii_error_code_t prv_parse_create_new_object_with_id_response(
     return ret;
 }
 
-kii_error_code_t kii_create_new_object_with_id(kii_app_t app,
-                                               const kii_char_t* access_token,
-                                               const kii_bucket_t bucket,
-                                               const kii_char_t* object_id,
-                                               const json_t* contents,
-                                               kii_char_t** out_etag)
+/* Contents of object sent by request. Either json or raw is set. */
+typedef struct prv_kii_contents_t {
+    const json_t* json;
+    const kii_char_t* raw; /* serialized json */
+    size_t raw_length;
+} prv_kii_contents_t;
+
+static const prv_kii_contents_t* prv_kii_json_contents(
+        prv_kii_contents_t* contents,
+        const json_t* json)
 {
-    kii_char_t* reqUrl = NULL;
-    json_t* headers = NULL;
-    kii_char_t* reqStr = NULL;
-    json_t* respHdr = NULL;
-    kii_int_t respCode = 0;
-    kii_char_t* respData = NULL;
-    kii_error_t err;
-    kii_error_code_t ret = KIIE_FAIL;
+    M_KII_ASSERT(json != NULL);
+    contents->json = json;
+    contents->raw = NULL;
+    contents->raw_length = 0;
+    return contents;
+}
+
+static const prv_kii_contents_t* prv_kii_raw_contents(
+        prv_kii_contents_t* contents,
+        const kii_char_t* raw,
+        size_t raw_length)
+{
+    M_KII_ASSERT(raw != NULL);
+    contents->json = NULL;
+    contents->raw = raw;
+    contents->raw_length = raw_length;
+    return contents;
+}
 
+static kii_error_code_t prv_prepare_object_request(
+        prv_kii_req_t* req,
+        kii_app_t app,
+        const kii_char_t* method,
+        prv_kii_resp_parser_t parser,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        const kii_char_t* opt_object_id,
+        const prv_kii_contents_t* opt_contents)
+{
     M_KII_ASSERT(app != NULL);
     M_KII_ASSERT(kii_strlen(app->app_id)>0);
     M_KII_ASSERT(kii_strlen(app->app_key)>0);
@@ -618,92 +1582,360 @@ kii_error_code_t kii_create_new_object_with_id(kii_app_t app,
     M_KII_ASSERT(kii_strlen(bucket->kii_thing_id) > 0);
     M_KII_ASSERT(kii_strlen(bucket->bucket_name) > 0);
     M_KII_ASSERT(access_token != NULL);
-    M_KII_ASSERT(object_id != NULL);
-    M_KII_ASSERT(contents != NULL);
 
-    kii_memset(&err, 0, sizeof(kii_error_t));
+    prv_kii_init_req(req, app, method, parser);
 
     /* prepare URL */
-    reqUrl = prv_build_url(app->site_url, "apps", app->app_id, "things",
-            bucket->kii_thing_id, "buckets", bucket->bucket_name,
-            "objects", object_id, NULL);
-    if (reqUrl == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
+    req->url = prv_build_url_with_prefix(M_KII_REQ_URL(req), bucket->path,
+            bucket->path_length, "objects", opt_object_id, NULL);
+    if (req->url == NULL) {
+        return KIIE_LOWMEMORY;
     }
 
     /* prepare headers */
-    headers = prv_create_common_header_json_object(app, access_token,
-            "application/json");
-    if (headers == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    } else {
-        if (json_object_set_new(headers, "if-none-match", json_string("*"))
-                != 0) {
-            ret = KIIE_LOWMEMORY;
-            goto ON_EXIT;
-        }
+    req->header_set = prv_kii_acquire_header_set(app, access_token,
+            (opt_contents != NULL) ? "application/json" : NULL);
+    if (req->header_set == NULL) {
+        return KIIE_LOWMEMORY;
     }
 
-    reqStr = json_dumps(contents, 0);
-    if (reqStr == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-
-    if (kii_http_execute("PUT", reqUrl, headers, reqStr, &respCode, &respHdr,
-                &respData) == KII_FALSE) {
-        ret = KIIE_ADAPTER;
-        goto ON_EXIT; 
+    if (opt_contents != NULL) {
+        /* contents are serialized while they are sent. it must remain
+         * valid until the request completes, as the other arguments. */
+        req->body = json_incref((json_t*)opt_contents->json);
+        req->raw_body = opt_contents->raw;
+        req->raw_body_length = opt_contents->raw_length;
+        req->compress_threshold = app->compress_threshold;
     }
+    return KIIE_OK;
+}
 
-    ret = prv_parse_create_new_object_with_id_response(respCode, respData,
-            respHdr, out_etag, &err);
-
-ON_EXIT:
-    M_KII_FREE_NULLIFY(reqUrl);
-    json_decref(headers);
-    M_KII_FREE_NULLIFY(reqStr);
-    json_decref(respHdr);
-    M_KII_FREE_NULLIFY(respData);
+static kii_error_code_t prv_kii_set_if_match(
+        prv_kii_req_t* req,
+        const kii_char_t* etag)
+{
+    size_t prefixLen = kii_strlen(KII_HEADER_IF_MATCH);
+    size_t etagLen = kii_strlen(etag);
+    prv_kii_req_context_t* context = req->context;
 
-    prv_kii_set_last_error(app, ret, &err);
+    M_KII_ASSERT(etagLen > 0);
 
-    return ret;
+    if (prv_reserve_buffer(&(context->extra_header),
+                &(context->extra_header_capacity),
+                prefixLen + etagLen + 1) == KII_FALSE) {
+        return KIIE_LOWMEMORY;
+    }
+    kii_memcpy(context->extra_header, KII_HEADER_IF_MATCH, prefixLen);
+    kii_memcpy(&(context->extra_header[prefixLen]), etag, etagLen + 1);
+    req->extra_header = context->extra_header;
+    return KIIE_OK;
 }
 
-static kii_error_code_t prv_parse_patch_object_response(
+static kii_error_code_t prv_parse_create_new_object_response(
+        prv_kii_req_t* req,
         kii_int_t respCode,
-        kii_char_t* respData,
-        const json_t* respHdr,
-        kii_char_t** out_etag,
+        const prv_kii_resp_headers_t* respHdr,
+        const kii_char_t* respData,
         kii_error_t* err)
 {
     kii_error_code_t ret = KIIE_FAIL;
+    json_t* respJson = NULL;
 
     if (respCode < 200 || respCode >= 300) {
-        return prv_parse_response_error_code(respCode, respData, err);
+        ret = prv_parse_response_error_code(respCode, respData, err);
+        goto ON_EXIT;
     }
 
     /* Check response header */
-    if (out_etag != NULL && respHdr != NULL) {
-        const kii_char_t* etag = json_string_value(json_object_get(respHdr,
-                "etag"));
-        if (etag != NULL) {
-            *out_etag = kii_strdup(etag);
-            if (*out_etag == NULL) {
+    if (req->out_etag != NULL) {
+        if (respHdr->etag[0] != '\0') {
+            *(req->out_etag) = kii_strdup(respHdr->etag);
+            if (*(req->out_etag) == NULL) {
                 ret = KIIE_LOWMEMORY;
-            } else {
-                ret = KIIE_OK;
+                goto ON_EXIT;
             }
         } else {
             prv_kii_set_info_in_error(err, (int)respCode, KII_ECODE_PARSE);
             ret = KIIE_FAIL;
+            goto ON_EXIT;
         }
     }
 
-    return ret;
+    /* Check response data */
+    if (req->out_object_id != NULL) {
+        respJson = prv_kii_resp_json(req, respData);
+        if (respJson == NULL) {
+            ret = KIIE_LOWMEMORY;
+            goto ON_EXIT;
+        } else  {
+            const kii_char_t* objectID = json_string_value(json_object_get(
+                    respJson, "objectID"));
+            if (objectID != NULL) {
+                *(req->out_object_id) = kii_strdup(objectID);
+                ret = (*(req->out_object_id) != NULL) ?
+                    KIIE_OK : KIIE_LOWMEMORY;
+                goto ON_EXIT;
+            } else {
+                prv_kii_set_info_in_error(err, (int)respCode, KII_ECODE_PARSE);
+                ret = KIIE_FAIL;
+                goto ON_EXIT;
+            }
+        }
+    } else {
+        ret = KIIE_OK;
+        goto ON_EXIT;
+    }
+
+ON_EXIT:
+    json_decref(respJson);
+    return ret;
+}
+
+static kii_error_code_t prv_prepare_create_new_object(
+        prv_kii_req_t* req,
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        const prv_kii_contents_t* contents,
+        kii_char_t** out_object_id,
+        kii_char_t** out_etag)
+{
+    kii_error_code_t ret = KIIE_FAIL;
+
+    ret = prv_prepare_object_request(req, app, "POST",
+            prv_parse_create_new_object_response, access_token, bucket, NULL,
+            contents);
+    req->out_object_id = out_object_id;
+    req->out_etag = out_etag;
+    req->json_response = (out_object_id != NULL) ? KII_TRUE : KII_FALSE;
+    return ret;
+}
+
+kii_error_code_t kii_create_new_object(kii_app_t app,
+                                       const kii_char_t* access_token,
+                                       const kii_bucket_t bucket,
+                                       const json_t* contents,
+                                       kii_char_t** out_object_id,
+                                       kii_char_t** out_etag)
+{
+    prv_kii_req_t req;
+    prv_kii_contents_t body;
+    kii_error_code_t ret = prv_prepare_create_new_object(&req, app,
+            access_token, bucket, prv_kii_json_contents(&body, contents),
+            out_object_id, out_etag);
+    return prv_kii_execute(&req, ret);
+}
+
+kii_error_code_t kii_create_new_object_async(kii_app_t app,
+                                             const kii_char_t* access_token,
+                                             const kii_bucket_t bucket,
+                                             const json_t* contents,
+                                             kii_char_t** out_object_id,
+                                             kii_char_t** out_etag,
+                                             kii_callback_t callback,
+                                             void* userdata)
+{
+    prv_kii_req_t req;
+    prv_kii_contents_t body;
+    kii_error_code_t ret = prv_prepare_create_new_object(&req, app,
+            access_token, bucket, prv_kii_json_contents(&body, contents),
+            out_object_id, out_etag);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
+}
+
+kii_error_code_t kii_create_new_object_raw(kii_app_t app,
+                                           const kii_char_t* access_token,
+                                           const kii_bucket_t bucket,
+                                           const kii_char_t* contents,
+                                           size_t contents_length,
+                                           kii_char_t** out_object_id,
+                                           kii_char_t** out_etag)
+{
+    prv_kii_req_t req;
+    prv_kii_contents_t body;
+    kii_error_code_t ret = prv_prepare_create_new_object(&req, app,
+            access_token, bucket,
+            prv_kii_raw_contents(&body, contents, contents_length),
+            out_object_id, out_etag);
+    return prv_kii_execute(&req, ret);
+}
+
+kii_error_code_t kii_create_new_object_raw_async(
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        const kii_char_t* contents,
+        size_t contents_length,
+        kii_char_t** out_object_id,
+        kii_char_t** out_etag,
+        kii_callback_t callback,
+        void* userdata)
+{
+    prv_kii_req_t req;
+    prv_kii_contents_t body;
+    kii_error_code_t ret = prv_prepare_create_new_object(&req, app,
+            access_token, bucket,
+            prv_kii_raw_contents(&body, contents, contents_length),
+            out_object_id, out_etag);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
+}
+
+static kii_error_code_t prv_prepare_create_new_objects_item(
+        prv_kii_req_t* req,
+        const prv_kii_batch_t* batch,
+        size_t index)
+{
+    const json_t* const* contents = batch->items;
+    kii_object_result_t* item = &(batch->results[index]);
+    prv_kii_contents_t body;
+
+    return prv_prepare_create_new_object(req, batch->app,
+            batch->access_token, batch->bucket,
+            prv_kii_json_contents(&body, contents[index]),
+            &(item->object_id), &(item->etag));
+}
+
+kii_error_code_t kii_create_new_objects(kii_app_t app,
+                                        const kii_char_t* access_token,
+                                        const kii_bucket_t bucket,
+                                        const json_t* const* contents,
+                                        size_t count,
+                                        kii_uint_t max_parallel,
+                                        kii_object_result_t* out_results)
+{
+    prv_kii_batch_t batch;
+
+    M_KII_ASSERT(app != NULL);
+    M_KII_ASSERT(count == 0 || contents != NULL);
+
+    batch.app = app;
+    batch.access_token = access_token;
+    batch.bucket = bucket;
+    batch.items = contents;
+    batch.count = count;
+    batch.results = out_results;
+    batch.prepare = prv_prepare_create_new_objects_item;
+    return prv_kii_run_batch(&batch, max_parallel);
+}
+
+static kii_error_code_t prv_prepare_create_new_object_with_id(
+        prv_kii_req_t* req,
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        const kii_char_t* object_id,
+        const prv_kii_contents_t* contents,
+        kii_char_t** out_etag)
+{
+    kii_error_code_t ret = KIIE_FAIL;
+
+    M_KII_ASSERT(object_id != NULL);
+
+    ret = prv_prepare_object_request(req, app, "PUT", prv_parse_etag_response,
+            access_token, bucket, object_id, contents);
+    req->out_etag = out_etag;
+    if (ret != KIIE_OK) {
+        return ret;
+    }
+    req->extra_header = KII_HEADER_IF_NONE_MATCH_ANY;
+    return KIIE_OK;
+}
+
+kii_error_code_t kii_create_new_object_with_id(kii_app_t app,
+                                               const kii_char_t* access_token,
+                                               const kii_bucket_t bucket,
+                                               const kii_char_t* object_id,
+                                               const json_t* contents,
+                                               kii_char_t** out_etag)
+{
+    prv_kii_req_t req;
+    prv_kii_contents_t body;
+    kii_error_code_t ret = prv_prepare_create_new_object_with_id(&req, app,
+            access_token, bucket, object_id,
+            prv_kii_json_contents(&body, contents), out_etag);
+    return prv_kii_execute(&req, ret);
+}
+
+kii_error_code_t kii_create_new_object_with_id_async(
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        const kii_char_t* object_id,
+        const json_t* contents,
+        kii_char_t** out_etag,
+        kii_callback_t callback,
+        void* userdata)
+{
+    prv_kii_req_t req;
+    prv_kii_contents_t body;
+    kii_error_code_t ret = prv_prepare_create_new_object_with_id(&req, app,
+            access_token, bucket, object_id,
+            prv_kii_json_contents(&body, contents), out_etag);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
+}
+
+kii_error_code_t kii_create_new_object_with_id_raw(
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        const kii_char_t* object_id,
+        const kii_char_t* contents,
+        size_t contents_length,
+        kii_char_t** out_etag)
+{
+    prv_kii_req_t req;
+    prv_kii_contents_t body;
+    kii_error_code_t ret = prv_prepare_create_new_object_with_id(&req, app,
+            access_token, bucket, object_id,
+            prv_kii_raw_contents(&body, contents, contents_length), out_etag);
+    return prv_kii_execute(&req, ret);
+}
+
+kii_error_code_t kii_create_new_object_with_id_raw_async(
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        const kii_char_t* object_id,
+        const kii_char_t* contents,
+        size_t contents_length,
+        kii_char_t** out_etag,
+        kii_callback_t callback,
+        void* userdata)
+{
+    prv_kii_req_t req;
+    prv_kii_contents_t body;
+    kii_error_code_t ret = prv_prepare_create_new_object_with_id(&req, app,
+            access_token, bucket, object_id,
+            prv_kii_raw_contents(&body, contents, contents_length), out_etag);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
+}
+
+static kii_error_code_t prv_prepare_patch_object(
+        prv_kii_req_t* req,
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        const kii_char_t* object_id,
+        const prv_kii_contents_t* patch,
+        const kii_char_t* opt_etag,
+        kii_char_t** out_etag)
+{
+    kii_error_code_t ret = KIIE_FAIL;
+
+    M_KII_ASSERT(object_id != NULL);
+    M_KII_ASSERT(out_etag != NULL);
+
+    ret = prv_prepare_object_request(req, app, "PATCH",
+            prv_parse_etag_response, access_token, bucket, object_id, patch);
+    req->out_etag = out_etag;
+    if (ret != KIIE_OK) {
+        return ret;
+    }
+    if (opt_etag == NULL) {
+        req->extra_header = KII_HEADER_IF_NONE_MATCH_ANY;
+        return KIIE_OK;
+    }
+    return prv_kii_set_if_match(req, opt_etag);
 }
 
 kii_error_code_t kii_patch_object(kii_app_t app,
@@ -714,116 +1946,92 @@ kii_error_code_t kii_patch_object(kii_app_t app,
                                   const kii_char_t* opt_etag,
                                   kii_char_t** out_etag)
 {
-    kii_char_t *reqUrl = NULL;
-    json_t* headers = NULL;
-    kii_char_t* reqStr = NULL;
-    json_t* respHdr = NULL;
-    kii_int_t respCode = 0;
-    kii_char_t* respData = NULL;
-    json_t* respJson = NULL;
-    kii_error_t err;
-    kii_error_code_t ret = KIIE_FAIL;
-
-    M_KII_ASSERT(app != NULL);
-    M_KII_ASSERT(kii_strlen(app->app_id)>0);
-    M_KII_ASSERT(kii_strlen(app->app_key)>0);
-    M_KII_ASSERT(kii_strlen(app->site_url)>0);
-    M_KII_ASSERT(bucket != NULL);
-    M_KII_ASSERT(kii_strlen(bucket->kii_thing_id) > 0);
-    M_KII_ASSERT(kii_strlen(bucket->bucket_name) > 0);
-    M_KII_ASSERT(access_token != NULL);
-    M_KII_ASSERT(object_id != NULL);
-    M_KII_ASSERT(patch != NULL);
-    M_KII_ASSERT(out_etag != NULL);
-
-    kii_memset(&err, 0, sizeof(kii_error_t));
-
-    /* prepare URL */
-    reqUrl = prv_build_url(app->site_url, "apps", app->app_id, "things",
-            bucket->kii_thing_id, "buckets", bucket->bucket_name, "objects",
-            object_id, NULL);
-    if (reqUrl == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-
-    /* prepare headers */
-    headers = prv_create_common_header_json_object(app, access_token,
-            "application/json");
-    if (headers == NULL) {;
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    } else {
-        kii_int_t json_set_result = opt_etag == NULL ?
-            json_object_set_new(headers, "if-none-match", json_string("*")) :
-            json_object_set_new(headers, "if-match", json_string(opt_etag));
-        if (json_set_result != 0) {
-            ret = KIIE_LOWMEMORY;
-            goto ON_EXIT;
-        }
-    }
-
-    reqStr = json_dumps(patch, 0);
-    if (reqStr == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-
-    if (kii_http_execute("PATCH", reqUrl, headers, reqStr, &respCode, &respHdr,
-                &respData) == KII_FALSE) {
-        ret = KIIE_ADAPTER;
-        goto ON_EXIT; 
-    }
-
-    ret = prv_parse_patch_object_response(respCode, respData, respHdr, out_etag,
-            &err);
+    prv_kii_req_t req;
+    prv_kii_contents_t body;
+    kii_error_code_t ret = prv_prepare_patch_object(&req, app, access_token,
+            bucket, object_id, prv_kii_json_contents(&body, patch), opt_etag,
+            out_etag);
+    return prv_kii_execute(&req, ret);
+}
 
-ON_EXIT:
-    M_KII_FREE_NULLIFY(reqUrl);
-    json_decref(headers);
-    M_KII_FREE_NULLIFY(reqStr);
-    json_decref(respHdr);
-    M_KII_FREE_NULLIFY(respData);
-    json_decref(respJson);
+kii_error_code_t kii_patch_object_async(kii_app_t app,
+                                        const kii_char_t* access_token,
+                                        const kii_bucket_t bucket,
+                                        const kii_char_t* object_id,
+                                        const json_t* patch,
+                                        const kii_char_t* opt_etag,
+                                        kii_char_t** out_etag,
+                                        kii_callback_t callback,
+                                        void* userdata)
+{
+    prv_kii_req_t req;
+    prv_kii_contents_t body;
+    kii_error_code_t ret = prv_prepare_patch_object(&req, app, access_token,
+            bucket, object_id, prv_kii_json_contents(&body, patch), opt_etag,
+            out_etag);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
+}
 
-    prv_kii_set_last_error(app, ret, &err);
+kii_error_code_t kii_patch_object_raw(kii_app_t app,
+                                      const kii_char_t* access_token,
+                                      const kii_bucket_t bucket,
+                                      const kii_char_t* object_id,
+                                      const kii_char_t* patch,
+                                      size_t patch_length,
+                                      const kii_char_t* opt_etag,
+                                      kii_char_t** out_etag)
+{
+    prv_kii_req_t req;
+    prv_kii_contents_t body;
+    kii_error_code_t ret = prv_prepare_patch_object(&req, app, access_token,
+            bucket, object_id, prv_kii_raw_contents(&body, patch, patch_length),
+            opt_etag, out_etag);
+    return prv_kii_execute(&req, ret);
+}
 
-    return ret;
+kii_error_code_t kii_patch_object_raw_async(kii_app_t app,
+                                            const kii_char_t* access_token,
+                                            const kii_bucket_t bucket,
+                                            const kii_char_t* object_id,
+                                            const kii_char_t* patch,
+                                            size_t patch_length,
+                                            const kii_char_t* opt_etag,
+                                            kii_char_t** out_etag,
+                                            kii_callback_t callback,
+                                            void* userdata)
+{
+    prv_kii_req_t req;
+    prv_kii_contents_t body;
+    kii_error_code_t ret = prv_prepare_patch_object(&req, app, access_token,
+            bucket, object_id, prv_kii_raw_contents(&body, patch, patch_length),
+            opt_etag, out_etag);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
 }
 
-static kii_error_code_t prv_parse_replace_object_response(
-        kii_int_t respCode,
-        kii_char_t* respData,
-        const json_t* respHdr,
-        kii_char_t** out_etag,
-        kii_error_t* err)
+static kii_error_code_t prv_prepare_replace_object(
+        prv_kii_req_t* req,
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        const kii_char_t* object_id,
+        const prv_kii_contents_t* replace_contents,
+        const kii_char_t* opt_etag,
+        kii_char_t** out_etag)
 {
     kii_error_code_t ret = KIIE_FAIL;
 
-    if (respCode < 200 || respCode >= 300) {
-        return prv_parse_response_error_code(respCode, respData, err);
-    }
+    M_KII_ASSERT(object_id != NULL);
 
-    /* Check response header */
-    if (out_etag != NULL && respHdr != NULL) {
-        const kii_char_t* etag = json_string_value(json_object_get(respHdr,
-                        "etag"));
-        if (etag != NULL) {
-            *out_etag = kii_strdup(etag);
-            if (*out_etag == NULL) {
-                ret = KIIE_LOWMEMORY;
-            } else {
-                ret = KIIE_OK;
-            }
-        } else {
-            prv_kii_set_info_in_error(err, (int)respCode, KII_ECODE_PARSE);
-            ret = KIIE_FAIL;
-        }
-    } else {
-        ret = KIIE_OK;
+    ret = prv_prepare_object_request(req, app, "PUT", prv_parse_etag_response,
+            access_token, bucket, object_id, replace_contents);
+    req->out_etag = out_etag;
+    if (ret != KIIE_OK) {
+        return ret;
     }
-
-    return ret;
+    if (opt_etag != NULL) {
+        return prv_kii_set_if_match(req, opt_etag);
+    }
+    return KIIE_OK;
 }
 
 kii_error_code_t kii_replace_object(kii_app_t app,
@@ -834,124 +2042,170 @@ kii_error_code_t kii_replace_object(kii_app_t app,
                                     const kii_char_t* opt_etag,
                                     kii_char_t** out_etag)
 {
-    kii_char_t* reqUrl = NULL;
-    json_t* headers = NULL;
-    kii_char_t* reqStr = NULL;
-    json_t* respHdr = NULL;
-    kii_int_t respCode = 0;
-    kii_char_t* respData = NULL;
-    kii_error_t err;
-    kii_error_code_t ret = KIIE_FAIL;
-
-    M_KII_ASSERT(app != NULL);
-    M_KII_ASSERT(kii_strlen(app->app_id)>0);
-    M_KII_ASSERT(kii_strlen(app->app_key)>0);
-    M_KII_ASSERT(kii_strlen(app->site_url)>0);
-    M_KII_ASSERT(bucket != NULL);
-    M_KII_ASSERT(kii_strlen(bucket->kii_thing_id) > 0);
-    M_KII_ASSERT(kii_strlen(bucket->bucket_name) > 0);
-    M_KII_ASSERT(access_token != NULL);
-    M_KII_ASSERT(object_id != NULL);
-    M_KII_ASSERT(replace_contents != NULL);
-
-    kii_memset(&err, 0, sizeof(kii_error_t));
-
-    /* prepare URL */
-    reqUrl = prv_build_url(app->site_url, "apps", app->app_id, "things",
-            bucket->kii_thing_id, "buckets", bucket->bucket_name,
-            "objects", object_id, NULL);
-    if (reqUrl == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-
-    /* prepare headers */
-    headers = prv_create_common_header_json_object(app, access_token,
-            "application/json");
-    if (headers == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-    if (opt_etag != NULL) {
-        if (json_object_set_new(headers, "if-match", json_string(opt_etag))
-                != 0) {
-            ret = KIIE_LOWMEMORY;
-            goto ON_EXIT;
-        }
-    }
-    reqStr = json_dumps(replace_contents, 0);
-    if (reqStr == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-
-    if (kii_http_execute("PUT", reqUrl, headers, reqStr, &respCode, &respHdr,
-                &respData) == KII_FALSE) {
-        ret = KIIE_ADAPTER;
-        goto ON_EXIT; 
-    }
+    prv_kii_req_t req;
+    prv_kii_contents_t body;
+    kii_error_code_t ret = prv_prepare_replace_object(&req, app, access_token,
+            bucket, object_id, prv_kii_json_contents(&body, replace_contents),
+            opt_etag, out_etag);
+    return prv_kii_execute(&req, ret);
+}
 
-    ret = prv_parse_replace_object_response(respCode, respData, respHdr,
-            out_etag, &err);
-ON_EXIT:
-    kii_dispose_kii_char(reqUrl);
-    json_decref(headers);
-    kii_dispose_kii_char(reqStr);
-    json_decref(respHdr);
-    kii_dispose_kii_char(respData);
+kii_error_code_t kii_replace_object_async(kii_app_t app,
+                                          const kii_char_t* access_token,
+                                          const kii_bucket_t bucket,
+                                          const kii_char_t* object_id,
+                                          const json_t* replace_contents,
+                                          const kii_char_t* opt_etag,
+                                          kii_char_t** out_etag,
+                                          kii_callback_t callback,
+                                          void* userdata)
+{
+    prv_kii_req_t req;
+    prv_kii_contents_t body;
+    kii_error_code_t ret = prv_prepare_replace_object(&req, app, access_token,
+            bucket, object_id, prv_kii_json_contents(&body, replace_contents),
+            opt_etag, out_etag);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
+}
 
-    prv_kii_set_last_error(app, ret, &err);
+kii_error_code_t kii_replace_object_raw(kii_app_t app,
+                                        const kii_char_t* access_token,
+                                        const kii_bucket_t bucket,
+                                        const kii_char_t* object_id,
+                                        const kii_char_t* replace_contents,
+                                        size_t contents_length,
+                                        const kii_char_t* opt_etag,
+                                        kii_char_t** out_etag)
+{
+    prv_kii_req_t req;
+    prv_kii_contents_t body;
+    kii_error_code_t ret = prv_prepare_replace_object(&req, app, access_token,
+            bucket, object_id,
+            prv_kii_raw_contents(&body, replace_contents, contents_length),
+            opt_etag, out_etag);
+    return prv_kii_execute(&req, ret);
+}
 
-    return ret;
+kii_error_code_t kii_replace_object_raw_async(
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        const kii_char_t* object_id,
+        const kii_char_t* replace_contents,
+        size_t contents_length,
+        const kii_char_t* opt_etag,
+        kii_char_t** out_etag,
+        kii_callback_t callback,
+        void* userdata)
+{
+    prv_kii_req_t req;
+    prv_kii_contents_t body;
+    kii_error_code_t ret = prv_prepare_replace_object(&req, app, access_token,
+            bucket, object_id,
+            prv_kii_raw_contents(&body, replace_contents, contents_length),
+            opt_etag, out_etag);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
 }
 
 static kii_error_code_t prv_parse_get_object_response(
+        prv_kii_req_t* req,
         kii_int_t respCode,
-        const json_t* respHdr,
+        const prv_kii_resp_headers_t* respHdr,
         const kii_char_t* respData,
-        json_t** out_contents,
-        kii_char_t** out_etag,
         kii_error_t* err)
 {
     kii_error_code_t ret = KIIE_FAIL;
-    json_error_t jErr;
 
-    M_KII_ASSERT(out_etag != NULL);
+    M_KII_ASSERT(req->out_etag != NULL);
 
     if (respCode < 200 || respCode >= 300) {
       ret = prv_parse_response_error_code(respCode, respData, err);
       goto ON_EXIT;
     }
 
-    *out_contents = json_loads(respData, 0, &jErr);
-    if (*out_contents == NULL) {
+    *(req->out_contents) = prv_kii_resp_json(req, respData);
+    if (*(req->out_contents) == NULL) {
         ret = KIIE_LOWMEMORY;
         goto ON_EXIT;
     }
 
     /* Check response header */
-    if (respHdr != NULL) {
-        const kii_char_t* etag = json_string_value(json_object_get(respHdr,
-                    "etag"));
-        if (etag != NULL) {
-            *out_etag = kii_strdup(etag);
-            if (*out_etag == NULL) {
-                ret = KIIE_LOWMEMORY;
-            } else {
-                ret = KIIE_OK;
-            }
+    if (respHdr->etag[0] != '\0') {
+        *(req->out_etag) = kii_strdup(respHdr->etag);
+        if (*(req->out_etag) == NULL) {
+            ret = KIIE_LOWMEMORY;
         } else {
-            prv_kii_set_info_in_error(err, (int)respCode, KII_ECODE_PARSE);
-            ret = KIIE_FAIL;
+            ret = KIIE_OK;
         }
     } else {
-        ret = KIIE_OK;
+        prv_kii_set_info_in_error(err, (int)respCode, KII_ECODE_PARSE);
+        ret = KIIE_FAIL;
     }
 
 ON_EXIT:
     return ret;
 }
 
+static kii_error_code_t prv_prepare_get_object(
+        prv_kii_req_t* req,
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        const kii_char_t* object_id,
+        json_t** out_contents,
+        kii_char_t** out_etag)
+{
+    kii_error_code_t ret = KIIE_FAIL;
+
+    M_KII_ASSERT(object_id != NULL);
+    M_KII_ASSERT(out_contents != NULL);
+    M_KII_ASSERT(out_etag != NULL);
+
+    ret = prv_prepare_object_request(req, app, "GET",
+            prv_parse_get_object_response, access_token, bucket, object_id,
+            NULL);
+    req->out_contents = out_contents;
+    req->out_etag = out_etag;
+    req->json_response = KII_TRUE;
+    return ret;
+}
+
+static kii_error_code_t prv_prepare_get_objects_item(
+        prv_kii_req_t* req,
+        const prv_kii_batch_t* batch,
+        size_t index)
+{
+    const kii_char_t* const* objectIds = batch->items;
+    kii_object_result_t* item = &(batch->results[index]);
+
+    return prv_prepare_get_object(req, batch->app, batch->access_token,
+            batch->bucket, objectIds[index], &(item->contents),
+            &(item->etag));
+}
+
+kii_error_code_t kii_get_objects(kii_app_t app,
+                                 const kii_char_t* access_token,
+                                 const kii_bucket_t bucket,
+                                 const kii_char_t* const* object_ids,
+                                 size_t count,
+                                 kii_uint_t max_parallel,
+                                 kii_object_result_t* out_results)
+{
+    prv_kii_batch_t batch;
+
+    M_KII_ASSERT(app != NULL);
+    M_KII_ASSERT(count == 0 || object_ids != NULL);
+
+    batch.app = app;
+    batch.access_token = access_token;
+    batch.bucket = bucket;
+    batch.items = object_ids;
+    batch.count = count;
+    batch.results = out_results;
+    batch.prepare = prv_prepare_get_objects_item;
+    return prv_kii_run_batch(&batch, max_parallel);
+}
+
 kii_error_code_t kii_get_object(kii_app_t app,
                                 const kii_char_t* access_token,
                                 const kii_bucket_t bucket,
@@ -959,239 +2213,272 @@ kii_error_code_t kii_get_object(kii_app_t app,
                                 json_t** out_contents,
                                 kii_char_t** out_etag)
 {
-    kii_char_t *reqUrl = NULL;
-    json_t* headers = NULL;
-    kii_int_t respCode = 0;
-    kii_char_t* respData = NULL;
-    json_t* respHdr = NULL;
-    kii_error_t err;
-    kii_error_code_t ret = KIIE_FAIL;
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_get_object(&req, app, access_token,
+            bucket, object_id, out_contents, out_etag);
+    return prv_kii_execute(&req, ret);
+}
 
-    M_KII_ASSERT(app != NULL);
-    M_KII_ASSERT(kii_strlen(app->app_id)>0);
-    M_KII_ASSERT(kii_strlen(app->app_key)>0);
-    M_KII_ASSERT(kii_strlen(app->site_url)>0);
-    M_KII_ASSERT(bucket != NULL);
-    M_KII_ASSERT(object_id != NULL);
-    M_KII_ASSERT(out_contents != NULL);
-    M_KII_ASSERT(out_etag != NULL);
+kii_error_code_t kii_get_object_async(kii_app_t app,
+                                      const kii_char_t* access_token,
+                                      const kii_bucket_t bucket,
+                                      const kii_char_t* object_id,
+                                      json_t** out_contents,
+                                      kii_char_t** out_etag,
+                                      kii_callback_t callback,
+                                      void* userdata)
+{
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_get_object(&req, app, access_token,
+            bucket, object_id, out_contents, out_etag);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
+}
 
-    kii_memset(&err, 0, sizeof(kii_error_t));
+static kii_error_code_t prv_parse_get_object_raw_response(
+        prv_kii_req_t* req,
+        kii_int_t respCode,
+        const prv_kii_resp_headers_t* respHdr,
+        const kii_char_t* respData,
+        kii_error_t* err)
+{
+    size_t length = 0;
 
-    /* prepare URL */
-    reqUrl = prv_build_url(app->site_url, "apps", app->app_id, "things",
-            bucket->kii_thing_id, "buckets", bucket->bucket_name, "objects",
-            object_id, NULL);
-    if (reqUrl == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
+    if (respCode < 200 || respCode >= 300) {
+        return prv_parse_response_error_code(respCode, respData, err);
     }
 
-    /* prepare headers */
-    headers = prv_create_common_header_json_object(app, access_token, NULL);
-    if (headers == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
+    /* adapter may return the body instead of passing it to sink. */
+    if (respData != NULL) {
+        *(req->out_length) = 0;
+        prv_kii_copy_to_buffer(respData, kii_strlen(respData), req);
     }
-
-    if (kii_http_execute("GET", reqUrl, headers, NULL, &respCode, &respHdr,
-                &respData) == KII_FALSE) {
-        ret = KIIE_ADAPTER;
-        goto ON_EXIT; 
+    if (req->out_etag_buffer != NULL) {
+        kii_memcpy(req->out_etag_buffer, respHdr->etag, KII_ETAG_SIZE);
     }
 
-    ret = prv_parse_get_object_response(respCode, respHdr, respData, out_contents,
-            out_etag, &err);
+    length = *(req->out_length);
+    if (req->out_buffer_size == 0) {
+        return KIIE_TRUNCATED;
+    }
+    if (length >= req->out_buffer_size) {
+        req->out_buffer[req->out_buffer_size - 1] = '\0';
+        return KIIE_TRUNCATED;
+    }
+    req->out_buffer[length] = '\0';
+    return KIIE_OK;
+}
 
-ON_EXIT:
-    M_KII_FREE_NULLIFY(reqUrl);
-    json_decref(headers);
-    M_KII_FREE_NULLIFY(respData);
-    json_decref(respHdr);
+static kii_error_code_t prv_prepare_get_object_raw(
+        prv_kii_req_t* req,
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        const kii_char_t* object_id,
+        kii_char_t* buffer,
+        size_t buffer_size,
+        size_t* out_length,
+        kii_char_t* opt_out_etag)
+{
+    kii_error_code_t ret = KIIE_FAIL;
 
-    prv_kii_set_last_error(app, ret, &err);
+    M_KII_ASSERT(object_id != NULL);
+    M_KII_ASSERT(buffer != NULL || buffer_size == 0);
+    M_KII_ASSERT(out_length != NULL);
 
+    ret = prv_prepare_object_request(req, app, "GET",
+            prv_parse_get_object_raw_response, access_token, bucket,
+            object_id, NULL);
+    req->out_buffer = buffer;
+    req->out_buffer_size = buffer_size;
+    req->out_length = out_length;
+    req->out_etag_buffer = opt_out_etag;
     return ret;
 }
 
-kii_error_code_t kii_delete_object(kii_app_t app,
-                                   const kii_char_t* access_token,
-                                   const kii_bucket_t bucket,
-                                   const kii_char_t* object_id)
+kii_error_code_t kii_get_object_raw(kii_app_t app,
+                                    const kii_char_t* access_token,
+                                    const kii_bucket_t bucket,
+                                    const kii_char_t* object_id,
+                                    kii_char_t* buffer,
+                                    size_t buffer_size,
+                                    size_t* out_length,
+                                    kii_char_t* opt_out_etag)
 {
-    kii_char_t *reqUrl = NULL;
-    json_t* headers = NULL;
-    kii_int_t respCode = 0;
-    kii_char_t* respData = NULL;
-    kii_error_t err;
-    kii_error_code_t ret = KIIE_FAIL;
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_get_object_raw(&req, app,
+            access_token, bucket, object_id, buffer, buffer_size, out_length,
+            opt_out_etag);
+    return prv_kii_execute(&req, ret);
+}
 
-    M_KII_ASSERT(app != NULL);
-    M_KII_ASSERT(kii_strlen(app->app_id)>0);
-    M_KII_ASSERT(kii_strlen(app->app_key)>0);
-    M_KII_ASSERT(kii_strlen(app->site_url)>0);
-    M_KII_ASSERT(bucket != NULL);
-    M_KII_ASSERT(object_id != NULL);
+kii_error_code_t kii_get_object_raw_async(kii_app_t app,
+                                          const kii_char_t* access_token,
+                                          const kii_bucket_t bucket,
+                                          const kii_char_t* object_id,
+                                          kii_char_t* buffer,
+                                          size_t buffer_size,
+                                          size_t* out_length,
+                                          kii_char_t* opt_out_etag,
+                                          kii_callback_t callback,
+                                          void* userdata)
+{
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_get_object_raw(&req, app,
+            access_token, bucket, object_id, buffer, buffer_size, out_length,
+            opt_out_etag);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
+}
 
-    kii_memset(&err, 0, sizeof(kii_error_t));
+static kii_error_code_t prv_prepare_delete_object(
+        prv_kii_req_t* req,
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        const kii_char_t* object_id)
+{
+    M_KII_ASSERT(object_id != NULL);
 
-    /* prepare URL */
-    reqUrl = prv_build_url(app->site_url, "apps", app->app_id, "things",
-            bucket->kii_thing_id, "buckets", bucket->bucket_name, "objects",
-            object_id, NULL);
-    if (reqUrl == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
+    return prv_prepare_object_request(req, app, "DELETE",
+            prv_parse_status_response, access_token, bucket, object_id, NULL);
+}
 
-    /* prepare headers */
-    headers = prv_create_common_header_json_object(app, access_token, NULL);
-    if (headers == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
+kii_error_code_t kii_delete_object(kii_app_t app,
+                                   const kii_char_t* access_token,
+                                   const kii_bucket_t bucket,
+                                   const kii_char_t* object_id)
+{
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_delete_object(&req, app, access_token,
+            bucket, object_id);
+    return prv_kii_execute(&req, ret);
+}
 
-    if (kii_http_execute("DELETE", reqUrl, headers, NULL, &respCode, NULL,
-                &respData) == KII_TRUE) {
-        if (respCode < 200 || respCode >= 300) {
-            ret = prv_parse_response_error_code(respCode, respData, &err);
-            goto ON_EXIT;
-        } else {
-            ret = KIIE_OK;
-        }
-    } else {
-        ret = KIIE_ADAPTER;
-        goto ON_EXIT; 
-    }
+kii_error_code_t kii_delete_object_async(kii_app_t app,
+                                         const kii_char_t* access_token,
+                                         const kii_bucket_t bucket,
+                                         const kii_char_t* object_id,
+                                         kii_callback_t callback,
+                                         void* userdata)
+{
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_delete_object(&req, app, access_token,
+            bucket, object_id);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
+}
 
-ON_EXIT:
-    M_KII_FREE_NULLIFY(reqUrl);
-    json_decref(headers);
-    M_KII_FREE_NULLIFY(respData);
+/* Prepare request which has no body. req is initialized by
+ * prv_kii_init_req and url is built in its buffer. */
+static kii_error_code_t prv_prepare_bodyless_request(
+        prv_kii_req_t* req,
+        const kii_char_t* access_token,
+        kii_char_t* url)
+{
+    req->url = url;
+    if (req->url == NULL) {
+        return KIIE_LOWMEMORY;
+    }
 
-    prv_kii_set_last_error(app, ret, &err);
+    req->header_set = prv_kii_acquire_header_set(req->app, access_token,
+            NULL);
+    if (req->header_set == NULL) {
+        return KIIE_LOWMEMORY;
+    }
+    return KIIE_OK;
+}
 
-    return ret;
+static kii_error_code_t prv_prepare_subscribe_bucket(
+        prv_kii_req_t* req,
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket)
+{
+    prv_kii_init_req(req, app, "POST", prv_parse_create_status_response);
+    return prv_prepare_bodyless_request(req, access_token,
+            prv_build_url_with_prefix(M_KII_REQ_URL(req),
+                          bucket->path,
+                          bucket->path_length,
+                          "filters/all/push/subscriptions/things",
+                          NULL));
 }
 
 kii_error_code_t kii_subscribe_bucket(kii_app_t app,
                                       const kii_char_t* access_token,
                                       const kii_bucket_t bucket)
 {
-    const kii_char_t* thingId = bucket->kii_thing_id;
-    const kii_char_t* bucketName = bucket->bucket_name;
-    kii_char_t* url = NULL;
-    json_t* reqHeaders = NULL;
-    kii_char_t* respBodyStr = NULL;
-    kii_error_t error;
-    kii_error_code_t ret = KIIE_FAIL;
-    kii_int_t respStatus = 0;
-
-    kii_memset(&error, 0, sizeof(kii_error_t));
-
-    /* Prepare Url */
-    url = prv_build_url(app->site_url,
-                        "apps",
-                        app->app_id,
-                        "things",
-                        thingId,
-                        "buckets",
-                        bucketName,
-                        "filters/all/push/subscriptions/things",
-                        NULL);
-    if (url == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-
-    /* Prepare headers */
-    reqHeaders = prv_create_common_header_json_object(app, access_token, NULL);
-    if (reqHeaders == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-
-    if (kii_http_execute("POST", url, reqHeaders, NULL, &respStatus, NULL,
-                &respBodyStr) == KII_TRUE) {
-        if (respStatus < 200 || (respStatus >= 300 && respStatus != 409)) {
-            ret = prv_parse_response_error_code(respStatus, respBodyStr,
-                    &error);
-            goto ON_EXIT;
-        } else {
-            ret = KIIE_OK;
-        }
-    } else {
-        ret = KIIE_ADAPTER;
-        goto ON_EXIT; 
-    }
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_subscribe_bucket(&req, app,
+            access_token, bucket);
+    return prv_kii_execute(&req, ret);
+}
 
-ON_EXIT:
-    M_KII_FREE_NULLIFY(url);
-    json_decref(reqHeaders);
-    M_KII_FREE_NULLIFY(respBodyStr);
+kii_error_code_t kii_subscribe_bucket_async(kii_app_t app,
+                                            const kii_char_t* access_token,
+                                            const kii_bucket_t bucket,
+                                            kii_callback_t callback,
+                                            void* userdata)
+{
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_subscribe_bucket(&req, app,
+            access_token, bucket);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
+}
 
-    prv_kii_set_last_error(app, ret, &error);
-    return ret;
+static kii_error_code_t prv_prepare_unsubscribe_bucket(
+        prv_kii_req_t* req,
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket)
+{
+    prv_kii_init_req(req, app, "DELETE", prv_parse_status_response);
+    return prv_prepare_bodyless_request(req, access_token,
+            prv_build_url_with_prefix(M_KII_REQ_URL(req),
+                          bucket->path,
+                          bucket->path_length,
+                          "filters/all/push/subscriptions/things",
+                          bucket->kii_thing_id,
+                          NULL));
 }
 
 kii_error_code_t kii_unsubscribe_bucket(kii_app_t app,
                                         const kii_char_t* access_token,
                                         const kii_bucket_t bucket)
 {
-    const kii_char_t* thingId = bucket->kii_thing_id;
-    const kii_char_t* bucketName = bucket->bucket_name;
-    kii_char_t* url = NULL;
-    json_t* reqHeaders = NULL;
-    kii_char_t* respBodyStr = NULL;
-    kii_error_t error;
-    kii_error_code_t ret = KIIE_FAIL;
-    kii_int_t respStatus = 0;
-
-    kii_memset(&error, 0, sizeof(kii_error_t));
-
-    /* Prepare Url */
-    url = prv_build_url(app->site_url,
-                        "apps",
-                        app->app_id,
-                        "things",
-                        thingId,
-                        "buckets",
-                        bucketName,
-                        "filters/all/push/subscriptions/things",
-                        thingId,
-                        NULL);
-    if (url == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-
-    /* Prepare headers */
-    reqHeaders = prv_create_common_header_json_object(app, access_token, NULL);
-    if (reqHeaders == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_unsubscribe_bucket(&req, app,
+            access_token, bucket);
+    return prv_kii_execute(&req, ret);
+}
 
-    if (kii_http_execute("DELETE", url, reqHeaders, NULL, &respStatus, NULL,
-                &respBodyStr) == KII_TRUE) {
-        if (respStatus < 200 || respStatus >= 300) {
-            ret = prv_parse_response_error_code(respStatus, respBodyStr,
-                    &error);
-            goto ON_EXIT;
-        } else {
-            ret = KIIE_OK;
-        }
-    } else {
-        ret = KIIE_ADAPTER;
-        goto ON_EXIT; 
-    }
+kii_error_code_t kii_unsubscribe_bucket_async(kii_app_t app,
+                                              const kii_char_t* access_token,
+                                              const kii_bucket_t bucket,
+                                              kii_callback_t callback,
+                                              void* userdata)
+{
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_unsubscribe_bucket(&req, app,
+            access_token, bucket);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
+}
 
-ON_EXIT:
-    M_KII_FREE_NULLIFY(url);
-    json_decref(reqHeaders);
-    M_KII_FREE_NULLIFY(respBodyStr);
+static kii_error_code_t prv_prepare_is_bucket_subscribed(
+        prv_kii_req_t* req,
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        kii_bool_t* out_is_subscribed)
+{
+    kii_error_code_t ret = KIIE_FAIL;
 
-    prv_kii_set_last_error(app, ret, &error);
+    prv_kii_init_req(req, app, "HEAD", prv_parse_is_subscribed_response);
+    ret = prv_prepare_bodyless_request(req, access_token,
+            prv_build_url_with_prefix(M_KII_REQ_URL(req),
+                          bucket->path,
+                          bucket->path_length,
+                          "filters/all/push/subscriptions/things",
+                          bucket->kii_thing_id,
+                          NULL));
+    req->out_is_subscribed = out_is_subscribed;
     return ret;
 }
 
@@ -1200,67 +2487,24 @@ kii_error_code_t kii_is_bucket_subscribed(kii_app_t app,
                                           const kii_bucket_t bucket,
                                           kii_bool_t* out_is_subscribed)
 {
-    const kii_char_t* thingId = bucket->kii_thing_id;
-    const kii_char_t* bucketName = bucket->bucket_name;
-    kii_char_t* url = NULL;
-    json_t* reqHeaders = NULL;
-    kii_char_t* respBodyStr = NULL;
-    kii_error_t error;
-    kii_error_code_t ret = KIIE_FAIL;
-    kii_int_t respStatus = 0;
-
-    kii_memset(&error, 0, sizeof(kii_error_t));
-
-    /* Prepare Url */
-    url = prv_build_url(app->site_url,
-                        "apps",
-                        app->app_id,
-                        "things",
-                        thingId,
-                        "buckets",
-                        bucketName,
-                        "filters/all/push/subscriptions/things",
-                        thingId,
-                        NULL);
-    if (url == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-
-    /* Prepare headers */
-    reqHeaders = prv_create_common_header_json_object(app, access_token, NULL);
-    if (reqHeaders == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-
-    if (kii_http_execute("HEAD", url, reqHeaders, NULL, &respStatus, NULL,
-                &respBodyStr) == KII_TRUE) {
-        if (respStatus < 200 || respStatus >= 300) {
-            if (respStatus == 404) {
-                *out_is_subscribed = KII_FALSE;
-                ret = KIIE_OK;
-            } else {
-                ret = prv_parse_response_error_code(respStatus, respBodyStr,
-                        &error);
-            }
-            goto ON_EXIT;
-        } else {
-            *out_is_subscribed = KII_TRUE;
-            ret = KIIE_OK;
-        }
-    } else {
-        ret = KIIE_ADAPTER;
-        goto ON_EXIT; 
-    }
-
-ON_EXIT:
-    M_KII_FREE_NULLIFY(url);
-    json_decref(reqHeaders);
-    M_KII_FREE_NULLIFY(respBodyStr);
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_is_bucket_subscribed(&req, app,
+            access_token, bucket, out_is_subscribed);
+    return prv_kii_execute(&req, ret);
+}
 
-    prv_kii_set_last_error(app, ret, &error);
-    return ret;
+kii_error_code_t kii_is_bucket_subscribed_async(
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        kii_bool_t* out_is_subscribed,
+        kii_callback_t callback,
+        void* userdata)
+{
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_is_bucket_subscribed(&req, app,
+            access_token, bucket, out_is_subscribed);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
 }
 
 kii_topic_t kii_init_thing_topic(const kii_thing_t thing,
@@ -1269,6 +2513,7 @@ kii_topic_t kii_init_thing_topic(const kii_thing_t thing,
     prv_kii_topic_t* topic = NULL;
     kii_char_t* tempThingId = NULL;
     kii_char_t* tempTopicName = NULL;
+    kii_char_t* tempPath = NULL;
     
 
     M_KII_ASSERT(thing != NULL);
@@ -1295,192 +2540,158 @@ kii_topic_t kii_init_thing_topic(const kii_thing_t thing,
         return NULL;
     }
 
+    /* urls of requests for the topic start with this. */
+    tempPath = prv_build_url("things", thing->kii_thing_id, "topics",
+            topic_name, NULL);
+    if (tempPath == NULL) {
+        M_KII_FREE_NULLIFY(tempTopicName);
+        M_KII_FREE_NULLIFY(tempThingId);
+        M_KII_FREE_NULLIFY(topic);
+        return NULL;
+    }
+
     topic->kii_thing_id = tempThingId;
     topic->topic_name = tempTopicName;
+    topic->path = tempPath;
+    topic->path_length = kii_strlen(tempPath);
     return topic;
 }
 
+static kii_error_code_t prv_prepare_create_topic(
+        prv_kii_req_t* req,
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_topic_t topic)
+{
+    prv_kii_init_req(req, app, "PUT", prv_parse_create_status_response);
+    return prv_prepare_bodyless_request(req, access_token,
+            prv_build_url_with_prefix(M_KII_REQ_URL(req),
+                          topic->path,
+                          topic->path_length,
+                          NULL));
+}
+
 kii_error_code_t kii_create_topic(kii_app_t app,
                                   const kii_char_t* access_token,
                                   const kii_topic_t topic)
 {
-    const kii_char_t* thingId = topic->kii_thing_id;
-    const kii_char_t* topicName = topic->topic_name;
-    kii_char_t* url = NULL;
-    json_t* reqHeaders = NULL;
-    kii_error_t error;
-    kii_error_code_t ret = KIIE_FAIL;
-    kii_int_t respStatus = 0;
-    kii_char_t* respBodyStr = NULL;
-
-    kii_memset(&error, 0, sizeof(kii_error_t));
-
-    /* Prepare Url */
-    url = prv_build_url(app->site_url,
-                        "apps",
-                        app->app_id,
-                        "things",
-                        thingId,
-                        "topics",
-                        topicName,
-                        NULL);
-    if (url == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-
-    /* Prepare headers */
-    reqHeaders = prv_create_common_header_json_object(app, access_token, NULL);
-    if (reqHeaders == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-
-    if (kii_http_execute("PUT", url, reqHeaders, NULL, &respStatus, NULL,
-                &respBodyStr) == KII_TRUE) {
-        if (respStatus < 200 || (respStatus >= 300 && respStatus != 409)) {
-            ret = prv_parse_response_error_code(respStatus, respBodyStr,
-                    &error);
-            goto ON_EXIT;
-        } else {
-            ret = KIIE_OK;
-        }
-    } else {
-        ret = KIIE_ADAPTER;
-        goto ON_EXIT; 
-    }
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_create_topic(&req, app, access_token,
+            topic);
+    return prv_kii_execute(&req, ret);
+}
 
-ON_EXIT:
-    M_KII_FREE_NULLIFY(url);
-    json_decref(reqHeaders);
-    M_KII_FREE_NULLIFY(respBodyStr);
-    prv_kii_set_last_error(app, ret, &error);
+kii_error_code_t kii_create_topic_async(kii_app_t app,
+                                        const kii_char_t* access_token,
+                                        const kii_topic_t topic,
+                                        kii_callback_t callback,
+                                        void* userdata)
+{
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_create_topic(&req, app, access_token,
+            topic);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
+}
 
-    return ret;
+static kii_error_code_t prv_prepare_subscribe_topic(
+        prv_kii_req_t* req,
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_topic_t topic)
+{
+    prv_kii_init_req(req, app, "POST", prv_parse_create_status_response);
+    return prv_prepare_bodyless_request(req, access_token,
+            prv_build_url_with_prefix(M_KII_REQ_URL(req),
+                          topic->path,
+                          topic->path_length,
+                          "push",
+                          "subscriptions",
+                          "things",
+                          NULL));
 }
 
 kii_error_code_t kii_subscribe_topic(kii_app_t app,
                                      const kii_char_t* access_token,
                                      const kii_topic_t topic)
 {
-    const kii_char_t* thingId = topic->kii_thing_id;
-    const kii_char_t* topicName = topic->topic_name;
-    kii_char_t* url = NULL;
-    json_t* reqHeaders = NULL;
-    kii_error_t error;
-    kii_error_code_t ret = KIIE_FAIL;
-    kii_int_t respStatus = 0;
-    kii_char_t* respBodyStr = NULL;
-
-    kii_memset(&error, 0, sizeof(kii_error_t));
-
-    /* Prepare Url */
-    url = prv_build_url(app->site_url,
-                        "apps",
-                        app->app_id,
-                        "things",
-                        thingId,
-                        "topics",
-                        topicName,
-                        "push",
-                        "subscriptions",
-                        "things",
-                        NULL);
-    if (url == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-
-    /* Prepare headers */
-    reqHeaders = prv_create_common_header_json_object(app, access_token, NULL);
-    if (reqHeaders == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-
-    if (kii_http_execute("POST", url, reqHeaders, NULL, &respStatus, NULL,
-                &respBodyStr) == KII_TRUE) {
-        if (respStatus < 200 || (respStatus >= 300 && respStatus != 409)) {
-            ret = prv_parse_response_error_code(respStatus, respBodyStr,
-                    &error);
-            goto ON_EXIT;
-        } else {
-            ret = KIIE_OK;
-        }
-    } else {
-        ret = KIIE_ADAPTER;
-        goto ON_EXIT; 
-    }
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_subscribe_topic(&req, app,
+            access_token, topic);
+    return prv_kii_execute(&req, ret);
+}
 
-ON_EXIT:
-    M_KII_FREE_NULLIFY(url);
-    json_decref(reqHeaders);
-    M_KII_FREE_NULLIFY(respBodyStr);
-    prv_kii_set_last_error(app, ret, &error);
+kii_error_code_t kii_subscribe_topic_async(kii_app_t app,
+                                           const kii_char_t* access_token,
+                                           const kii_topic_t topic,
+                                           kii_callback_t callback,
+                                           void* userdata)
+{
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_subscribe_topic(&req, app,
+            access_token, topic);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
+}
 
-    return ret;
+static kii_error_code_t prv_prepare_unsubscribe_topic(
+        prv_kii_req_t* req,
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_topic_t topic)
+{
+    prv_kii_init_req(req, app, "DELETE", prv_parse_status_response);
+    return prv_prepare_bodyless_request(req, access_token,
+            prv_build_url_with_prefix(M_KII_REQ_URL(req),
+                          topic->path,
+                          topic->path_length,
+                          "push",
+                          "subscriptions",
+                          "things",
+                          topic->kii_thing_id,
+                          NULL));
 }
 
 kii_error_code_t kii_unsubscribe_topic(kii_app_t app,
                                        const kii_char_t* access_token,
                                        const kii_topic_t topic)
 {
-    const kii_char_t* thingId = topic->kii_thing_id;
-    const kii_char_t* topicName = topic->topic_name;
-    kii_char_t* url = NULL;
-    json_t* reqHeaders = NULL;
-    kii_error_t error;
-    kii_error_code_t ret = KIIE_FAIL;
-    kii_int_t respStatus = 0;
-    kii_char_t* respBodyStr = NULL;
-
-    kii_memset(&error, 0, sizeof(kii_error_t));
-
-    /* Prepare Url */
-    url = prv_build_url(app->site_url,
-                        "apps",
-                        app->app_id,
-                        "things",
-                        thingId,
-                        "topics",
-                        topicName,
-                        "push",
-                        "subscriptions",
-                        "things",
-                        thingId,
-                        NULL);
-    if (url == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-
-    /* Prepare headers */
-    reqHeaders = prv_create_common_header_json_object(app, access_token, NULL);
-    if (reqHeaders == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_unsubscribe_topic(&req, app,
+            access_token, topic);
+    return prv_kii_execute(&req, ret);
+}
 
-    if (kii_http_execute("DELETE", url, reqHeaders, NULL, &respStatus, NULL,
-                &respBodyStr) == KII_TRUE) {
-        if (respStatus < 200 || respStatus >= 300) {
-            ret = prv_parse_response_error_code(respStatus, respBodyStr,
-                    &error);
-            goto ON_EXIT;
-        } else {
-            ret = KIIE_OK;
-        }
-    } else {
-        ret = KIIE_ADAPTER;
-        goto ON_EXIT; 
-    }
+kii_error_code_t kii_unsubscribe_topic_async(kii_app_t app,
+                                             const kii_char_t* access_token,
+                                             const kii_topic_t topic,
+                                             kii_callback_t callback,
+                                             void* userdata)
+{
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_unsubscribe_topic(&req, app,
+            access_token, topic);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
+}
 
-ON_EXIT:
-    M_KII_FREE_NULLIFY(url);
-    json_decref(reqHeaders);
-    M_KII_FREE_NULLIFY(respBodyStr);
-    prv_kii_set_last_error(app, ret, &error);
+static kii_error_code_t prv_prepare_is_topic_subscribed(
+        prv_kii_req_t* req,
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_topic_t topic,
+        kii_bool_t* out_is_subscribed)
+{
+    kii_error_code_t ret = KIIE_FAIL;
 
+    prv_kii_init_req(req, app, "HEAD", prv_parse_is_subscribed_response);
+    ret = prv_prepare_bodyless_request(req, access_token,
+            prv_build_url_with_prefix(M_KII_REQ_URL(req),
+                          topic->path,
+                          topic->path_length,
+                          "push",
+                          "subscriptions",
+                          "things",
+                          topic->kii_thing_id,
+                          NULL));
+    req->out_is_subscribed = out_is_subscribed;
     return ret;
 }
 
@@ -1489,75 +2700,29 @@ kii_error_code_t kii_is_topic_subscribed(kii_app_t app,
                                          const kii_topic_t topic,
                                          kii_bool_t* out_is_subscribed)
 {
-    const kii_char_t* thingId = topic->kii_thing_id;
-    const kii_char_t* topicName = topic->topic_name;
-    kii_char_t* url = NULL;
-    json_t* reqHeaders = NULL;
-    kii_int_t respStatus = 0;
-    kii_char_t* respBodyStr = NULL;
-    kii_error_t error;
-    kii_error_code_t ret = KIIE_FAIL;
-
-    kii_memset(&error, 0, sizeof(kii_error_t));
-
-    /* Prepare Url */
-    url = prv_build_url(app->site_url,
-                        "apps",
-                        app->app_id,
-                        "things",
-                        thingId,
-                        "topics",
-                        topicName,
-                        "push",
-                        "subscriptions",
-                        "things",
-                        thingId,
-                        NULL);
-    if (url == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-
-    /* Prepare headers */
-    reqHeaders = prv_create_common_header_json_object(app, access_token, NULL);
-    if (reqHeaders == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-
-    if (kii_http_execute("HEAD", url, reqHeaders, NULL, &respStatus, NULL,
-                &respBodyStr) == KII_TRUE) {
-        if (respStatus < 200 || respStatus >= 300) {
-            if (respStatus == 404) {
-                *out_is_subscribed = KII_FALSE;
-                ret = KIIE_OK;
-            } else {
-                ret = prv_parse_response_error_code(respStatus, respBodyStr,
-                        &error);
-            }
-            goto ON_EXIT;
-        } else {
-            *out_is_subscribed = KII_TRUE;
-            ret = KIIE_OK;
-        }
-    } else {
-        ret = KIIE_ADAPTER;
-        goto ON_EXIT; 
-    }
-
-ON_EXIT:
-    kii_dispose_kii_char(url);
-    json_decref(reqHeaders);
-    kii_dispose_kii_char(respBodyStr);
-
-    prv_kii_set_last_error(app, ret, &error);
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_is_topic_subscribed(&req, app,
+            access_token, topic, out_is_subscribed);
+    return prv_kii_execute(&req, ret);
+}
 
-    return ret;
+kii_error_code_t kii_is_topic_subscribed_async(
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_topic_t topic,
+        kii_bool_t* out_is_subscribed,
+        kii_callback_t callback,
+        void* userdata)
+{
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_is_topic_subscribed(&req, app,
+            access_token, topic, out_is_subscribed);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
 }
 
 static kii_error_code_t prv_prepare_install_thing_push_request_data(
         kii_bool_t development,
-        kii_char_t** out_string)
+        json_t** out_json)
 {
     kii_error_code_t ret = KIIE_FAIL;
     json_t* reqJson = NULL;
@@ -1577,8 +2742,9 @@ static kii_error_code_t prv_prepare_install_thing_push_request_data(
         ret = KIIE_LOWMEMORY;
         goto ON_EXIT;
     }
-    *out_string = json_dumps(reqJson, 0);
-    ret = (*out_string == NULL) ? KIIE_LOWMEMORY : KIIE_OK;
+    *out_json = reqJson;
+    reqJson = NULL;
+    ret = KIIE_OK;
 
 ON_EXIT:
     json_decref(reqJson);
@@ -1586,28 +2752,31 @@ ON_EXIT:
 }
 
 static kii_error_code_t prv_parse_install_thing_push_response(
+        prv_kii_req_t* req,
         kii_int_t respCode,
+        const prv_kii_resp_headers_t* respHdr,
         const kii_char_t* respBodyStr,
-        kii_char_t** out_installation_id,
         kii_error_t* error)
 {
     kii_error_code_t ret = KIIE_FAIL;
     json_t* respBodyJson = NULL;
-    json_error_t jErr;
 
+    (void)respHdr;
     if (respCode < 200 || respCode >= 300) {
         return prv_parse_response_error_code(respCode, respBodyStr, error);
     }
 
     /* Parse body */
-    respBodyJson = json_loads(respBodyStr, 0, &jErr);
+    respBodyJson = prv_kii_resp_json(req, respBodyStr);
     if (respBodyJson == NULL) {
         ret = KIIE_LOWMEMORY;
     } else {
         json_t* installIDJson = json_object_get(respBodyJson, "installationID");
         if (installIDJson != NULL) {
-            *out_installation_id = kii_strdup(json_string_value(installIDJson));
-            ret = *out_installation_id != NULL ? KIIE_OK : KIIE_LOWMEMORY;
+            *(req->out_installation_id) =
+                kii_strdup(json_string_value(installIDJson));
+            ret = *(req->out_installation_id) != NULL ?
+                KIIE_OK : KIIE_LOWMEMORY;
         } else {
             prv_kii_set_info_in_error(error, (int)respCode, KII_ECODE_PARSE);
             ret = KIIE_FAIL;
@@ -1618,75 +2787,73 @@ static kii_error_code_t prv_parse_install_thing_push_response(
     return ret;
 }
 
-kii_error_code_t kii_install_thing_push(kii_app_t app,
-                                        const kii_char_t* access_token,
-                                        kii_bool_t development,
-                                        kii_char_t** out_installation_id)
+static kii_error_code_t prv_prepare_install_thing_push(
+        prv_kii_req_t* req,
+        kii_app_t app,
+        const kii_char_t* access_token,
+        kii_bool_t development,
+        kii_char_t** out_installation_id)
 {
-    kii_char_t* url = NULL;
-    kii_char_t* reqBodyStr = NULL;
-    json_t* reqHeaders = NULL;
-    kii_int_t respCode = 0;
-    kii_char_t* respBodyStr = NULL;
-    kii_error_t error;
-    kii_error_code_t ret = KIIE_FAIL;
-    
     M_KII_ASSERT(app != NULL);
     M_KII_ASSERT(access_token != NULL);
     M_KII_ASSERT(out_installation_id != NULL);
 
-    kii_memset(&error, 0, sizeof(kii_error_t));
+    prv_kii_init_req(req, app, "POST", prv_parse_install_thing_push_response);
+    req->out_installation_id = out_installation_id;
+    req->json_response = KII_TRUE;
 
     /* Prepare URL */
-    url = prv_build_url(app->site_url,
-                        "apps",
-                        app->app_id,
-                        "installations",
-                        NULL);
-    if (url == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-    
-    /* Prepare body */
-    ret = prv_prepare_install_thing_push_request_data(development, &reqBodyStr);
-    if (ret != KIIE_OK) {
-        goto ON_EXIT;
+    req->url = prv_build_url_with_prefix(M_KII_REQ_URL(req),
+                                         NULL,
+                                         0,
+                                         "installations",
+                                         NULL);
+    if (req->url == NULL) {
+        return KIIE_LOWMEMORY;
     }
 
     /* Prepare headers*/
-    reqHeaders = prv_create_common_header_json_object(app, access_token,
+    req->header_set = prv_kii_acquire_header_set(app, access_token,
             "application/vnd.kii.InstallationCreationRequest+json");
-    if (reqHeaders == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-
-    if (kii_http_execute("POST", url, reqHeaders, reqBodyStr, &respCode, NULL,
-                &respBodyStr) == KII_FALSE) {
-        ret = KIIE_ADAPTER;
-        goto ON_EXIT; 
+    if (req->header_set == NULL) {
+        return KIIE_LOWMEMORY;
     }
 
-    ret = prv_parse_install_thing_push_response(respCode, respBodyStr,
-            out_installation_id, &error);
-
-ON_EXIT:
-    M_KII_FREE_NULLIFY(url);
-    M_KII_FREE_NULLIFY(reqBodyStr);
-    M_KII_FREE_NULLIFY(respBodyStr);
-    json_decref(reqHeaders);
-    prv_kii_set_last_error(app, ret, &error);
+    /* Prepare body */
+    return prv_prepare_install_thing_push_request_data(development,
+            &(req->body));
+}
 
-    return ret;
+kii_error_code_t kii_install_thing_push(kii_app_t app,
+                                        const kii_char_t* access_token,
+                                        kii_bool_t development,
+                                        kii_char_t** out_installation_id)
+{
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_install_thing_push(&req, app,
+            access_token, development, out_installation_id);
+    return prv_kii_execute(&req, ret);
 }
 
+kii_error_code_t kii_install_thing_push_async(
+        kii_app_t app,
+        const kii_char_t* access_token,
+        kii_bool_t development,
+        kii_char_t** out_installation_id,
+        kii_callback_t callback,
+        void* userdata)
+{
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_install_thing_push(&req, app,
+            access_token, development, out_installation_id);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
+}
 
 static kii_error_code_t prv_parse_endpoint(
+        prv_kii_req_t* req,
         kii_int_t respCode,
+        const prv_kii_resp_headers_t* respHdr,
         const kii_char_t* respBodyStr,
-        kii_mqtt_endpoint_t** out_endpoint,
-        kii_uint_t* out_retry_after_in_second,
         kii_error_t* error)
 {
     kii_error_code_t ret = KIIE_FAIL;
@@ -1697,24 +2864,27 @@ static kii_error_code_t prv_parse_endpoint(
         ret = prv_parse_response_error_code(respCode, respBodyStr, error);
         goto ON_EXIT;
     } else if (respCode == 503) {
-        respBodyJson = json_loads(respBodyStr, 0, &jErr);
-        if (respBodyJson == NULL) {
-            ret = KIIE_LOWMEMORY;
-            goto ON_EXIT;
-        } else {
-            int retryAfterInt = 0;
+        /* Retry-After header is used unless body has retryAfter. body may
+         * be empty or not json when only the header is sent. */
+        int retryAfterInt = respHdr->retry_after;
+        if (respBodyStr != NULL) {
+            respBodyJson = json_loads(respBodyStr, 0, &jErr);
+        }
+        if (respBodyJson != NULL) {
             json_t* retryAfterJson = json_object_get(respBodyJson,
                     "retryAfter");
-            retryAfterInt = (int)json_integer_value(retryAfterJson);
-            if (retryAfterInt > 0) {
-                *out_retry_after_in_second = retryAfterInt;
+            if ((int)json_integer_value(retryAfterJson) > 0) {
+                retryAfterInt = (int)json_integer_value(retryAfterJson);
             }
-            ret = prv_parse_response_error_code(respCode, respBodyStr, error);
-            goto ON_EXIT;
         }
+        if (retryAfterInt > 0) {
+            *(req->out_retry_after_in_second) = retryAfterInt;
+        }
+        ret = prv_parse_response_error_code(respCode, respBodyStr, error);
+        goto ON_EXIT;
     }
 
-    respBodyJson = json_loads(respBodyStr, 0, &jErr);
+    respBodyJson = prv_kii_resp_json(req, respBodyStr);
     if (respBodyJson == NULL) {
         ret = KIIE_LOWMEMORY;
         goto ON_EXIT;
@@ -1767,7 +2937,7 @@ static kii_error_code_t prv_parse_endpoint(
             endpoint->ttl = ttl;
             endpoint->port_tcp = portTcpInt;
             endpoint->port_ssl = portSslInt;
-            *out_endpoint = endpoint;
+            *(req->out_endpoint) = endpoint;
         }
 
         ret = KIIE_OK;
@@ -1778,61 +2948,63 @@ ON_EXIT:
     return ret;
 }
 
-kii_error_code_t kii_get_mqtt_endpoint(kii_app_t app,
-                                       const kii_char_t* access_token,
-                                       const kii_char_t* installation_id,
-                                       kii_mqtt_endpoint_t** out_endpoint,
-                                       kii_uint_t* out_retry_after_in_second)
+static kii_error_code_t prv_prepare_get_mqtt_endpoint(
+        prv_kii_req_t* req,
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_char_t* installation_id,
+        kii_mqtt_endpoint_t** out_endpoint,
+        kii_uint_t* out_retry_after_in_second)
 {
-    kii_char_t* url = NULL;
-    json_t* reqHeaders = NULL;
-    kii_int_t respCode = 0;
-    kii_char_t* respBodyStr = NULL;
-    kii_error_t error;
     kii_error_code_t ret = KIIE_FAIL;
 
     M_KII_ASSERT(app != NULL);
     M_KII_ASSERT(access_token != NULL);
     M_KII_ASSERT(out_endpoint != NULL);
 
-    kii_memset(&error, 0, sizeof(kii_error_t));
-
-    /* Prepare URL */
-    url = prv_build_url(app->site_url,
-                        "apps",
-                        app->app_id,
-                        "installations",
-                        installation_id,
-                        "mqtt-endpoint",
-                        NULL);
-    if (url == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-
-    M_KII_DEBUG(prv_log("mqtt endpoint url: %s", url));
-    /* Prepare Headers */
-    reqHeaders = prv_create_common_header_json_object(app, access_token, NULL);
-    if (reqHeaders == NULL) {
-        ret = KIIE_LOWMEMORY;
-        goto ON_EXIT;
-    }
-
-    if (kii_http_execute("GET", url, reqHeaders, NULL, &respCode, NULL,
-                &respBodyStr) == KII_FALSE) {
-        ret = KIIE_ADAPTER;
-        goto ON_EXIT;
+    prv_kii_init_req(req, app, "GET", prv_parse_endpoint);
+    ret = prv_prepare_bodyless_request(req, access_token,
+            prv_build_url_with_prefix(M_KII_REQ_URL(req),
+                          NULL,
+                          0,
+                          "installations",
+                          installation_id,
+                          "mqtt-endpoint",
+                          NULL));
+    req->out_endpoint = out_endpoint;
+    req->json_response = KII_TRUE;
+    req->out_retry_after_in_second = out_retry_after_in_second;
+    if (ret == KIIE_OK) {
+        M_KII_DEBUG(prv_log("mqtt endpoint url: %s", req->url));
     }
+    return ret;
+}
 
-    /* Parse body */
-    ret = prv_parse_endpoint(respCode, respBodyStr, out_endpoint,
-            out_retry_after_in_second, &error);
-
-ON_EXIT:
-    M_KII_FREE_NULLIFY(url);
-    M_KII_FREE_NULLIFY(respBodyStr);
-    json_decref(reqHeaders);
-    prv_kii_set_last_error(app, ret, &error);
+kii_error_code_t kii_get_mqtt_endpoint(kii_app_t app,
+                                       const kii_char_t* access_token,
+                                       const kii_char_t* installation_id,
+                                       kii_mqtt_endpoint_t** out_endpoint,
+                                       kii_uint_t* out_retry_after_in_second)
+{
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_get_mqtt_endpoint(&req, app,
+            access_token, installation_id, out_endpoint,
+            out_retry_after_in_second);
+    return prv_kii_execute(&req, ret);
+}
 
-    return ret;
+kii_error_code_t kii_get_mqtt_endpoint_async(
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_char_t* installation_id,
+        kii_mqtt_endpoint_t** out_endpoint,
+        kii_uint_t* out_retry_after_in_second,
+        kii_callback_t callback,
+        void* userdata)
+{
+    prv_kii_req_t req;
+    kii_error_code_t ret = prv_prepare_get_mqtt_endpoint(&req, app,
+            access_token, installation_id, out_endpoint,
+            out_retry_after_in_second);
+    return prv_kii_execute_async(&req, ret, callback, userdata);
 }
@@ -56,9 +56,13 @@ typedef enum kii_error_code_t {
     KIIE_FAIL,
     KIIE_LOWMEMORY,
     KIIE_RESPWRITE,
-    KIIE_ADAPTER
+    KIIE_ADAPTER,
+    KIIE_TRUNCATED /* output buffer is too small. */
 } kii_error_code_t;
 
+/** Size of buffer which holds etag of object including terminating NUL. */
+#define KII_ETAG_SIZE 128
+
 /** Represents application.
  * should be disposed by kii_dispose_app(kii_app_t)
  */
@@ -136,6 +140,21 @@ typedef struct kii_mqtt_endpoint_t {
     kii_ulong_t ttl;
 } kii_mqtt_endpoint_t;
 
+/** Represents result of an object in batch apis.
+ * should be disposed by kii_dispose_object_results(kii_object_result_t*,
+ * size_t)
+ */
+typedef struct kii_object_result_t {
+    /** KIIE_OK if the object succeeded. Otherwise failed. */
+    kii_error_code_t result;
+    kii_error_t error; /**< details of the failure if result is KIIE_FAIL. */
+    /** id of the created object. NULL if failed or not created. */
+    kii_char_t* object_id;
+    kii_char_t* etag; /**< etag of the object. NULL if failed. */
+    /** contents of the obtained object. NULL if failed or not obtained. */
+    json_t* contents;
+} kii_object_result_t;
+
 /** Set up program environment.
  * This function must be called at least once within a program
  * (a program is all the code that shares a memory space) before the program
@@ -152,6 +171,10 @@ typedef struct kii_mqtt_endpoint_t {
  * similarly thread unsafe,
  * it could conflict with any other thread that uses these other libraries.
  *
+ * Writing to connections closed by server doesn't raise SIGPIPE on
+ * platforms which have SO_NOSIGPIPE or MSG_NOSIGNAL. On other platforms,
+ * the program must ignore SIGPIPE.
+ *
  * @retrun if return code is not KIIE_OK, something went wrong and you cannot
  * use other kii sdk functions.
  */
@@ -172,8 +195,131 @@ kii_error_code_t kii_global_init(void);
  */
 void kii_global_cleanup(void);
 
+/** Configure pool of keep-alive connections.
+ * Connections to Kii Cloud are kept open after each request and reused by
+ * following requests to the same host, so that sequential api calls don't
+ * pay for TCP connect and TLS handshake every time.
+ * By default, 4 connections are kept for 60 seconds.
+ *
+ * This function must be called after kii_global_init(void).
+ * This function is not thread safe.
+ * You must not call it while any other thread is calling kii sdk apis.
+ *
+ * @param [in] max_connections number of connections kept in the pool.
+ * 0 disables the pool. Every request opens new connection.
+ * @param [in] idle_timeout_in_second connection which has not been used
+ * for this period is closed.
+ * @return KIIE_OK if succeeded. KIIE_LOWMEMORY if failed to allocate pool.
+ */
+kii_error_code_t kii_global_set_connection_pool(
+        kii_uint_t max_connections,
+        kii_uint_t idle_timeout_in_second);
+
+/** Configure deadline of connecting to Kii Cloud.
+ * Addresses of the host are tried in parallel (IPv6 and IPv4
+ * alternately), and connecting fails if none of them is established
+ * within the deadline. By default, it is 30 seconds.
+ *
+ * This function must be called after kii_global_init(void).
+ * This function is not thread safe.
+ * You must not call it while any other thread is calling kii sdk apis.
+ *
+ * @param [in] timeout_in_millis deadline of connecting in milliseconds.
+ * @return KIIE_OK if succeeded.
+ */
+kii_error_code_t kii_global_set_connect_timeout(kii_uint_t timeout_in_millis);
+
+/** Configure HTTP/2 multiplexing of asynchronous requests.
+ * If enabled, asynchronous requests of an app to the same site are sent
+ * as concurrent streams of single HTTP/2 connection instead of opening
+ * connection for each of them. Requests exceeding max_concurrent_streams
+ * wait until preceding ones complete. If server doesn't support HTTP/2,
+ * requests are sent one by one over the connection by HTTP/1.1.
+ * Blocking apis are not affected. By default, it is disabled.
+ *
+ * This function must be called after kii_global_init(void).
+ * This function is not thread safe.
+ * You must not call it while any other thread is calling kii sdk apis.
+ *
+ * @param [in] max_concurrent_streams max number of requests in flight on
+ * the connection. 0 disables multiplexing.
+ * @return KIIE_OK if succeeded. KIIE_FAIL if http client doesn't support
+ * HTTP/2 or can't limit concurrent streams.
+ */
+kii_error_code_t kii_global_set_http2_multiplexing(
+        kii_uint_t max_concurrent_streams);
+
+/** Set of socket and TLS behaviours applied to connections. */
+typedef enum kii_transport_profile_t {
+    /** behaviours of http client as is. */
+    KII_TRANSPORT_DEFAULT = 0,
+    /** TCP_NODELAY, TCP Fast Open where kernel allows it, no
+     * "Expect: 100-continue" round trip and TLS session resumption.
+     * Minimum TLS version is not changed. */
+    KII_TRANSPORT_LOW_LATENCY,
+    /** KII_TRANSPORT_LOW_LATENCY and GET requests are sent as TLS 1.3 early
+     * data on resumed sessions. Early data can be replayed by an attacker,
+     * so it is used only for GET which doesn't change state on server. */
+    KII_TRANSPORT_LOW_LATENCY_EARLY_DATA
+} kii_transport_profile_t;
+
+/** Select transport profile of connections to Kii Cloud.
+ * Profile applies to connections opened after this call.
+ * By default, it is KII_TRANSPORT_DEFAULT.
+ *
+ * This function must be called after kii_global_init(void).
+ * This function is not thread safe.
+ * You must not call it while any other thread is calling kii sdk apis.
+ *
+ * @param [in] profile transport profile.
+ * @return KIIE_OK if succeeded.
+ */
+kii_error_code_t kii_global_set_transport_profile(
+        kii_transport_profile_t profile);
+
+/** Sizes of compressed response bodies received so far. */
+typedef struct kii_compression_stats_t {
+    /** bytes received over network. */
+    kii_ulong_t compressed_bytes;
+    /** bytes after decompression.
+     * decompressed_bytes - compressed_bytes is the bytes saved. */
+    kii_ulong_t decompressed_bytes;
+} kii_compression_stats_t;
+
+/** Configure compression of responses from Kii Cloud.
+ * If enabled, Kii Cloud is asked to compress responses by gzip or deflate,
+ * and they are decompressed while they are received.
+ * It reduces bytes transferred on metered network. By default, it is
+ * disabled.
+ *
+ * This function must be called after kii_global_init(void).
+ * This function is not thread safe.
+ * You must not call it while any other thread is calling kii sdk apis.
+ *
+ * @param [in] enabled KII_TRUE to enable compression.
+ * @return KIIE_OK if succeeded.
+ */
+kii_error_code_t kii_global_set_response_compression(kii_bool_t enabled);
+
+/** Get sizes of compressed responses to know bytes saved by compression.
+ * This function is thread safe.
+ *
+ * @param [out] out_stats sizes of compressed responses.
+ */
+void kii_global_get_compression_stats(kii_compression_stats_t* out_stats);
+
 /** Init application.
  * obtained instance should be disposed by application.
+ *
+ * Blocking apis (kii_xxx other than kii_xxx_async) are thread safe.
+ * Threads can share an app and call them in parallel, and each of them
+ * gets its own error detail by kii_get_last_error(kii_app_t).
+ * Asynchronous apis of an app must be called from the thread polling it.
+ * kii_app_set_request_compression(kii_app_t, kii_uint_t),
+ * kii_app_set_request_context(kii_app_t, kii_bool_t) and
+ * kii_dispose_app(kii_app_t) must not be called while other threads are
+ * using the app.
+ *
  * @param [in] app_id application id
  * @param [in] app_key application key
  * @param [in] site_url application site .
@@ -185,9 +331,58 @@ kii_app_t kii_init_app(const kii_char_t* app_id,
                        const kii_char_t* app_key,
                        const kii_char_t* site_url);
 
+/** Configure compression of request bodies sent to Kii Cloud.
+ * Object contents larger than threshold are compressed by gzip while they
+ * are serialized and sent with Content-Encoding header. Contents up to
+ * threshold are sent as is, as compressing small body costs more CPU time
+ * than it saves. By default, requests are not compressed.
+ *
+ * Applies to kii_create_new_object, kii_create_new_object_with_id,
+ * kii_patch_object, kii_replace_object and their _raw variants.
+ *
+ * @param [in] app kii app used for operation.
+ * @param [in] threshold_in_bytes contents larger than this are compressed.
+ * 0 disables compression.
+ */
+void kii_app_set_request_compression(kii_app_t app,
+                                     kii_uint_t threshold_in_bytes);
+
+/** Enable or disable request context of app.
+ * Request context keeps buffers in which url, headers and body of requests
+ * are built, and the deflate stream of compressed bodies. They are reused
+ * by later requests instead of being allocated for each request. Once they have grown enough, requests
+ * writing objects (kii_patch_object, kii_replace_object and so on) don't
+ * allocate memory, except for output parameters such as out_etag and
+ * error detail of failed requests.
+ * Context is used by a request at a time. Requests sent by other threads
+ * while it is in use allocate buffers of their own as usual.
+ * By default, request context is disabled.
+ *
+ * @param [in] app kii app used for operation.
+ * @param [in] enabled KII_TRUE to enable request context. KII_FALSE frees
+ * the buffers.
+ * @return KIIE_OK if succeeded. KIIE_LOWMEMORY if context can't be
+ * allocated.
+ */
+kii_error_code_t kii_app_set_request_context(kii_app_t app,
+                                             kii_bool_t enabled);
+
+/** Get sizes of request bodies subject to compression.
+ * compressed_bytes is the bytes actually sent, including bodies sent as is
+ * since they are not larger than threshold.
+ *
+ * @param [in] app kii app used for operation.
+ * @param [out] out_stats sizes of request bodies.
+ */
+void kii_app_get_request_compression_stats(kii_app_t app,
+                                           kii_compression_stats_t* out_stats);
+
 /** Obtain error detail happens last.
+ * Error detail is kept for each thread. This returns detail of the api
+ * called last on the calling thread, if it was called with app and failed.
+ * Detail is valid until the thread calls next api.
  * @param [in] app kii app used for operation.
- * @returns error detail.
+ * @returns error detail. NULL if there is no detail.
  */
 kii_error_t* kii_get_last_error(kii_app_t app);
 
@@ -211,6 +406,13 @@ void kii_dispose_topic(kii_topic_t topic);
  */
 void kii_dispose_mqtt_endpoint(kii_mqtt_endpoint_t* endpoint);
 
+/** Dispose resources held by results of batch apis.
+ * Array itself is not disposed as it is given by the application.
+ * @param [in] results array of results should be disposed.
+ * @param [in] count number of results in the array.
+ */
+void kii_dispose_object_results(kii_object_result_t* results, size_t count);
+
 /** Register thing to Kii Cloud.
  * This api performes the entire request in a blocking manner
  * and returns when done, or if it failed.
@@ -356,6 +558,65 @@ kii_error_code_t kii_replace_object(kii_app_t app,
                                     const kii_char_t* opt_etag,
                                     kii_char_t** out_etag);
 
+/** Same as kii_create_new_object() but contents are serialized json.
+ * contents are sent as they are without being parsed, so they must be
+ * valid json object.
+ * @param [in] contents serialized key-values of object. Need not be
+ * terminated by NUL.
+ * @param [in] contents_length length of contents in bytes.
+ * @see kii_create_new_object()
+ */
+kii_error_code_t kii_create_new_object_raw(kii_app_t app,
+                                           const kii_char_t* access_token,
+                                           const kii_bucket_t bucket,
+                                           const kii_char_t* contents,
+                                           size_t contents_length,
+                                           kii_char_t** out_object_id,
+                                           kii_char_t** out_etag);
+
+/** Same as kii_create_new_object_with_id() but contents are serialized
+ * json.
+ * @param [in] contents serialized key-values of object.
+ * @param [in] contents_length length of contents in bytes.
+ * @see kii_create_new_object_with_id()
+ */
+kii_error_code_t kii_create_new_object_with_id_raw(
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        const kii_char_t* object_id,
+        const kii_char_t* contents,
+        size_t contents_length,
+        kii_char_t** out_etag);
+
+/** Same as kii_patch_object() but patch is serialized json.
+ * @param [in] patch serialized patch data.
+ * @param [in] patch_length length of patch in bytes.
+ * @see kii_patch_object()
+ */
+kii_error_code_t kii_patch_object_raw(kii_app_t app,
+                                      const kii_char_t* access_token,
+                                      const kii_bucket_t bucket,
+                                      const kii_char_t* object_id,
+                                      const kii_char_t* patch,
+                                      size_t patch_length,
+                                      const kii_char_t* opt_etag,
+                                      kii_char_t** out_etag);
+
+/** Same as kii_replace_object() but replacement is serialized json.
+ * @param [in] replace_contents serialized replacement data.
+ * @param [in] contents_length length of replace_contents in bytes.
+ * @see kii_replace_object()
+ */
+kii_error_code_t kii_replace_object_raw(kii_app_t app,
+                                        const kii_char_t* access_token,
+                                        const kii_bucket_t bucket,
+                                        const kii_char_t* object_id,
+                                        const kii_char_t* replace_contents,
+                                        size_t contents_length,
+                                        const kii_char_t* opt_etag,
+                                        kii_char_t** out_etag);
+
 /** Get object contents with specified id.
  * This api performes the entire request in a blocking manner
  * and returns when done, or if it failed.
@@ -375,6 +636,95 @@ kii_error_code_t kii_get_object(kii_app_t app,
                                 json_t** out_contents,
                                 kii_char_t** out_etag);
 
+/** Get object contents with specified id as serialized json.
+ * This api performes the entire request in a blocking manner
+ * and returns when done, or if it failed.
+ * Contents are copied to buffer while they are received, so that they are
+ * not parsed and no resource is allocated for them.
+ * @param [in] app kii application uses this thing.
+ * @param [in] access_token specify access token of authur.
+ * @param [in] bucket specify bucket contains object.
+ * @param [in] object_id specify id of the object.
+ * @param [out] buffer receives contents terminated by NUL. If contents are
+ * longer than buffer_size - 1 bytes, leading part of them is stored.
+ * You can pass NULL with buffer_size 0 to get required size.
+ * @param [in] buffer_size size of buffer in bytes.
+ * @param [out] out_length length of whole contents in bytes. Contents fit
+ * in buffer whose size is *out_length + 1.
+ * @param [out] opt_out_etag buffer of KII_ETAG_SIZE bytes which receives
+ * etag of server object, or empty string if it is absent.
+ * You can pass NULL if you don't need to know etag.
+ * @return KIIE_OK if succeeded. KIIE_TRUNCATED if succeeded but contents
+ * are truncated. Otherwise failed. you can check details by calling
+ * kii_get_last_error(kii_app_t).
+ */
+kii_error_code_t kii_get_object_raw(kii_app_t app,
+                                    const kii_char_t* access_token,
+                                    const kii_bucket_t bucket,
+                                    const kii_char_t* object_id,
+                                    kii_char_t* buffer,
+                                    size_t buffer_size,
+                                    size_t* out_length,
+                                    kii_char_t* opt_out_etag);
+
+/** Create new objects in the same bucket.
+ * This api performes the entire requests in a blocking manner
+ * and returns when all of them are done.
+ * Requests are sent in parallel over pooled connections, up to
+ * max_parallel at a time. Objects may be created in any order.
+ * Unlike other async apis, this api is thread safe as it doesn't use
+ * requests of the app started by async apis.
+ * @param [in] app kii application uses this thing.
+ * @param [in] access_token specify access token of authur.
+ * @param [in] bucket specify bucket to creates objects.
+ * @param [in] contents array of key-values of objects.
+ * @param [in] count number of objects in contents.
+ * @param [in] max_parallel maximum number of requests in flight. must be
+ * greater than 0.
+ * @param [out] out_results array of count results, in the same order as
+ * contents. Should be disposed by kii_dispose_object_results() even if
+ * this api failed.
+ * @return KIIE_OK if all objects are created. Result of the first failed
+ * object if some of them failed, and you can check details by calling
+ * kii_get_last_error(kii_app_t) or each of out_results.
+ */
+kii_error_code_t kii_create_new_objects(kii_app_t app,
+                                        const kii_char_t* access_token,
+                                        const kii_bucket_t bucket,
+                                        const json_t* const* contents,
+                                        size_t count,
+                                        kii_uint_t max_parallel,
+                                        kii_object_result_t* out_results);
+
+/** Get contents of objects with specified ids.
+ * This api performes the entire requests in a blocking manner
+ * and returns when all of them are done.
+ * Requests are sent in parallel over pooled connections, up to
+ * max_parallel at a time.
+ * Unlike other async apis, this api is thread safe as it doesn't use
+ * requests of the app started by async apis.
+ * @param [in] app kii application uses this thing.
+ * @param [in] access_token specify access token of authur.
+ * @param [in] bucket specify bucket contains objects.
+ * @param [in] object_ids array of ids of the objects.
+ * @param [in] count number of ids in object_ids.
+ * @param [in] max_parallel maximum number of requests in flight. must be
+ * greater than 0.
+ * @param [out] out_results array of count results, in the same order as
+ * object_ids. contents and etag of each result are set. Should be
+ * disposed by kii_dispose_object_results() even if this api failed.
+ * @return KIIE_OK if all objects are obtained. Result of the first failed
+ * object if some of them failed, and you can check details by calling
+ * kii_get_last_error(kii_app_t) or each of out_results.
+ */
+kii_error_code_t kii_get_objects(kii_app_t app,
+                                 const kii_char_t* access_token,
+                                 const kii_bucket_t bucket,
+                                 const kii_char_t* const* object_ids,
+                                 size_t count,
+                                 kii_uint_t max_parallel,
+                                 kii_object_result_t* out_results);
+
 /** Delete object with specified id.
  * This api performes the entire request in a blocking manner
  * and returns when done, or if it failed.
@@ -543,6 +893,303 @@ kii_error_code_t kii_get_mqtt_endpoint(kii_app_t app,
                                        kii_mqtt_endpoint_t** out_endpoint,
                                        kii_uint_t* out_retry_after_in_second);
 
+#pragma mark asynchronous interfaces
+
+/** Callback notifies completion of asynchronous api.
+ * Output parameters passed to the api are filled before this callback is
+ * called. Called from kii_app_poll(kii_app_t, kii_int_t) on the thread
+ * polling the app.
+ * @param [in] app kii application used for the request.
+ * @param [in] result KIIE_OK if succeeded. Otherwise failed. you can check
+ * details by calling kii_get_last_error(kii_app_t) in this callback.
+ * @param [in] userdata pointer passed to the asynchronous api.
+ */
+typedef void (*kii_callback_t)(kii_app_t app,
+                               kii_error_code_t result,
+                               void* userdata);
+
+/** Progress asynchronous requests of the app.
+ * Asynchronous apis (kii_xxx_async) only start requests and return
+ * immediately. Requests are processed and callbacks are called
+ * by this function. Requests of the same app share a thread, so that a
+ * single thread can keep many requests in flight.
+ *
+ * Strings, json_t instances and output parameters passed to the
+ * asynchronous apis must remain valid until the callback is called.
+ * kii_dispose_app(kii_app_t) cancels requests in flight without calling
+ * their callbacks.
+ * This function is not thread safe. You must not call asynchronous apis of
+ * the same app from other threads while polling. Blocking apis can be
+ * called from other threads.
+ * @param [in] app kii application used for the requests.
+ * @param [in] timeout_in_ms maximum time to wait for network activity.
+ * 0 doesn't wait.
+ * @return number of requests still in flight.
+ */
+kii_uint_t kii_app_poll(kii_app_t app, kii_int_t timeout_in_ms);
+
+/** Poll the app until all asynchronous requests complete.
+ * @param [in] app kii application used for the requests.
+ * @see kii_app_poll(kii_app_t, kii_int_t)
+ */
+void kii_app_run(kii_app_t app);
+
+/** Asynchronous version of kii_register_thing().
+ * @param [in] callback called when the request completes.
+ * @param [in] userdata passed to the callback.
+ * @return KIIE_OK if the request is started. Otherwise failed and callback
+ * is not called.
+ * @see kii_register_thing()
+ */
+kii_error_code_t kii_register_thing_async(kii_app_t app,
+                                          const kii_char_t* vendor_thing_id,
+                                          const kii_char_t* thing_password,
+                                          const kii_char_t* opt_thing_type,
+                                          const json_t* user_data,
+                                          kii_thing_t* out_thing,
+                                          kii_char_t** out_access_token,
+                                          kii_callback_t callback,
+                                          void* userdata);
+
+/** Asynchronous version of kii_create_new_object().
+ * @see kii_register_thing_async()
+ */
+kii_error_code_t kii_create_new_object_async(kii_app_t app,
+                                             const kii_char_t* access_token,
+                                             const kii_bucket_t bucket,
+                                             const json_t* contents,
+                                             kii_char_t** out_object_id,
+                                             kii_char_t** out_etag,
+                                             kii_callback_t callback,
+                                             void* userdata);
+
+/** Asynchronous version of kii_create_new_object_with_id().
+ * @see kii_register_thing_async()
+ */
+kii_error_code_t kii_create_new_object_with_id_async(
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        const kii_char_t* object_id,
+        const json_t* contents,
+        kii_char_t** out_etag,
+        kii_callback_t callback,
+        void* userdata);
+
+/** Asynchronous version of kii_patch_object().
+ * @see kii_register_thing_async()
+ */
+kii_error_code_t kii_patch_object_async(kii_app_t app,
+                                        const kii_char_t* access_token,
+                                        const kii_bucket_t bucket,
+                                        const kii_char_t* object_id,
+                                        const json_t* patch,
+                                        const kii_char_t* opt_etag,
+                                        kii_char_t** out_etag,
+                                        kii_callback_t callback,
+                                        void* userdata);
+
+/** Asynchronous version of kii_replace_object().
+ * @see kii_register_thing_async()
+ */
+kii_error_code_t kii_replace_object_async(kii_app_t app,
+                                          const kii_char_t* access_token,
+                                          const kii_bucket_t bucket,
+                                          const kii_char_t* object_id,
+                                          const json_t* replace_contents,
+                                          const kii_char_t* opt_etag,
+                                          kii_char_t** out_etag,
+                                          kii_callback_t callback,
+                                          void* userdata);
+
+/** Asynchronous version of kii_create_new_object_raw().
+ * contents must remain valid until callback is called.
+ * @see kii_register_thing_async()
+ */
+kii_error_code_t kii_create_new_object_raw_async(
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        const kii_char_t* contents,
+        size_t contents_length,
+        kii_char_t** out_object_id,
+        kii_char_t** out_etag,
+        kii_callback_t callback,
+        void* userdata);
+
+/** Asynchronous version of kii_create_new_object_with_id_raw().
+ * contents must remain valid until callback is called.
+ * @see kii_register_thing_async()
+ */
+kii_error_code_t kii_create_new_object_with_id_raw_async(
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        const kii_char_t* object_id,
+        const kii_char_t* contents,
+        size_t contents_length,
+        kii_char_t** out_etag,
+        kii_callback_t callback,
+        void* userdata);
+
+/** Asynchronous version of kii_patch_object_raw().
+ * patch must remain valid until callback is called.
+ * @see kii_register_thing_async()
+ */
+kii_error_code_t kii_patch_object_raw_async(kii_app_t app,
+                                            const kii_char_t* access_token,
+                                            const kii_bucket_t bucket,
+                                            const kii_char_t* object_id,
+                                            const kii_char_t* patch,
+                                            size_t patch_length,
+                                            const kii_char_t* opt_etag,
+                                            kii_char_t** out_etag,
+                                            kii_callback_t callback,
+                                            void* userdata);
+
+/** Asynchronous version of kii_replace_object_raw().
+ * replace_contents must remain valid until callback is called.
+ * @see kii_register_thing_async()
+ */
+kii_error_code_t kii_replace_object_raw_async(
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        const kii_char_t* object_id,
+        const kii_char_t* replace_contents,
+        size_t contents_length,
+        const kii_char_t* opt_etag,
+        kii_char_t** out_etag,
+        kii_callback_t callback,
+        void* userdata);
+
+/** Asynchronous version of kii_get_object().
+ * @see kii_register_thing_async()
+ */
+kii_error_code_t kii_get_object_async(kii_app_t app,
+                                      const kii_char_t* access_token,
+                                      const kii_bucket_t bucket,
+                                      const kii_char_t* object_id,
+                                      json_t** out_contents,
+                                      kii_char_t** out_etag,
+                                      kii_callback_t callback,
+                                      void* userdata);
+
+/** Asynchronous version of kii_get_object_raw().
+ * buffer must remain valid until callback is called.
+ * @see kii_register_thing_async()
+ */
+kii_error_code_t kii_get_object_raw_async(kii_app_t app,
+                                          const kii_char_t* access_token,
+                                          const kii_bucket_t bucket,
+                                          const kii_char_t* object_id,
+                                          kii_char_t* buffer,
+                                          size_t buffer_size,
+                                          size_t* out_length,
+                                          kii_char_t* opt_out_etag,
+                                          kii_callback_t callback,
+                                          void* userdata);
+
+/** Asynchronous version of kii_delete_object().
+ * @see kii_register_thing_async()
+ */
+kii_error_code_t kii_delete_object_async(kii_app_t app,
+                                         const kii_char_t* access_token,
+                                         const kii_bucket_t bucket,
+                                         const kii_char_t* object_id,
+                                         kii_callback_t callback,
+                                         void* userdata);
+
+/** Asynchronous version of kii_subscribe_bucket().
+ * @see kii_register_thing_async()
+ */
+kii_error_code_t kii_subscribe_bucket_async(kii_app_t app,
+                                            const kii_char_t* access_token,
+                                            const kii_bucket_t bucket,
+                                            kii_callback_t callback,
+                                            void* userdata);
+
+/** Asynchronous version of kii_unsubscribe_bucket().
+ * @see kii_register_thing_async()
+ */
+kii_error_code_t kii_unsubscribe_bucket_async(kii_app_t app,
+                                              const kii_char_t* access_token,
+                                              const kii_bucket_t bucket,
+                                              kii_callback_t callback,
+                                              void* userdata);
+
+/** Asynchronous version of kii_is_bucket_subscribed().
+ * @see kii_register_thing_async()
+ */
+kii_error_code_t kii_is_bucket_subscribed_async(
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_bucket_t bucket,
+        kii_bool_t* out_is_subscribed,
+        kii_callback_t callback,
+        void* userdata);
+
+/** Asynchronous version of kii_create_topic().
+ * @see kii_register_thing_async()
+ */
+kii_error_code_t kii_create_topic_async(kii_app_t app,
+                                        const kii_char_t* access_token,
+                                        const kii_topic_t topic,
+                                        kii_callback_t callback,
+                                        void* userdata);
+
+/** Asynchronous version of kii_subscribe_topic().
+ * @see kii_register_thing_async()
+ */
+kii_error_code_t kii_subscribe_topic_async(kii_app_t app,
+                                           const kii_char_t* access_token,
+                                           const kii_topic_t topic,
+                                           kii_callback_t callback,
+                                           void* userdata);
+
+/** Asynchronous version of kii_unsubscribe_topic().
+ * @see kii_register_thing_async()
+ */
+kii_error_code_t kii_unsubscribe_topic_async(kii_app_t app,
+                                             const kii_char_t* access_token,
+                                             const kii_topic_t topic,
+                                             kii_callback_t callback,
+                                             void* userdata);
+
+/** Asynchronous version of kii_is_topic_subscribed().
+ * @see kii_register_thing_async()
+ */
+kii_error_code_t kii_is_topic_subscribed_async(
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_topic_t topic,
+        kii_bool_t* out_is_subscribed,
+        kii_callback_t callback,
+        void* userdata);
+
+/** Asynchronous version of kii_install_thing_push().
+ * @see kii_register_thing_async()
+ */
+kii_error_code_t kii_install_thing_push_async(
+        kii_app_t app,
+        const kii_char_t* access_token,
+        kii_bool_t development,
+        kii_char_t** out_installation_id,
+        kii_callback_t callback,
+        void* userdata);
+
+/** Asynchronous version of kii_get_mqtt_endpoint().
+ * @see kii_register_thing_async()
+ */
+kii_error_code_t kii_get_mqtt_endpoint_async(
+        kii_app_t app,
+        const kii_char_t* access_token,
+        const kii_char_t* installation_id,
+        kii_mqtt_endpoint_t** out_endpoint,
+        kii_uint_t* out_retry_after_in_second,
+        kii_callback_t callback,
+        void* userdata);
+
 
 #ifdef __cplusplus
 }
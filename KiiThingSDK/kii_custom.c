@@ -11,8 +11,21 @@
 #include <stdarg.h>
 #include <ctype.h>
 
+#ifdef DEBUG
+static unsigned long allocation_count = 0;
+#define M_KII_COUNT_ALLOCATION() (++allocation_count)
+
+unsigned long kii_get_allocation_count(void)
+{
+    return allocation_count;
+}
+#else
+#define M_KII_COUNT_ALLOCATION()
+#endif
+
 void* kii_malloc(size_t size)
 {
+    M_KII_COUNT_ALLOCATION();
     return malloc(size);
 }
 
@@ -32,6 +45,7 @@ void kii_free(void* ptr)
 
 kii_char_t* kii_strdup(const kii_char_t* s)
 {
+    M_KII_COUNT_ALLOCATION();
     return strdup(s);
 }
 
@@ -52,6 +66,7 @@ kii_char_t* kii_strncpy(kii_char_t *s1, const kii_char_t *s2, size_t n)
 
 void* kii_realloc(void* ptr, size_t size)
 {
+    M_KII_COUNT_ALLOCATION();
     return realloc(ptr, size);
 }
 
@@ -64,3 +79,17 @@ int kii_tolower(int c)
 {
     return tolower(c);
 }
+
+double kii_strtod(const kii_char_t* s, kii_char_t** endptr)
+{
+    return strtod(s, endptr);
+}
+
+json_int_t kii_strtoint(const kii_char_t* s, kii_char_t** endptr)
+{
+#if JSON_INTEGER_IS_LONG_LONG
+    return strtoll(s, endptr, 10);
+#else
+    return strtol(s, endptr, 10);
+#endif
+}
@@ -11,3 +11,12 @@ kii_char_t* kii_strncpy(kii_char_t *s1, const kii_char_t *s2, size_t n);
 void* kii_realloc(void* ptr, size_t size);
 int kii_strncmp(const kii_char_t *s1, const kii_char_t *s2, size_t n);
 int kii_tolower(int c);
+double kii_strtod(const kii_char_t* s, kii_char_t** endptr);
+json_int_t kii_strtoint(const kii_char_t* s, kii_char_t** endptr);
+
+#ifdef DEBUG
+/* Number of kii_malloc, kii_realloc and kii_strdup calls so far.
+ * Tests read it to check that requests don't allocate. It is not exact
+ * while other threads allocate. */
+unsigned long kii_get_allocation_count(void);
+#endif
@@ -2,22 +2,127 @@
 #define KiiThingSDK_kii_http_adapter_h
 
 #include "kii_cloud.h"
+#include "kii_prv_types.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Request body serialized on demand.
+ * produce calls write with pieces of the body in order, so that adapter can
+ * send them without holding whole body. Both return 0 on success or -1 on
+ * error, as json_dump_callback does.
+ * produce may set content_encoding before its first write. Adapter sends it
+ * as Content-Encoding header if it is not NULL, so headers must be framed
+ * after the first write or after produce returns.
+ * Adapter which holds whole body before sending it can use opt_buffer
+ * instead of allocating its own. It is allocated by kii_malloc and can be
+ * grown by kii_realloc, updating opt_buffer and opt_capacity. It is owned
+ * by the caller and must not be freed by adapter.
+ * opt_bytes is the whole body if it is already serialized and is sent
+ * without Content-Encoding. Adapter can send it as is instead of calling
+ * produce, which writes the same bytes. It remains valid until the
+ * request completes. */
+typedef int (*kii_http_body_write_t)(
+        const char* buffer,
+        size_t size,
+        void* context);
+
+typedef struct kii_http_body_t {
+    int (*produce)(const void* data, kii_http_body_write_t write,
+            void* context);
+    const void* data;
+    const kii_char_t* content_encoding;
+    kii_char_t** opt_buffer; /* can be NULL */
+    size_t* opt_capacity;
+    const kii_char_t* opt_bytes; /* can be NULL */
+    size_t bytes_length;
+} kii_http_body_t;
+
+/* Request headers as "name:value" lines without CRLF.
+ * common is terminated by NULL. It is built once for requests of the same
+ * app, access token and content type and shared by them, so adapter must
+ * not modify it. opt_extra is a header specific to the request such as
+ * if-match, or NULL. */
+typedef struct kii_http_headers_t {
+    const kii_char_t* const* common;
+    const kii_char_t* opt_extra;
+} kii_http_headers_t;
+
+/* Response body consumed while it is received.
+ * Bodies of successful (2xx) responses are passed to consume in pieces as
+ * they arrive instead of being returned as string, so that they can be
+ * parsed without holding whole body. Adapter which doesn't support it may
+ * return the body as string instead. */
+typedef struct kii_http_sink_t {
+    void (*consume)(const char* buffer, size_t size, void* context);
+    void* context;
+} kii_http_sink_t;
+
 kii_bool_t kii_http_init(void);
 void kii_http_cleanup(void);
+kii_bool_t kii_http_set_connection_pool(
+        kii_uint_t max_connections,
+        kii_uint_t idle_timeout_in_second);
+kii_bool_t kii_http_set_connect_timeout(
+        kii_uint_t timeout_in_millis);
+/* Compressed response is decompressed by adapter before it is returned or
+ * passed to sink. Stats accumulate sizes of compressed bodies. */
+kii_bool_t kii_http_set_response_compression(kii_bool_t enabled);
+void kii_http_get_compression_stats(
+        kii_ulong_t* compressed,
+        kii_ulong_t* decompressed);
+/* Socket and TLS options of connections opened after this call. */
+kii_bool_t kii_http_set_transport_profile(kii_transport_profile_t profile);
+/* Async requests to the same host are multiplexed over single HTTP/2
+ * connection. 0 disables it. Returns KII_FALSE if adapter doesn't support
+ * HTTP/2 or can't limit concurrent streams. */
+kii_bool_t kii_http_set_http2_multiplexing(kii_uint_t max_concurrent_streams);
+/* request_body is NULL if the request has no body.
+ * response_headers can be NULL if caller doesn't need them.
+ * response_sink can be NULL. response_body is NULL if the body is consumed
+ * by response_sink. */
 kii_bool_t kii_http_execute(
         const kii_char_t* http_method,
         const kii_char_t* url,
-        json_t* request_headers,
-        const kii_char_t* request_body,
+        const kii_http_headers_t* request_headers,
+        const kii_http_body_t* request_body,
         kii_int_t* status_code,
-        json_t** response_headers,
+        prv_kii_resp_headers_t* response_headers,
+        const kii_http_sink_t* response_sink,
         kii_char_t** response_body);
 
+/* Asynchronous execution.
+ * Requests are started by kii_http_async_execute and proceed while
+ * kii_http_async_poll is called. Arguments of kii_http_async_execute must
+ * remain valid until completion is called. */
+typedef struct prv_kii_http_async_t* kii_http_async_t;
+
+/* response_headers and response_body are disposed by adapter after
+ * completion returns. response_body is NULL if the body is consumed by
+ * response_sink. */
+typedef void (*kii_http_completion_t)(
+        kii_bool_t succeeded,
+        kii_int_t status_code,
+        const prv_kii_resp_headers_t* response_headers,
+        kii_char_t* response_body,
+        void* userdata);
+
+kii_http_async_t kii_http_async_init(void);
+/* Requests in flight are cancelled. completion is called with KII_FALSE. */
+void kii_http_async_cleanup(kii_http_async_t async);
+kii_bool_t kii_http_async_execute(
+        kii_http_async_t async,
+        const kii_char_t* http_method,
+        const kii_char_t* url,
+        const kii_http_headers_t* request_headers,
+        const kii_http_body_t* request_body,
+        const kii_http_sink_t* response_sink,
+        kii_http_completion_t completion,
+        void* userdata);
+/* Returns number of requests in flight after completions are called. */
+kii_uint_t kii_http_async_poll(kii_http_async_t async, kii_int_t timeout_in_ms);
+
 #ifdef __cplusplus
 }
 #endif
@@ -12,12 +12,30 @@
 extern "C" {
 #endif
 
+/* Number of header sets cached by app. An app is usually used with one
+ * access token for requests with and without body. */
+#define KII_HEADER_SETS 4
+
 typedef struct prv_kii_app_t {
     kii_char_t* app_id;
     kii_char_t* app_key;
     kii_char_t* site_url;
-    kii_error_code_t last_result;
-    kii_error_t last_error;
+    kii_char_t* base_url; /* site_url/apps/app_id */
+    size_t base_url_length;
+    struct prv_kii_http_async_t* async; /* created by first async request */
+    kii_bool_t disposing;
+    kii_uint_t compress_threshold; /* 0 if request is not compressed */
+    /* guarded by request_stats_mutex as requests may run in parallel. */
+    kii_ulong_t request_bytes; /* of bodies subject to compression */
+    kii_ulong_t request_compressed_bytes; /* of the bodies actually sent */
+    /* guarded by header_sets_mutex. NULL if slot is not used yet. */
+    struct prv_kii_header_set_t* header_sets[KII_HEADER_SETS];
+    kii_uint_t next_header_set; /* slot replaced by next new set */
+    /* NULL unless enabled by kii_app_set_request_context. */
+    struct prv_kii_req_context_t* req_context;
+    /* unique to the app, as other app may be allocated at the same address
+     * after it is disposed. */
+    kii_ulong_t generation;
 } prv_kii_app_t;
 
 typedef struct prv_kii_thing_t {
@@ -27,13 +45,85 @@ typedef struct prv_kii_thing_t {
 typedef struct prv_kii_bucket_t {
     kii_char_t* kii_thing_id;
     kii_char_t* bucket_name;
+    kii_char_t* path; /* things/kii_thing_id/buckets/bucket_name */
+    size_t path_length;
 } prv_kii_bucket_t;
 
 typedef struct prv_kii_topic_t {
     kii_char_t* kii_thing_id;
     kii_char_t* topic_name;
+    kii_char_t* path; /* things/kii_thing_id/topics/topic_name */
+    size_t path_length;
 } prv_kii_topic_t;
 
+#define KII_RESP_HEADER_ETAG_SIZE KII_ETAG_SIZE
+#define KII_RESP_HEADER_CONTENT_ENCODING_SIZE 32
+
+/* Response headers used by sdk.
+ * Filled by prv_parse_resp_header while adapter receives header lines.
+ * Values too long for the buffers are truncated. */
+typedef struct prv_kii_resp_headers_t {
+    kii_char_t etag[KII_RESP_HEADER_ETAG_SIZE]; /* empty if absent. */
+    long content_length; /* -1 if absent. */
+    kii_int_t retry_after; /* in seconds. -1 if absent. */
+    /* empty if absent. */
+    kii_char_t content_encoding[KII_RESP_HEADER_CONTENT_ENCODING_SIZE];
+    kii_bool_t chunked; /* Transfer-Encoding: chunked */
+    kii_bool_t connection_close; /* Connection: close */
+} prv_kii_resp_headers_t;
+
+/* What json parser expects next. */
+typedef enum prv_kii_json_expect_t {
+    PRV_KII_JSON_VALUE = 0,
+    PRV_KII_JSON_VALUE_OR_END, /* after '[' */
+    PRV_KII_JSON_KEY_OR_END, /* after '{' */
+    PRV_KII_JSON_KEY, /* after ',' in object */
+    PRV_KII_JSON_COLON, /* after key */
+    PRV_KII_JSON_NEXT_OR_END, /* after value in array or object */
+    PRV_KII_JSON_DONE,
+    PRV_KII_JSON_ERROR
+} prv_kii_json_expect_t;
+
+/* Token which json parser is in the middle of. */
+typedef enum prv_kii_json_token_t {
+    PRV_KII_JSON_TOKEN_NONE = 0,
+    PRV_KII_JSON_TOKEN_STRING,
+    PRV_KII_JSON_TOKEN_ESCAPE, /* after '\' in string */
+    PRV_KII_JSON_TOKEN_UNICODE, /* hex digits of "\u" escape */
+    PRV_KII_JSON_TOKEN_LOW_ESCAPE, /* '\' of low surrogate */
+    PRV_KII_JSON_TOKEN_LOW_U, /* 'u' of low surrogate */
+    PRV_KII_JSON_TOKEN_NUMBER,
+    PRV_KII_JSON_TOKEN_LITERAL /* true, false or null */
+} prv_kii_json_token_t;
+
+/* Array or object under construction. */
+typedef struct prv_kii_json_frame_t {
+    json_t* container; /* owned by parent or root. */
+    size_t key; /* offset of pending key in buffer. */
+} prv_kii_json_frame_t;
+
+/* Push style json parser.
+ * Fed by prv_feed_json_parser with pieces of text in any size as they are
+ * received, and builds json_t while text is fed. Zero filled parser is
+ * initialized. */
+typedef struct prv_kii_json_parser_t {
+    prv_kii_json_expect_t expect;
+    prv_kii_json_token_t token;
+    json_t* root;
+    prv_kii_json_frame_t* frames;
+    size_t depth;
+    size_t frames_capacity;
+    /* pending keys followed by text of current token. */
+    kii_char_t* buffer;
+    size_t length;
+    size_t capacity;
+    size_t token_begin;
+    unsigned long code; /* of "\u" escape */
+    unsigned long high_surrogate;
+    kii_int_t digits; /* read in "\u" escape or literal */
+    const kii_char_t* literal;
+} prv_kii_json_parser_t;
+
 #ifdef __cplusplus
 }
 #endif
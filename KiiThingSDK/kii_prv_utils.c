@@ -9,10 +9,17 @@
 #include "kii_prv_utils.h"
 #include "kii_prv_types.h"
 
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
 #include <stdarg.h>
+#if JSON_HAVE_LOCALECONV
+#include <locale.h>
+#endif
 
 static size_t prv_url_encoded_len(const char* element);
-static char* prv_url_encoded_copy(char* s1, const char* s2);
+/* Returns length of copied string. */
+static size_t prv_url_encoded_copy(char* s1, const char* s2);
 
 char* prv_build_url(const char* first, ...)
 {
@@ -46,18 +53,99 @@ char* prv_build_url(const char* first, ...)
     /* copy elements. */
     {
         const char* element = NULL;
+        size_t len = 0;
         va_list list;
         va_start(list, first);
 
         /* copy first element. */
-        prv_url_encoded_copy(retval, first);
+        len = prv_url_encoded_copy(retval, first);
 
         for (element = va_arg(list, char*); element != NULL;
                 element = va_arg(list, char*)) {
-            size_t len = kii_strlen(retval);
             retval[len] = '/';
-            retval[len + 1] = '\0';
-            prv_url_encoded_copy(&retval[len + 1], element);
+            len = len + 1 + prv_url_encoded_copy(&retval[len + 1], element);
+        }
+        va_end(list);
+    }
+
+    return retval;
+}
+
+kii_bool_t prv_reserve_buffer(char** buffer, size_t* capacity, size_t size)
+{
+    size_t newCapacity = *capacity;
+    char* newBuffer = NULL;
+
+    if (size <= *capacity) {
+        return KII_TRUE;
+    }
+    if (newCapacity < KII_BUFFER_MIN_SIZE) {
+        newCapacity = KII_BUFFER_MIN_SIZE;
+    }
+    while (newCapacity < size) {
+        newCapacity *= 2;
+    }
+    newBuffer = kii_realloc(*buffer, newCapacity);
+    if (newBuffer == NULL) {
+        return KII_FALSE;
+    }
+    *buffer = newBuffer;
+    *capacity = newCapacity;
+    return KII_TRUE;
+}
+
+char* prv_build_url_with_prefix(char** buffer,
+                                size_t* capacity,
+                                const char* base,
+                                size_t base_len,
+                                const char* opt_path,
+                                size_t path_len,
+                                ...)
+{
+    size_t size = base_len + 1;
+    size_t len = base_len;
+    char* retval = NULL;
+
+    M_KII_ASSERT(buffer != NULL);
+    M_KII_ASSERT(capacity != NULL);
+    M_KII_ASSERT(base != NULL);
+
+    if (opt_path != NULL) {
+        size = size + path_len + 1;
+    }
+    /* calculate size of following elements. */
+    {
+        const char* element = NULL;
+        va_list list;
+        va_start(list, path_len);
+        for (element = va_arg(list, char*); element != NULL;
+                element = va_arg(list, char*)) {
+            size = size + prv_url_encoded_len(element) + 1;
+        }
+        va_end(list);
+    }
+
+    if (prv_reserve_buffer(buffer, capacity, size) == KII_FALSE) {
+        return NULL;
+    }
+    retval = *buffer;
+
+    /* prefix is already encoded. */
+    kii_memcpy(retval, base, base_len);
+    if (opt_path != NULL) {
+        retval[len] = '/';
+        kii_memcpy(&retval[len + 1], opt_path, path_len);
+        len = len + 1 + path_len;
+    }
+    retval[len] = '\0';
+    {
+        const char* element = NULL;
+        va_list list;
+        va_start(list, path_len);
+        for (element = va_arg(list, char*); element != NULL;
+                element = va_arg(list, char*)) {
+            retval[len] = '/';
+            len = len + 1 + prv_url_encoded_copy(&retval[len + 1], element);
         }
         va_end(list);
     }
@@ -73,13 +161,17 @@ static size_t prv_url_encoded_len(const char* element)
     return kii_strlen(element);
 }
 
-static char* prv_url_encoded_copy(char* s1, const char* s2)
+static size_t prv_url_encoded_copy(char* s1, const char* s2)
 {
+    size_t len = 0;
+
     M_KII_ASSERT(s1 != NULL);
     M_KII_ASSERT(s2 != NULL);
 
     /* TODO: copy url encoded s2 string to s1. */
-    return kii_strncpy(s1, s2, kii_strlen(s2)+1);
+    len = kii_strlen(s2);
+    kii_memcpy(s1, s2, len + 1);
+    return len;
 }
 
 kii_char_t* prv_new_header_string(const kii_char_t* key,
@@ -128,6 +220,724 @@ kii_char_t* prv_new_auth_header_string(const kii_char_t* access_token)
     return ret;
 }
 
+void prv_init_resp_headers(prv_kii_resp_headers_t* headers)
+{
+    headers->etag[0] = '\0';
+    headers->content_length = -1;
+    headers->retry_after = -1;
+    headers->content_encoding[0] = '\0';
+    headers->chunked = KII_FALSE;
+    headers->connection_close = KII_FALSE;
+}
+
+/* Compare header name case-insensitively.
+ * name must be lower case. */
+static kii_bool_t prv_header_name_equals(const kii_char_t* line,
+                                        size_t nameLen,
+                                        const kii_char_t* name)
+{
+    size_t i = 0;
+    if (nameLen != kii_strlen(name)) {
+        return KII_FALSE;
+    }
+    for (i = 0; i < nameLen; ++i) {
+        if (kii_tolower(line[i]) != name[i]) {
+            return KII_FALSE;
+        }
+    }
+    return KII_TRUE;
+}
+
+/* Compare header value case-insensitively.
+ * token must be lower case. */
+static kii_bool_t prv_header_value_equals(const kii_char_t* value,
+                                         size_t valueLen,
+                                         const kii_char_t* token)
+{
+    return prv_header_name_equals(value, valueLen, token);
+}
+
+/* Compare last element of comma separated header value
+ * case-insensitively. token must be lower case. */
+static kii_bool_t prv_header_last_value_equals(const kii_char_t* value,
+                                              size_t valueLen,
+                                              const kii_char_t* token)
+{
+    size_t begin = valueLen;
+    while (begin > 0 && value[begin - 1] != ',') {
+        --begin;
+    }
+    while (begin < valueLen &&
+            (value[begin] == ' ' || value[begin] == '\t')) {
+        ++begin;
+    }
+    return prv_header_value_equals(value + begin, valueLen - begin, token);
+}
+
+static void prv_copy_header_value(kii_char_t* dest,
+                                  size_t destSize,
+                                  const kii_char_t* value,
+                                  size_t valueLen)
+{
+    if (valueLen > destSize - 1) {
+        valueLen = destSize - 1;
+    }
+    kii_memcpy(dest, value, valueLen);
+    dest[valueLen] = '\0';
+}
+
+/* Returns -1 if value is not a decimal number or it exceeds max. */
+static long prv_header_value_to_long(const kii_char_t* value,
+                                     size_t valueLen,
+                                     long max)
+{
+    long ret = 0;
+    size_t i = 0;
+    if (valueLen == 0) {
+        return -1;
+    }
+    for (i = 0; i < valueLen; ++i) {
+        long digit = value[i] - '0';
+        if (value[i] < '0' || value[i] > '9') {
+            return -1;
+        }
+        if (ret > (max - digit) / 10) {
+            return -1;
+        }
+        ret = ret * 10 + digit;
+    }
+    return ret;
+}
+
+void prv_parse_resp_header(const kii_char_t* line,
+                           size_t length,
+                           prv_kii_resp_headers_t* headers)
+{
+    size_t nameLen = 0;
+    const kii_char_t* value = NULL;
+    size_t valueLen = 0;
+
+    for (nameLen = 0; nameLen < length && line[nameLen] != ':'; ++nameLen) {
+        /* find end of name. */
+    }
+    if (nameLen == length) {
+        /* status line or end of headers. */
+        return;
+    }
+
+    /* trim spaces and line feed around value. */
+    value = line + nameLen + 1;
+    valueLen = length - nameLen - 1;
+    while (valueLen > 0 && (*value == ' ' || *value == '\t')) {
+        ++value;
+        --valueLen;
+    }
+    while (valueLen > 0 && (value[valueLen - 1] == '\r' ||
+                value[valueLen - 1] == '\n' || value[valueLen - 1] == ' ')) {
+        --valueLen;
+    }
+
+    if (prv_header_name_equals(line, nameLen, "etag") == KII_TRUE) {
+        prv_copy_header_value(headers->etag, sizeof(headers->etag), value,
+                valueLen);
+    } else if (prv_header_name_equals(line, nameLen, "content-length")
+            == KII_TRUE) {
+        headers->content_length = prv_header_value_to_long(value, valueLen,
+                LONG_MAX);
+    } else if (prv_header_name_equals(line, nameLen, "retry-after")
+            == KII_TRUE) {
+        /* HTTP-date form is not supported. */
+        headers->retry_after =
+            (kii_int_t)prv_header_value_to_long(value, valueLen, INT_MAX);
+    } else if (prv_header_name_equals(line, nameLen, "content-encoding")
+            == KII_TRUE) {
+        prv_copy_header_value(headers->content_encoding,
+                sizeof(headers->content_encoding), value, valueLen);
+    } else if (prv_header_name_equals(line, nameLen, "transfer-encoding")
+            == KII_TRUE) {
+        /* chunked must be the last coding applied. */
+        headers->chunked =
+            prv_header_last_value_equals(value, valueLen, "chunked");
+    } else if (prv_header_name_equals(line, nameLen, "connection")
+            == KII_TRUE) {
+        headers->connection_close =
+            prv_header_value_equals(value, valueLen, "close");
+    }
+}
+
+/* initial capacity of buffer and frames of json parser. */
+#define PRV_JSON_BUFFER_MIN_SIZE 256
+#define PRV_JSON_FRAMES_MIN_SIZE 8
+/* frame has no pending key. */
+#define PRV_JSON_NO_KEY ((size_t)-1)
+
+void prv_init_json_parser(prv_kii_json_parser_t* parser)
+{
+    kii_memset(parser, 0, sizeof(prv_kii_json_parser_t));
+}
+
+void prv_dispose_json_parser(prv_kii_json_parser_t* parser)
+{
+    json_decref(parser->root);
+    M_KII_FREE_NULLIFY(parser->frames);
+    M_KII_FREE_NULLIFY(parser->buffer);
+    prv_init_json_parser(parser);
+}
+
+static int prv_json_append(prv_kii_json_parser_t* parser,
+                           const kii_char_t* data,
+                           size_t size)
+{
+    if (parser->length + size > parser->capacity) {
+        size_t newCapacity = (parser->capacity > 0) ?
+            parser->capacity : PRV_JSON_BUFFER_MIN_SIZE;
+        kii_char_t* newBuffer = NULL;
+        while (newCapacity < parser->length + size) {
+            newCapacity *= 2;
+        }
+        newBuffer = kii_realloc(parser->buffer, newCapacity);
+        if (newBuffer == NULL) {
+            return -1;
+        }
+        parser->buffer = newBuffer;
+        parser->capacity = newCapacity;
+    }
+    kii_memcpy(&(parser->buffer[parser->length]), data, size);
+    parser->length += size;
+    return 0;
+}
+
+/* Validate UTF-8 as jansson does.
+ * Overlong forms, surrogates and code points over U+10FFFF are rejected. */
+static kii_bool_t prv_json_is_valid_utf8(const kii_char_t* str, size_t len)
+{
+    const unsigned char* s = (const unsigned char*)str;
+    size_t i = 0;
+    while (i < len) {
+        unsigned char c = s[i];
+        size_t count = 0;
+        unsigned char min = 0x80;
+        unsigned char max = 0xBF;
+        size_t j = 0;
+        if (c < 0x80) {
+            ++i;
+            continue;
+        } else if (c >= 0xC2 && c <= 0xDF) {
+            count = 1;
+        } else if (c >= 0xE0 && c <= 0xEF) {
+            count = 2;
+            if (c == 0xE0) {
+                min = 0xA0;
+            } else if (c == 0xED) {
+                max = 0x9F;
+            }
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            count = 3;
+            if (c == 0xF0) {
+                min = 0x90;
+            } else if (c == 0xF4) {
+                max = 0x8F;
+            }
+        } else {
+            return KII_FALSE;
+        }
+        if (i + count >= len) {
+            return KII_FALSE;
+        }
+        for (j = 1; j <= count; ++j) {
+            if (s[i + j] < min || s[i + j] > max) {
+                return KII_FALSE;
+            }
+            min = 0x80;
+            max = 0xBF;
+        }
+        i += count + 1;
+    }
+    return KII_TRUE;
+}
+
+/* Add value to current array or object, or make it root.
+ * Reference of value is stolen even if it fails. */
+static int prv_json_add_value(prv_kii_json_parser_t* parser, json_t* value)
+{
+    prv_kii_json_frame_t* frame = NULL;
+    int ret = 0;
+
+    if (value == NULL) {
+        return -1;
+    }
+    if (parser->depth == 0) {
+        parser->root = value;
+        parser->expect = PRV_KII_JSON_DONE;
+        return 0;
+    }
+    frame = &(parser->frames[parser->depth - 1]);
+    if (json_is_array(frame->container)) {
+        ret = json_array_append_new(frame->container, value);
+    } else {
+        ret = json_object_set_new_nocheck(frame->container,
+                &(parser->buffer[frame->key]), value);
+        /* pop the key. */
+        parser->length = frame->key;
+        frame->key = PRV_JSON_NO_KEY;
+    }
+    parser->expect = PRV_KII_JSON_NEXT_OR_END;
+    return ret;
+}
+
+static int prv_json_begin_container(prv_kii_json_parser_t* parser,
+                                    json_t* container,
+                                    prv_kii_json_expect_t expect)
+{
+    if (parser->depth == parser->frames_capacity) {
+        size_t newCapacity = (parser->frames_capacity > 0) ?
+            parser->frames_capacity * 2 : PRV_JSON_FRAMES_MIN_SIZE;
+        prv_kii_json_frame_t* newFrames = kii_realloc(parser->frames,
+                sizeof(prv_kii_json_frame_t) * newCapacity);
+        if (newFrames == NULL) {
+            json_decref(container);
+            return -1;
+        }
+        parser->frames = newFrames;
+        parser->frames_capacity = newCapacity;
+    }
+    /* container is kept alive by its parent or root. */
+    if (prv_json_add_value(parser, container) != 0) {
+        return -1;
+    }
+    parser->frames[parser->depth].container = container;
+    parser->frames[parser->depth].key = PRV_JSON_NO_KEY;
+    ++(parser->depth);
+    parser->expect = expect;
+    return 0;
+}
+
+static int prv_json_end_container(prv_kii_json_parser_t* parser,
+                                  kii_char_t c)
+{
+    json_t* container = parser->frames[parser->depth - 1].container;
+    if ((c == '}' && !json_is_object(container)) ||
+            (c == ']' && !json_is_array(container))) {
+        return -1;
+    }
+    --(parser->depth);
+    parser->expect = (parser->depth == 0) ?
+        PRV_KII_JSON_DONE : PRV_KII_JSON_NEXT_OR_END;
+    return 0;
+}
+
+static void prv_json_begin_token(prv_kii_json_parser_t* parser,
+                                 prv_kii_json_token_t token)
+{
+    parser->token = token;
+    parser->token_begin = parser->length;
+}
+
+static int prv_json_end_string(prv_kii_json_parser_t* parser)
+{
+    size_t len = parser->length - parser->token_begin;
+    const kii_char_t* str = NULL;
+    json_t* value = NULL;
+
+    parser->token = PRV_KII_JSON_TOKEN_NONE;
+    if (prv_json_append(parser, "", 1) != 0) {
+        return -1;
+    }
+    str = &(parser->buffer[parser->token_begin]);
+    if (prv_json_is_valid_utf8(str, len) == KII_FALSE) {
+        return -1;
+    }
+    if (parser->expect == PRV_KII_JSON_COLON) {
+        /* key is kept in buffer until its value is added. */
+        parser->frames[parser->depth - 1].key = parser->token_begin;
+        return 0;
+    }
+    value = json_string_nocheck(str);
+    parser->length = parser->token_begin;
+    return prv_json_add_value(parser, value);
+}
+
+/* Number is validated by the grammar of RFC 7159. */
+static kii_bool_t prv_json_is_valid_number(const kii_char_t* s,
+                                           kii_bool_t* is_real)
+{
+    *is_real = KII_FALSE;
+    if (*s == '-') {
+        ++s;
+    }
+    if (*s == '0') {
+        ++s;
+    } else if (*s >= '1' && *s <= '9') {
+        while (*s >= '0' && *s <= '9') {
+            ++s;
+        }
+    } else {
+        return KII_FALSE;
+    }
+    if (*s == '.') {
+        *is_real = KII_TRUE;
+        ++s;
+        if (*s < '0' || *s > '9') {
+            return KII_FALSE;
+        }
+        while (*s >= '0' && *s <= '9') {
+            ++s;
+        }
+    }
+    if (*s == 'e' || *s == 'E') {
+        *is_real = KII_TRUE;
+        ++s;
+        if (*s == '+' || *s == '-') {
+            ++s;
+        }
+        if (*s < '0' || *s > '9') {
+            return KII_FALSE;
+        }
+        while (*s >= '0' && *s <= '9') {
+            ++s;
+        }
+    }
+    return (*s == '\0') ? KII_TRUE : KII_FALSE;
+}
+
+static int prv_json_end_number(prv_kii_json_parser_t* parser)
+{
+    kii_char_t* str = NULL;
+    kii_char_t* end = NULL;
+    kii_bool_t isReal = KII_FALSE;
+    json_t* value = NULL;
+
+    parser->token = PRV_KII_JSON_TOKEN_NONE;
+    if (prv_json_append(parser, "", 1) != 0) {
+        return -1;
+    }
+    str = &(parser->buffer[parser->token_begin]);
+    if (prv_json_is_valid_number(str, &isReal) == KII_FALSE) {
+        return -1;
+    }
+    errno = 0;
+    if (isReal == KII_FALSE) {
+        json_int_t intValue = kii_strtoint(str, NULL);
+        if (errno == ERANGE) {
+            return -1;
+        }
+        value = json_integer(intValue);
+    } else {
+        double realValue = 0;
+#if JSON_HAVE_LOCALECONV
+        /* strtod expects decimal point of the locale like jansson does. */
+        kii_char_t* point = str;
+        while (*point != '\0' && *point != '.') {
+            ++point;
+        }
+        if (*point == '.') {
+            *point = localeconv()->decimal_point[0];
+        }
+#endif
+        realValue = kii_strtod(str, &end);
+        if (*end != '\0') {
+            return -1;
+        }
+        if (errno == ERANGE &&
+                (realValue == HUGE_VAL || realValue == -HUGE_VAL)) {
+            return -1;
+        }
+        value = json_real(realValue);
+    }
+    parser->length = parser->token_begin;
+    return prv_json_add_value(parser, value);
+}
+
+static int prv_json_end_literal(prv_kii_json_parser_t* parser)
+{
+    json_t* value = NULL;
+
+    parser->token = PRV_KII_JSON_TOKEN_NONE;
+    switch (parser->literal[0]) {
+        case 't':
+            value = json_true();
+            break;
+        case 'f':
+            value = json_false();
+            break;
+        default:
+            value = json_null();
+            break;
+    }
+    return prv_json_add_value(parser, value);
+}
+
+/* Append code point of "\u" escape as UTF-8.
+ * Surrogate pair is combined. NUL is rejected as jansson does. */
+static int prv_json_end_unicode(prv_kii_json_parser_t* parser)
+{
+    unsigned long code = parser->code;
+    kii_char_t utf8[4];
+    size_t len = 0;
+
+    if (parser->high_surrogate != 0) {
+        if (code < 0xDC00 || code > 0xDFFF) {
+            return -1;
+        }
+        code = 0x10000 + ((parser->high_surrogate - 0xD800) << 10) +
+            (code - 0xDC00);
+        parser->high_surrogate = 0;
+    } else if (code >= 0xD800 && code <= 0xDBFF) {
+        parser->high_surrogate = code;
+        parser->token = PRV_KII_JSON_TOKEN_LOW_ESCAPE;
+        return 0;
+    } else if ((code >= 0xDC00 && code <= 0xDFFF) || code == 0) {
+        return -1;
+    }
+
+    if (code < 0x80) {
+        utf8[0] = (kii_char_t)code;
+        len = 1;
+    } else if (code < 0x800) {
+        utf8[0] = (kii_char_t)(0xC0 | (code >> 6));
+        utf8[1] = (kii_char_t)(0x80 | (code & 0x3F));
+        len = 2;
+    } else if (code < 0x10000) {
+        utf8[0] = (kii_char_t)(0xE0 | (code >> 12));
+        utf8[1] = (kii_char_t)(0x80 | ((code >> 6) & 0x3F));
+        utf8[2] = (kii_char_t)(0x80 | (code & 0x3F));
+        len = 3;
+    } else {
+        utf8[0] = (kii_char_t)(0xF0 | (code >> 18));
+        utf8[1] = (kii_char_t)(0x80 | ((code >> 12) & 0x3F));
+        utf8[2] = (kii_char_t)(0x80 | ((code >> 6) & 0x3F));
+        utf8[3] = (kii_char_t)(0x80 | (code & 0x3F));
+        len = 4;
+    }
+    parser->token = PRV_KII_JSON_TOKEN_STRING;
+    return prv_json_append(parser, utf8, len);
+}
+
+static int prv_json_hex_value(kii_char_t c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+static int prv_json_escape(prv_kii_json_parser_t* parser, kii_char_t c)
+{
+    kii_char_t unescaped = '\0';
+    switch (c) {
+        case '"':
+        case '\\':
+        case '/':
+            unescaped = c;
+            break;
+        case 'b':
+            unescaped = '\b';
+            break;
+        case 'f':
+            unescaped = '\f';
+            break;
+        case 'n':
+            unescaped = '\n';
+            break;
+        case 'r':
+            unescaped = '\r';
+            break;
+        case 't':
+            unescaped = '\t';
+            break;
+        case 'u':
+            parser->token = PRV_KII_JSON_TOKEN_UNICODE;
+            parser->code = 0;
+            parser->digits = 0;
+            return 0;
+        default:
+            return -1;
+    }
+    parser->token = PRV_KII_JSON_TOKEN_STRING;
+    return prv_json_append(parser, &unescaped, 1);
+}
+
+/* Handle a character out of tokens. */
+static int prv_json_structure(prv_kii_json_parser_t* parser, kii_char_t c)
+{
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+        return 0;
+    }
+    switch (parser->expect) {
+        case PRV_KII_JSON_VALUE_OR_END:
+            if (c == ']') {
+                return prv_json_end_container(parser, c);
+            }
+            /* fall through */
+        case PRV_KII_JSON_VALUE:
+            if (c == '{') {
+                return prv_json_begin_container(parser, json_object(),
+                        PRV_KII_JSON_KEY_OR_END);
+            } else if (c == '[') {
+                return prv_json_begin_container(parser, json_array(),
+                        PRV_KII_JSON_VALUE_OR_END);
+            } else if (parser->depth == 0) {
+                /* top level must be object or array. */
+                return -1;
+            } else if (c == '"') {
+                prv_json_begin_token(parser, PRV_KII_JSON_TOKEN_STRING);
+                return 0;
+            } else if (c == '-' || (c >= '0' && c <= '9')) {
+                prv_json_begin_token(parser, PRV_KII_JSON_TOKEN_NUMBER);
+                return prv_json_append(parser, &c, 1);
+            } else if (c == 't' || c == 'f' || c == 'n') {
+                prv_json_begin_token(parser, PRV_KII_JSON_TOKEN_LITERAL);
+                parser->literal = (c == 't') ? "true" :
+                    ((c == 'f') ? "false" : "null");
+                parser->digits = 1;
+                return 0;
+            }
+            return -1;
+        case PRV_KII_JSON_KEY_OR_END:
+            if (c == '}') {
+                return prv_json_end_container(parser, c);
+            }
+            /* fall through */
+        case PRV_KII_JSON_KEY:
+            if (c == '"') {
+                parser->expect = PRV_KII_JSON_COLON;
+                prv_json_begin_token(parser, PRV_KII_JSON_TOKEN_STRING);
+                return 0;
+            }
+            return -1;
+        case PRV_KII_JSON_COLON:
+            if (c == ':') {
+                parser->expect = PRV_KII_JSON_VALUE;
+                return 0;
+            }
+            return -1;
+        case PRV_KII_JSON_NEXT_OR_END:
+            if (c == ',') {
+                parser->expect = json_is_object(
+                        parser->frames[parser->depth - 1].container) ?
+                    PRV_KII_JSON_KEY : PRV_KII_JSON_VALUE;
+                return 0;
+            } else if (c == '}' || c == ']') {
+                return prv_json_end_container(parser, c);
+            }
+            return -1;
+        default:
+            /* only white spaces can follow top level value. */
+            return -1;
+    }
+}
+
+int prv_feed_json_parser(prv_kii_json_parser_t* parser,
+                         const kii_char_t* data,
+                         size_t size)
+{
+    size_t i = 0;
+    int ret = 0;
+
+    while (i < size && ret == 0 && parser->expect != PRV_KII_JSON_ERROR) {
+        kii_char_t c = data[i];
+        switch (parser->token) {
+            case PRV_KII_JSON_TOKEN_STRING:
+                {
+                    /* copy run of plain characters at once. */
+                    size_t begin = i;
+                    while (i < size && data[i] != '"' && data[i] != '\\' &&
+                            (unsigned char)data[i] >= 0x20) {
+                        ++i;
+                    }
+                    ret = prv_json_append(parser, &(data[begin]), i - begin);
+                    if (ret != 0 || i == size) {
+                        break;
+                    }
+                    c = data[i++];
+                    if (c == '"') {
+                        ret = prv_json_end_string(parser);
+                    } else if (c == '\\') {
+                        parser->token = PRV_KII_JSON_TOKEN_ESCAPE;
+                    } else {
+                        /* control characters must be escaped. */
+                        ret = -1;
+                    }
+                }
+                break;
+            case PRV_KII_JSON_TOKEN_ESCAPE:
+                ret = prv_json_escape(parser, c);
+                ++i;
+                break;
+            case PRV_KII_JSON_TOKEN_UNICODE:
+                if (prv_json_hex_value(c) < 0) {
+                    ret = -1;
+                    break;
+                }
+                parser->code = parser->code * 16 +
+                    (unsigned long)prv_json_hex_value(c);
+                if (++(parser->digits) == 4) {
+                    ret = prv_json_end_unicode(parser);
+                }
+                ++i;
+                break;
+            case PRV_KII_JSON_TOKEN_LOW_ESCAPE:
+                parser->token = PRV_KII_JSON_TOKEN_LOW_U;
+                ret = (c == '\\') ? 0 : -1;
+                ++i;
+                break;
+            case PRV_KII_JSON_TOKEN_LOW_U:
+                parser->token = PRV_KII_JSON_TOKEN_UNICODE;
+                parser->code = 0;
+                parser->digits = 0;
+                ret = (c == 'u') ? 0 : -1;
+                ++i;
+                break;
+            case PRV_KII_JSON_TOKEN_NUMBER:
+                if ((c >= '0' && c <= '9') || c == '-' || c == '+' ||
+                        c == '.' || c == 'e' || c == 'E') {
+                    ret = prv_json_append(parser, &c, 1);
+                    ++i;
+                } else {
+                    /* the character is handled after the number. */
+                    ret = prv_json_end_number(parser);
+                }
+                break;
+            case PRV_KII_JSON_TOKEN_LITERAL:
+                if (c != parser->literal[parser->digits]) {
+                    ret = -1;
+                    break;
+                }
+                ++i;
+                if (parser->literal[++(parser->digits)] == '\0') {
+                    ret = prv_json_end_literal(parser);
+                }
+                break;
+            default:
+                ret = prv_json_structure(parser, c);
+                ++i;
+                break;
+        }
+    }
+
+    if (ret != 0 || parser->expect == PRV_KII_JSON_ERROR) {
+        parser->expect = PRV_KII_JSON_ERROR;
+        return -1;
+    }
+    return 0;
+}
+
+json_t* prv_finish_json_parser(prv_kii_json_parser_t* parser)
+{
+    json_t* ret = NULL;
+    if (parser->expect == PRV_KII_JSON_DONE &&
+            parser->token == PRV_KII_JSON_TOKEN_NONE) {
+        ret = parser->root;
+        parser->root = NULL;
+    }
+    prv_dispose_json_parser(parser);
+    return ret;
+}
+
 int prv_log(const char* format, ...)
 {
     int retval = 0;
@@ -26,11 +26,65 @@ extern "C" {
 /* Returned value of this method must be freed by caller of this method. */
 char* prv_build_url(const char* first, ...);
 
+/* Minimum capacity of buffers grown by prv_reserve_buffer. */
+#define KII_BUFFER_MIN_SIZE 256
+
+/* Grow buffer allocated by kii_malloc so that it holds at least size bytes.
+ * Contents are kept. *buffer can be NULL with *capacity 0.
+ * Returns KII_FALSE if it can't be grown, leaving buffer as is. */
+kii_bool_t prv_reserve_buffer(char** buffer, size_t* capacity, size_t size);
+
+/* Same as prv_build_url but url starts with base and opt_path, which are
+ * built by prv_build_url beforehand. They are copied as is with lengths
+ * already known. Elements following them are passed as the rest of
+ * arguments and the last one must be NULL.
+ * url is built in *buffer, which is grown by prv_reserve_buffer if it is
+ * too small, so that buffer can be reused for urls of later requests.
+ * Returns *buffer or NULL if it can't be grown. */
+char* prv_build_url_with_prefix(char** buffer,
+                                size_t* capacity,
+                                const char* base,
+                                size_t base_len,
+                                const char* opt_path,
+                                size_t path_len,
+                                ...);
+
 kii_char_t* prv_new_header_string(const kii_char_t* key,
                                   const kii_char_t* value);
 
 kii_char_t* prv_new_auth_header_string(const kii_char_t* access_token);
 
+struct prv_kii_resp_headers_t;
+
+/* Initialize headers as all of them are absent. */
+void prv_init_resp_headers(struct prv_kii_resp_headers_t* headers);
+
+/* Parse a response header line in place without allocation.
+ * line doesn't need to be NUL terminated and may end with CRLF.
+ * Lines other than the headers used by sdk are ignored. */
+void prv_parse_resp_header(const kii_char_t* line,
+                           size_t length,
+                           struct prv_kii_resp_headers_t* headers);
+
+struct prv_kii_json_parser_t;
+
+void prv_init_json_parser(struct prv_kii_json_parser_t* parser);
+
+/* Parse a piece of json text.
+ * Text can be split at any byte. Returns 0 on success or -1 if text is not
+ * valid json. Once it fails, following calls fail as well. */
+int prv_feed_json_parser(struct prv_kii_json_parser_t* parser,
+                         const kii_char_t* data,
+                         size_t size);
+
+/* Returns parsed object or array and initializes parser.
+ * Returns NULL if text is invalid or incomplete. As json_loads without
+ * flags, top level value must be object or array.
+ * Returned value must be decref'ed by caller. */
+json_t* prv_finish_json_parser(struct prv_kii_json_parser_t* parser);
+
+void prv_dispose_json_parser(struct prv_kii_json_parser_t* parser);
+
 int prv_log(const char* format, ...);
 int prv_log_no_LF(const char* format, ...);
 
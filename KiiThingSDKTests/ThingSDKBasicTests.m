@@ -507,6 +507,372 @@ ON_EXIT:
     json_decref(out_contents);
 }
 
+- (void)testGetObjectRaw {
+    kii_app_t app = kii_init_app(APPID, APPKEY, BASEURL);
+    kii_thing_t thing = kii_thing_deserialize(REGISTERED_THING_TID);
+    kii_bucket_t bucket = kii_init_thing_bucket(thing, "myBucket");
+    json_t* contents = json_pack("{s:s}", "test_field", "test_value");
+    kii_char_t* out_object_id = NULL;
+    kii_char_t* create_etag = NULL;
+    kii_char_t buffer[256];
+    kii_char_t small[8];
+    kii_char_t etag[KII_ETAG_SIZE];
+    size_t length = 0;
+    size_t truncatedLength = 0;
+    kii_error_code_t ret = KIIE_FAIL;
+
+    ret = kii_create_new_object(app, ACCESS_TOKEN, bucket,
+            contents, &out_object_id, &create_etag);
+    XCTAssertEqual(ret, KIIE_OK, @"create new object failed.");
+
+    ret = kii_get_object_raw(app, ACCESS_TOKEN, bucket, out_object_id,
+            buffer, sizeof(buffer), &length, etag);
+    XCTAssertEqual(ret, KIIE_OK, @"get object raw failed.");
+    XCTAssertEqual(strlen(buffer), length);
+    XCTAssertTrue(strstr(buffer, "test_value") != NULL ? YES : NO,
+            @"unexpected contents: %s", buffer);
+    XCTAssertTrue(strcmp(create_etag, etag) == 0 ? YES : NO,
+            @"etag unmatched: %s , %s", create_etag, etag);
+
+    ret = kii_get_object_raw(app, ACCESS_TOKEN, bucket, out_object_id,
+            small, sizeof(small), &truncatedLength, NULL);
+    XCTAssertEqual(ret, KIIE_TRUNCATED);
+    XCTAssertEqual(truncatedLength, length);
+    XCTAssertTrue(strncmp(buffer, small, sizeof(small) - 1) == 0 ? YES : NO);
+    XCTAssertEqual(small[sizeof(small) - 1], '\0');
+
+    kii_dispose_app(app);
+    kii_dispose_thing(thing);
+    kii_dispose_bucket(bucket);
+    json_decref(contents);
+    kii_dispose_kii_char(out_object_id);
+    kii_dispose_kii_char(create_etag);
+}
+
+- (void)testCreateNewObjects {
+    kii_app_t app = kii_init_app(APPID, APPKEY, BASEURL);
+    kii_thing_t thing = kii_thing_deserialize(REGISTERED_THING_TID);
+    kii_bucket_t bucket = kii_init_thing_bucket(thing, "myBucket");
+    json_t* contents[5];
+    kii_object_result_t results[5];
+    kii_error_code_t ret = KIIE_FAIL;
+
+    for (int i = 0; i < 5; ++i) {
+        contents[i] = json_pack("{s:i}", "seq", i);
+    }
+    ret = kii_create_new_objects(app, ACCESS_TOKEN, bucket,
+            (const json_t* const*)contents, 5, 2, results);
+    XCTAssertEqual(ret, KIIE_OK, @"create new objects failed.");
+
+    // results are in the same order as contents.
+    for (int i = 0; i < 5; ++i) {
+        json_t* out_contents = NULL;
+        kii_char_t* etag = NULL;
+        XCTAssertEqual(results[i].result, KIIE_OK);
+        XCTAssertTrue(results[i].object_id != NULL ? YES : NO);
+        ret = kii_get_object(app, ACCESS_TOKEN, bucket, results[i].object_id,
+                &out_contents, &etag);
+        XCTAssertEqual(ret, KIIE_OK, @"get object failed.");
+        XCTAssertEqual(json_integer_value(json_object_get(out_contents,
+                        "seq")), i);
+        XCTAssertTrue(strcmp(results[i].etag, etag) == 0 ? YES : NO,
+                @"etag unmatched: %s , %s", results[i].etag, etag);
+        json_decref(out_contents);
+        kii_dispose_kii_char(etag);
+    }
+
+    kii_dispose_object_results(results, 5);
+    for (int i = 0; i < 5; ++i) {
+        json_decref(contents[i]);
+    }
+    kii_dispose_app(app);
+    kii_dispose_thing(thing);
+    kii_dispose_bucket(bucket);
+}
+
+- (void)testGetObjects {
+    kii_app_t app = kii_init_app(APPID, APPKEY, BASEURL);
+    kii_thing_t thing = kii_thing_deserialize(REGISTERED_THING_TID);
+    kii_bucket_t bucket = kii_init_thing_bucket(thing, "myBucket");
+    json_t* contents = json_pack("{s:s}", "test_field", "test_value");
+    kii_char_t* out_object_id = NULL;
+    kii_char_t* create_etag = NULL;
+    kii_object_result_t results[2];
+    kii_error_code_t ret = KIIE_FAIL;
+
+    ret = kii_create_new_object(app, ACCESS_TOKEN, bucket,
+            contents, &out_object_id, &create_etag);
+    XCTAssertEqual(ret, KIIE_OK, @"create new object failed.");
+
+    const kii_char_t* objectIds[] = { out_object_id, "notExistingObjectID" };
+    ret = kii_get_objects(app, ACCESS_TOKEN, bucket, objectIds, 2, 2,
+            results);
+    XCTAssertEqual(ret, KIIE_FAIL, @"get objects must fail.");
+    kii_error_t* err = kii_get_last_error(app);
+    XCTAssertTrue(err != NULL ? YES : NO, @"err must not be NULL");
+    XCTAssertEqual(err->status_code, 404);
+
+    XCTAssertEqual(results[0].result, KIIE_OK);
+    XCTAssertTrue(strcmp("test_value", json_string_value(json_object_get(
+                        results[0].contents, "test_field"))) == 0 ? YES : NO);
+    XCTAssertTrue(strcmp(create_etag, results[0].etag) == 0 ? YES : NO,
+            @"etag unmatched: %s , %s", create_etag, results[0].etag);
+    XCTAssertEqual(results[1].result, KIIE_FAIL);
+    XCTAssertEqual(results[1].error.status_code, 404);
+    XCTAssertTrue(strcmp("OBJECT_NOT_FOUND", results[1].error.error_code)
+            == 0 ? YES : NO);
+    XCTAssertTrue(results[1].contents == NULL ? YES : NO);
+
+    kii_dispose_object_results(results, 2);
+    kii_dispose_app(app);
+    kii_dispose_thing(thing);
+    kii_dispose_bucket(bucket);
+    json_decref(contents);
+    kii_dispose_kii_char(out_object_id);
+    kii_dispose_kii_char(create_etag);
+}
+
+// Threads share an app. Each of them must see its own error.
+- (void)testLastErrorFromThreads {
+    kii_app_t app = kii_init_app(APPID, APPKEY, BASEURL);
+    kii_thing_t thing = kii_thing_deserialize(REGISTERED_THING_TID);
+    kii_bucket_t bucket = kii_init_thing_bucket(thing, "myBucket");
+
+    dispatch_apply(4, dispatch_get_global_queue(
+            DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t index) {
+        json_t* contents = json_object();
+        for (int i = 0; i < 5; ++i) {
+            kii_char_t* objectId = NULL;
+            kii_char_t* etag = NULL;
+            json_t* out_contents = NULL;
+            kii_error_code_t ret = kii_get_object(app, ACCESS_TOKEN, bucket,
+                    "notExistingObjectID", &out_contents, &etag);
+            XCTAssertEqual(ret, KIIE_FAIL, @"get object must fail.");
+            kii_error_t* err = kii_get_last_error(app);
+            XCTAssertTrue(err != NULL ? YES : NO, @"err must not be NULL");
+            XCTAssertEqual(err->status_code, 404);
+            XCTAssertTrue(strcmp(err->error_code, "OBJECT_NOT_FOUND") == 0 ?
+                    YES : NO, @"unexpected code: %s", err->error_code);
+            json_decref(out_contents);
+            kii_dispose_kii_char(etag);
+            etag = NULL;
+
+            ret = kii_create_new_object(app, ACCESS_TOKEN, bucket, contents,
+                    &objectId, &etag);
+            XCTAssertEqual(ret, KIIE_OK, @"create new object failed.");
+            XCTAssertTrue(kii_get_last_error(app) == NULL ? YES : NO,
+                    @"error of other thread is visible.");
+            kii_dispose_kii_char(objectId);
+            kii_dispose_kii_char(etag);
+        }
+        json_decref(contents);
+    });
+
+    kii_dispose_app(app);
+    kii_dispose_thing(thing);
+    kii_dispose_bucket(bucket);
+}
+
+- (void)testReplaceObjectRaw {
+    kii_app_t app = kii_init_app(APPID, APPKEY, BASEURL);
+    kii_thing_t thing = kii_thing_deserialize(REGISTERED_THING_TID);
+    kii_bucket_t bucket = kii_init_thing_bucket(thing, "myBucket");
+    const char contents[] = "{\"test_field\":\"test_value\"}";
+    json_t* out_contents = NULL;
+    kii_char_t* out_etag = NULL;
+    kii_error_code_t ret = KIIE_FAIL;
+
+    kii_delete_object(app, ACCESS_TOKEN, bucket, "myObjectID");
+    ret = kii_create_new_object_with_id_raw(app, ACCESS_TOKEN, bucket,
+            "myObjectID", "{}", 2, NULL);
+    XCTAssertEqual(ret, KIIE_OK, "kii_create_new_object_with_id_raw failed.");
+    ret = kii_replace_object_raw(app, ACCESS_TOKEN, bucket, "myObjectID",
+            contents, strlen(contents), NULL, &out_etag);
+    XCTAssertEqual(ret, KIIE_OK, "kii_replace_object_raw failed.");
+    XCTAssertTrue(out_etag != NULL ? YES : NO, "out_etag is NULL.");
+    kii_dispose_kii_char(out_etag);
+    out_etag = NULL;
+
+    ret = kii_get_object(app, ACCESS_TOKEN, bucket, "myObjectID",
+            &out_contents, &out_etag);
+    XCTAssertEqual(ret, KIIE_OK, "kii_get_object failed.");
+    XCTAssertTrue(strcmp("test_value", json_string_value(
+            json_object_get(out_contents, "test_field"))) == 0 ? YES : NO);
+
+    kii_dispose_app(app);
+    kii_dispose_thing(thing);
+    kii_dispose_bucket(bucket);
+    kii_dispose_kii_char(out_etag);
+    json_decref(out_contents);
+}
+
+// Object writes must not allocate once request context has grown.
+- (void)testReplaceObjectWithRequestContext {
+    kii_app_t app = kii_init_app(APPID, APPKEY, BASEURL);
+    kii_thing_t thing = kii_thing_deserialize(REGISTERED_THING_TID);
+    kii_bucket_t bucket = kii_init_thing_bucket(thing, "myBucket");
+    json_t* contents = json_object();
+    kii_error_code_t ret = KIIE_FAIL;
+    unsigned long allocations = 0;
+
+    XCTAssertEqual(kii_app_set_request_context(app, KII_TRUE), KIIE_OK);
+    kii_delete_object(app, ACCESS_TOKEN, bucket, "myObjectID");
+    ret = kii_create_new_object_with_id(app, ACCESS_TOKEN, bucket,
+            "myObjectID", contents, NULL);
+    XCTAssertEqual(ret, KIIE_OK, "kii_create_new_object_with_id failed.");
+
+    for (int i = 0; i < 5; ++i) {
+        unsigned long before = 0;
+        json_object_set_new(contents, "count", json_integer(i));
+        before = kii_get_allocation_count();
+        ret = kii_replace_object(app, ACCESS_TOKEN, bucket,
+                "myObjectID", contents, NULL, NULL);
+        allocations = kii_get_allocation_count() - before;
+        XCTAssertEqual(ret, KIIE_OK, "kii_replace_object failed.");
+    }
+    XCTAssertEqual(allocations, 0UL, @"replace allocated after warm-up.");
+
+    kii_dispose_app(app);
+    kii_dispose_thing(thing);
+    kii_dispose_bucket(bucket);
+    json_decref(contents);
+}
+
+// Compressed object writes reuse the deflate stream of request context.
+- (void)testReplaceObjectCompressedWithRequestContext {
+    kii_app_t app = kii_init_app(APPID, APPKEY, BASEURL);
+    kii_thing_t thing = kii_thing_deserialize(REGISTERED_THING_TID);
+    kii_bucket_t bucket = kii_init_thing_bucket(thing, "myBucket");
+    json_t* contents = json_pack("{s:s}", "text",
+            "compressed body longer than the threshold of compression.");
+    kii_error_code_t ret = KIIE_FAIL;
+    unsigned long allocations = 0;
+
+    XCTAssertEqual(kii_app_set_request_context(app, KII_TRUE), KIIE_OK);
+    kii_app_set_request_compression(app, 16);
+    kii_delete_object(app, ACCESS_TOKEN, bucket, "myObjectID");
+    ret = kii_create_new_object_with_id(app, ACCESS_TOKEN, bucket,
+            "myObjectID", contents, NULL);
+    XCTAssertEqual(ret, KIIE_OK, "kii_create_new_object_with_id failed.");
+
+    for (int i = 0; i < 5; ++i) {
+        unsigned long before = 0;
+        json_object_set_new(contents, "count", json_integer(i));
+        before = kii_get_allocation_count();
+        ret = kii_replace_object(app, ACCESS_TOKEN, bucket,
+                "myObjectID", contents, NULL, NULL);
+        allocations = kii_get_allocation_count() - before;
+        XCTAssertEqual(ret, KIIE_OK, "kii_replace_object failed.");
+    }
+    XCTAssertEqual(allocations, 0UL, @"replace allocated after warm-up.");
+
+    kii_dispose_app(app);
+    kii_dispose_thing(thing);
+    kii_dispose_bucket(bucket);
+    json_decref(contents);
+}
+
+- (void)testGetObjectCompressed {
+    kii_app_t app = kii_init_app(APPID, APPKEY, BASEURL);
+    kii_thing_t thing = kii_thing_deserialize(REGISTERED_THING_TID);
+    kii_bucket_t bucket = kii_init_thing_bucket(thing, "myBucket");
+    json_t* contents = json_object();
+    kii_char_t* out_object_id = NULL;
+    kii_char_t* create_etag = NULL;
+    kii_char_t* get_etag = NULL;
+    json_t* out_contents = NULL;
+    kii_compression_stats_t before;
+    kii_compression_stats_t after;
+    kii_error_code_t ret = KIIE_FAIL;
+    int i = 0;
+
+    /* large enough for server to compress. */
+    for (i = 0; i < 100; ++i) {
+        char key[16];
+        sprintf(key, "key%d", i);
+        json_object_set_new(contents, key, json_string("compressible value"));
+    }
+    XCTAssertEqual(kii_global_set_response_compression(KII_TRUE), KIIE_OK);
+    kii_global_get_compression_stats(&before);
+
+    ret = kii_create_new_object(app, ACCESS_TOKEN, bucket,
+            contents, &out_object_id, &create_etag);
+    XCTAssertEqual(ret, KIIE_OK, @"create new object failed.");
+    ret = kii_get_object(app, ACCESS_TOKEN, bucket, out_object_id,
+            &out_contents, &get_etag);
+    XCTAssertEqual(ret, KIIE_OK, @"get object failed.");
+    XCTAssertTrue(strcmp("compressible value", json_string_value(
+            json_object_get(out_contents, "key99"))) == 0 ? YES : NO);
+
+    kii_global_get_compression_stats(&after);
+    XCTAssertTrue(after.decompressed_bytes - before.decompressed_bytes >
+            after.compressed_bytes - before.compressed_bytes ? YES : NO,
+            @"response is not compressed.");
+
+    kii_global_set_response_compression(KII_FALSE);
+    kii_dispose_app(app);
+    kii_dispose_thing(thing);
+    kii_dispose_bucket(bucket);
+    json_decref(contents);
+    kii_dispose_kii_char(out_object_id);
+    kii_dispose_kii_char(create_etag);
+    kii_dispose_kii_char(get_etag);
+    json_decref(out_contents);
+}
+
+static void asyncCallback(kii_app_t app, kii_error_code_t result, void* userdata)
+{
+    kii_error_code_t* out_result = (kii_error_code_t*)userdata;
+    *out_result = result;
+}
+
+- (void)testCreateAndGetObjectAsync {
+    kii_app_t app = kii_init_app(APPID, APPKEY, BASEURL);
+    kii_thing_t thing = kii_thing_deserialize(REGISTERED_THING_TID);
+    kii_bucket_t bucket = NULL;
+    json_t* contents = json_object();
+    kii_char_t* out_object_id = NULL;
+    kii_char_t* create_etag = NULL;
+    kii_char_t* get_etag = NULL;
+    json_t* out_contents = NULL;
+    kii_error_code_t create_result = KIIE_FAIL;
+    kii_error_code_t get_result = KIIE_FAIL;
+    kii_error_code_t ret =  KIIE_FAIL;
+
+    bucket = kii_init_thing_bucket(thing, "myBucket");
+    ret = kii_create_new_object_async(app, ACCESS_TOKEN, bucket,
+            contents, &out_object_id, &create_etag, asyncCallback,
+            &create_result);
+    XCTAssertEqual(ret, KIIE_OK, @"create new object not started.");
+    kii_app_run(app);
+    XCTAssertEqual(create_result, KIIE_OK, @"create new object failed.");
+    XCTAssertTrue(out_object_id != NULL ? YES : NO,
+            @"out_object_id must not be NULL");
+    XCTAssertTrue(create_etag != NULL ? YES : NO,
+            @"create_etag must not be NULL");
+
+    ret = kii_get_object_async(app, ACCESS_TOKEN, bucket, out_object_id,
+            &out_contents, &get_etag, asyncCallback, &get_result);
+    XCTAssertEqual(ret, KIIE_OK, @"get object not started.");
+    XCTAssertEqual(kii_app_poll(app, 0), 1, @"get object must be in flight.");
+    kii_app_run(app);
+    XCTAssertEqual(get_result, KIIE_OK, @"get object failed.");
+    const char* object_id =
+        json_string_value(json_object_get(out_contents, "_id"));
+    XCTAssertTrue(strcmp(out_object_id, object_id) == 0 ? YES : NO,
+            @"object id unmatached: %s %s", out_object_id, object_id);
+    XCTAssertTrue(get_etag != NULL ? YES : NO, @"get_etag must not be NULL");
+
+    kii_dispose_app(app);
+    kii_dispose_thing(thing);
+    kii_dispose_bucket(bucket);
+    json_decref(contents);
+    kii_dispose_kii_char(out_object_id);
+    kii_dispose_kii_char(create_etag);
+    kii_dispose_kii_char(get_etag);
+    json_decref(out_contents);
+}
+
 -(void) testDeleteObject {
     kii_app_t app = kii_init_app(APPID, APPKEY, BASEURL);
     kii_thing_t thing = kii_thing_deserialize(REGISTERED_THING_TID);
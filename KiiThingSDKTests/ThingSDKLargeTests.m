@@ -20,6 +20,13 @@ static const char* APPID = "84fff36e";
 static const char* APPKEY = "e45fcc2d31d6aca675af639bc5f04a26";
 static const char* BASEURL = "https://api-development-jp.internal.kii.com/api";
 
+// Pre registered thing.
+static const char* ACCESS_TOKEN = "t6cV3HB65osoG9i0Yndkphk75F7XdswTt8KvL874-wY";
+static const char* REGISTERED_THING_TID = "th.53ae324be5a0-f808-4e11-d106-0241b0da";
+
+static const int NUM_SEQUENTIAL_CALLS = 10;
+static const int NUM_PARALLEL_CALLS = 32;
+
 - (void)setUp {
     [super setUp];
 }
@@ -61,4 +68,328 @@ static const char* BASEURL = "https://api-development-jp.internal.kii.com/api";
     kii_dispose_thing(thing);
     kii_dispose_kii_char(token);
 }
+
+// Create and patch objects sequentially to measure per-call latency.
+-(void) measureSequentialCalls {
+    kii_app_t app = kii_init_app(APPID, APPKEY, BASEURL);
+    kii_thing_t thing = kii_thing_deserialize(REGISTERED_THING_TID);
+    kii_bucket_t bucket = kii_init_thing_bucket(thing, "benchBucket");
+    json_t* contents = json_object();
+    json_object_set_new(contents, "temperature", json_integer(25));
+
+    [self measureBlock:^{
+        for (int i = 0; i < NUM_SEQUENTIAL_CALLS; ++i) {
+            kii_char_t* objectId = NULL;
+            kii_char_t* etag = NULL;
+            kii_error_code_t ret = kii_create_new_object(app, ACCESS_TOKEN,
+                    bucket, contents, &objectId, &etag);
+            XCTAssertEqual(ret, KIIE_OK, @"create object failed");
+            kii_dispose_kii_char(etag);
+            etag = NULL;
+            ret = kii_patch_object(app, ACCESS_TOKEN, bucket, objectId,
+                    contents, NULL, &etag);
+            XCTAssertEqual(ret, KIIE_OK, @"patch object failed");
+            kii_dispose_kii_char(etag);
+            kii_dispose_kii_char(objectId);
+        }
+    }];
+
+    json_decref(contents);
+    kii_dispose_bucket(bucket);
+    kii_dispose_thing(thing);
+    kii_dispose_app(app);
+}
+
+-(void) testSequentialCallsWithConnectionPool {
+    kii_global_init();
+    kii_global_set_connection_pool(4, 60);
+    [self measureSequentialCalls];
+    kii_global_cleanup();
+}
+
+-(void) testSequentialCallsWithoutConnectionPool {
+    kii_global_init();
+    kii_global_set_connection_pool(0, 0);
+    [self measureSequentialCalls];
+    kii_global_cleanup();
+}
+
+-(void) testSequentialCallsWithLowLatencyProfile {
+    kii_global_init();
+    kii_global_set_connection_pool(0, 0);
+    XCTAssertEqual(kii_global_set_transport_profile(KII_TRANSPORT_LOW_LATENCY),
+            KIIE_OK);
+    [self measureSequentialCalls];
+    kii_global_cleanup();
+}
+
+// Replace an object holding telemetry samples to compare CPU time spent on
+// each request against bytes saved by request compression.
+-(void) measureReplaceTelemetry:(kii_uint_t)threshold {
+    kii_app_t app = kii_init_app(APPID, APPKEY, BASEURL);
+    kii_thing_t thing = kii_thing_deserialize(REGISTERED_THING_TID);
+    kii_bucket_t bucket = kii_init_thing_bucket(thing, "benchBucket");
+    json_t* samples = json_array();
+    for (int i = 0; i < 1000; ++i) {
+        json_array_append_new(samples, json_pack("{s:i,s:f,s:f,s:s}",
+                "ts", 1400000000 + i * 10,
+                "temperature", 20.0 + (i % 17) * 0.25,
+                "humidity", 40.0 + (i % 11) * 0.5,
+                "status", "normal"));
+    }
+    json_t* contents = json_pack("{s:o}", "samples", samples);
+    kii_app_set_request_compression(app, threshold);
+
+    __block clock_t cpu = 0;
+    [self measureBlock:^{
+        clock_t begin = clock();
+        for (int i = 0; i < NUM_SEQUENTIAL_CALLS; ++i) {
+            kii_char_t* etag = NULL;
+            kii_error_code_t ret = kii_replace_object(app, ACCESS_TOKEN,
+                    bucket, "benchTelemetry", contents, NULL, &etag);
+            XCTAssertEqual(ret, KIIE_OK, @"replace object failed");
+            kii_dispose_kii_char(etag);
+        }
+        cpu += clock() - begin;
+    }];
+    kii_compression_stats_t stats;
+    kii_app_get_request_compression_stats(app, &stats);
+    NSLog(@"threshold %u: cpu %.3f sec, %lu bytes sent for %lu bytes",
+          threshold, (double)cpu / CLOCKS_PER_SEC,
+          stats.compressed_bytes, stats.decompressed_bytes);
+
+    json_decref(contents);
+    kii_dispose_bucket(bucket);
+    kii_dispose_thing(thing);
+    kii_dispose_app(app);
+}
+
+// Replace an object with telemetry formatted from a fixed template, as
+// firmware does. json contents have to be parsed from the text before they
+// are passed, while raw contents are sent as they are.
+-(void) measureReplaceFromTemplate:(BOOL)raw {
+    kii_app_t app = kii_init_app(APPID, APPKEY, BASEURL);
+    kii_thing_t thing = kii_thing_deserialize(REGISTERED_THING_TID);
+    kii_bucket_t bucket = kii_init_thing_bucket(thing, "benchBucket");
+    char* text = malloc(128 * 1024);
+    size_t length = sprintf(text, "{\"samples\":[");
+    for (int i = 0; i < 1000; ++i) {
+        length += sprintf(text + length,
+                "%s{\"ts\":%d,\"temperature\":%.2f,\"status\":\"normal\"}",
+                (i > 0) ? "," : "", 1400000000 + i * 10,
+                20.0 + (i % 17) * 0.25);
+    }
+    length += sprintf(text + length, "]}");
+
+    __block clock_t cpu = 0;
+    [self measureBlock:^{
+        clock_t begin = clock();
+        for (int i = 0; i < NUM_SEQUENTIAL_CALLS; ++i) {
+            kii_error_code_t ret = KIIE_FAIL;
+            if (raw) {
+                ret = kii_replace_object_raw(app, ACCESS_TOKEN, bucket,
+                        "benchTemplate", text, length, NULL, NULL);
+            } else {
+                json_t* contents = json_loadb(text, length, 0, NULL);
+                ret = kii_replace_object(app, ACCESS_TOKEN, bucket,
+                        "benchTemplate", contents, NULL, NULL);
+                json_decref(contents);
+            }
+            XCTAssertEqual(ret, KIIE_OK, @"replace object failed");
+        }
+        cpu += clock() - begin;
+    }];
+    NSLog(@"%s: cpu %.3f sec for %lu bytes", raw ? "raw" : "json",
+          (double)cpu / CLOCKS_PER_SEC, (unsigned long)length);
+
+    free(text);
+    kii_dispose_bucket(bucket);
+    kii_dispose_thing(thing);
+    kii_dispose_app(app);
+}
+
+// Worker threads call apis with their own app at the same time.
+// Connections are not pooled so that each call pays name resolution and
+// TLS handshake unless they are shared between threads.
+-(void) testSequentialCallsFromThreads {
+    kii_global_init();
+    kii_global_set_connection_pool(0, 0);
+    [self measureBlock:^{
+        dispatch_apply(4, dispatch_get_global_queue(
+                DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t index) {
+            kii_app_t app = kii_init_app(APPID, APPKEY, BASEURL);
+            kii_thing_t thing = kii_thing_deserialize(REGISTERED_THING_TID);
+            kii_bucket_t bucket = kii_init_thing_bucket(thing, "benchBucket");
+            json_t* contents = json_object();
+            json_object_set_new(contents, "temperature", json_integer(25));
+            for (int i = 0; i < NUM_SEQUENTIAL_CALLS; ++i) {
+                kii_char_t* objectId = NULL;
+                kii_char_t* etag = NULL;
+                kii_error_code_t ret = kii_create_new_object(app,
+                        ACCESS_TOKEN, bucket, contents, &objectId, &etag);
+                XCTAssertEqual(ret, KIIE_OK, @"create object failed");
+                kii_dispose_kii_char(etag);
+                kii_dispose_kii_char(objectId);
+            }
+            json_decref(contents);
+            kii_dispose_bucket(bucket);
+            kii_dispose_thing(thing);
+            kii_dispose_app(app);
+        });
+    }];
+    kii_global_cleanup();
+}
+
+static void countFailure(kii_app_t app, kii_error_code_t result, void* userdata)
+{
+    if (result != KIIE_OK) {
+        ++(*(int*)userdata);
+    }
+}
+
+// Create objects in parallel by async apis to measure latency of a burst.
+-(void) measureParallelCalls {
+    kii_app_t app = kii_init_app(APPID, APPKEY, BASEURL);
+    kii_thing_t thing = kii_thing_deserialize(REGISTERED_THING_TID);
+    kii_bucket_t bucket = kii_init_thing_bucket(thing, "benchBucket");
+    json_t* contents = json_object();
+    json_object_set_new(contents, "temperature", json_integer(25));
+
+    [self measureBlock:^{
+        kii_char_t* objectIds[NUM_PARALLEL_CALLS];
+        kii_char_t* etags[NUM_PARALLEL_CALLS];
+        int failures = 0;
+        for (int i = 0; i < NUM_PARALLEL_CALLS; ++i) {
+            objectIds[i] = NULL;
+            etags[i] = NULL;
+            kii_error_code_t ret = kii_create_new_object_async(app,
+                    ACCESS_TOKEN, bucket, contents, &objectIds[i], &etags[i],
+                    countFailure, &failures);
+            XCTAssertEqual(ret, KIIE_OK, @"create object not started");
+        }
+        kii_app_run(app);
+        XCTAssertEqual(failures, 0, @"create object failed");
+        for (int i = 0; i < NUM_PARALLEL_CALLS; ++i) {
+            kii_dispose_kii_char(etags[i]);
+            kii_dispose_kii_char(objectIds[i]);
+        }
+    }];
+
+    json_decref(contents);
+    kii_dispose_bucket(bucket);
+    kii_dispose_thing(thing);
+    kii_dispose_app(app);
+}
+
+// Create objects by a batch api to compare with measureParallelCalls.
+-(void) testCreateObjectsInBatch {
+    kii_global_init();
+    kii_app_t app = kii_init_app(APPID, APPKEY, BASEURL);
+    kii_thing_t thing = kii_thing_deserialize(REGISTERED_THING_TID);
+    kii_bucket_t bucket = kii_init_thing_bucket(thing, "benchBucket");
+    // blocks can't capture arrays.
+    json_t** contents = malloc(sizeof(json_t*) * NUM_PARALLEL_CALLS);
+    for (int i = 0; i < NUM_PARALLEL_CALLS; ++i) {
+        contents[i] = json_object();
+        json_object_set_new(contents[i], "temperature", json_integer(25));
+    }
+
+    [self measureBlock:^{
+        kii_object_result_t results[NUM_PARALLEL_CALLS];
+        kii_error_code_t ret = kii_create_new_objects(app, ACCESS_TOKEN,
+                bucket, (const json_t* const*)contents, NUM_PARALLEL_CALLS, 8,
+                results);
+        XCTAssertEqual(ret, KIIE_OK, @"create objects failed");
+        kii_dispose_object_results(results, NUM_PARALLEL_CALLS);
+    }];
+
+    for (int i = 0; i < NUM_PARALLEL_CALLS; ++i) {
+        json_decref(contents[i]);
+    }
+    free(contents);
+    kii_dispose_bucket(bucket);
+    kii_dispose_thing(thing);
+    kii_dispose_app(app);
+    kii_global_cleanup();
+}
+
+// Refresh objects by a batch api instead of kii_get_object for each.
+-(void) testGetObjectsInBatch {
+    kii_global_init();
+    kii_app_t app = kii_init_app(APPID, APPKEY, BASEURL);
+    kii_thing_t thing = kii_thing_deserialize(REGISTERED_THING_TID);
+    kii_bucket_t bucket = kii_init_thing_bucket(thing, "benchBucket");
+    json_t* contents = json_object();
+    json_object_set_new(contents, "temperature", json_integer(25));
+    // blocks can't capture arrays.
+    kii_object_result_t* created =
+        malloc(sizeof(kii_object_result_t) * NUM_PARALLEL_CALLS);
+    const kii_char_t** objectIds =
+        malloc(sizeof(kii_char_t*) * NUM_PARALLEL_CALLS);
+    for (int i = 0; i < NUM_PARALLEL_CALLS; ++i) {
+        kii_error_code_t ret = kii_create_new_object(app, ACCESS_TOKEN,
+                bucket, contents, &(created[i].object_id), &(created[i].etag));
+        XCTAssertEqual(ret, KIIE_OK, @"create object failed");
+        created[i].contents = NULL;
+        objectIds[i] = created[i].object_id;
+    }
+
+    [self measureBlock:^{
+        kii_object_result_t results[NUM_PARALLEL_CALLS];
+        kii_error_code_t ret = kii_get_objects(app, ACCESS_TOKEN, bucket,
+                objectIds, NUM_PARALLEL_CALLS, 8, results);
+        XCTAssertEqual(ret, KIIE_OK, @"get objects failed");
+        kii_dispose_object_results(results, NUM_PARALLEL_CALLS);
+    }];
+
+    kii_dispose_object_results(created, NUM_PARALLEL_CALLS);
+    free(created);
+    free(objectIds);
+    json_decref(contents);
+    kii_dispose_bucket(bucket);
+    kii_dispose_thing(thing);
+    kii_dispose_app(app);
+    kii_global_cleanup();
+}
+
+-(void) testParallelCallsWithHttp2 {
+    kii_global_init();
+    if (kii_global_set_http2_multiplexing(8) != KIIE_OK) {
+        NSLog(@"HTTP/2 is not supported by linked libcurl.");
+    } else {
+        [self measureParallelCalls];
+    }
+    kii_global_cleanup();
+}
+
+-(void) testParallelCallsWithoutHttp2 {
+    kii_global_init();
+    kii_global_set_http2_multiplexing(0);
+    [self measureParallelCalls];
+    kii_global_cleanup();
+}
+
+-(void) testReplaceTelemetryWithRequestCompression {
+    kii_global_init();
+    [self measureReplaceTelemetry:1024];
+    kii_global_cleanup();
+}
+
+-(void) testReplaceTelemetryWithoutRequestCompression {
+    kii_global_init();
+    [self measureReplaceTelemetry:0];
+    kii_global_cleanup();
+}
+
+-(void) testReplaceFromTemplateAsJson {
+    kii_global_init();
+    [self measureReplaceFromTemplate:NO];
+    kii_global_cleanup();
+}
+
+-(void) testReplaceFromTemplateAsRaw {
+    kii_global_init();
+    [self measureReplaceFromTemplate:YES];
+    kii_global_cleanup();
+}
 @end
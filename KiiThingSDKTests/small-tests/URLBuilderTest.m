@@ -8,6 +8,8 @@
 #import <XCTest/XCTest.h>
 
 #import "kii_prv_utils.h"
+#import "kii_cloud.h"
+#import "kii_prv_types.h"
 
 #import <string.h>
 
@@ -33,4 +35,132 @@
     free(url);
 }
 
+- (void)testBuildUrlWithPrefix
+{
+    const char base[] = "http://hoge.com/apps/app";
+    const char path[] = "things/th/buckets/b";
+    char *buffer = NULL;
+    size_t capacity = 0;
+    char *url = prv_build_url_with_prefix(&buffer, &capacity, base,
+            strlen(base), path, strlen(path), "objects", "o1", NULL);
+    XCTAssertTrue(strcmp("http://hoge.com/apps/app/things/th/buckets/b/objects/o1",
+                url) == 0 ? YES : NO, @"url unmatched: %s", url);
+    XCTAssertTrue(url == buffer ? YES : NO);
+    XCTAssertTrue(capacity > strlen(url) ? YES : NO);
+
+    /* shorter url is built in the same buffer. */
+    url = prv_build_url_with_prefix(&buffer, &capacity, base, strlen(base),
+            NULL, 0, NULL);
+    XCTAssertTrue(strcmp(base, url) == 0 ? YES : NO,
+                 @"url unmatched: %s , %s", base, url);
+    XCTAssertTrue(url == buffer ? YES : NO);
+    free(buffer);
+}
+
+- (void)testReserveBuffer
+{
+    char *buffer = NULL;
+    size_t capacity = 0;
+
+    XCTAssertEqual(prv_reserve_buffer(&buffer, &capacity, 10), KII_TRUE);
+    XCTAssertTrue(buffer != NULL ? YES : NO);
+    XCTAssertEqual(capacity, (size_t)KII_BUFFER_MIN_SIZE);
+    strcpy(buffer, "kept");
+
+    XCTAssertEqual(prv_reserve_buffer(&buffer, &capacity,
+                KII_BUFFER_MIN_SIZE + 1), KII_TRUE);
+    XCTAssertEqual(capacity, (size_t)KII_BUFFER_MIN_SIZE * 2);
+    XCTAssertTrue(strcmp("kept", buffer) == 0 ? YES : NO);
+    free(buffer);
+}
+
+- (void)testParseResponseHeader
+{
+    prv_kii_resp_headers_t headers;
+    const char etag[] = "ETag: \"2\"\r\nignored";
+    const char length[] = "content-LENGTH:  123\r\n";
+
+    prv_init_resp_headers(&headers);
+    prv_parse_resp_header(etag, strlen("ETag: \"2\"\r\n"), &headers);
+    prv_parse_resp_header(length, strlen(length), &headers);
+    prv_parse_resp_header("HTTP/1.1 200 OK\r\n", 17, &headers);
+
+    XCTAssertTrue(strcmp("\"2\"", headers.etag) == 0 ? YES : NO,
+                 @"etag unmatched: %s", headers.etag);
+    XCTAssertEqual(headers.content_length, 123L);
+    XCTAssertEqual(headers.retry_after, -1);
+    XCTAssertTrue(headers.content_encoding[0] == '\0' ? YES : NO);
+    XCTAssertEqual(headers.chunked, KII_FALSE);
+    XCTAssertEqual(headers.connection_close, KII_FALSE);
+}
+
+- (void)testParseConnectionHeaders
+{
+    prv_kii_resp_headers_t headers;
+    const char encoding[] = "Transfer-Encoding: Chunked\r\n";
+    const char connection[] = "connection:close\r\n";
+
+    prv_init_resp_headers(&headers);
+    prv_parse_resp_header(encoding, strlen(encoding), &headers);
+    prv_parse_resp_header(connection, strlen(connection), &headers);
+
+    XCTAssertEqual(headers.chunked, KII_TRUE);
+    XCTAssertEqual(headers.connection_close, KII_TRUE);
+}
+
+- (void)testParseHeaderValueEdgeCases
+{
+    prv_kii_resp_headers_t headers;
+    const char length[] = "Content-Length: 99999999999999999999999\r\n";
+    const char retry[] = "Retry-After: 4294967296\r\n";
+    const char codings[] = "Transfer-Encoding: gzip, Chunked\r\n";
+    const char notLast[] = "Transfer-Encoding: chunked, gzip\r\n";
+
+    prv_init_resp_headers(&headers);
+    prv_parse_resp_header(length, strlen(length), &headers);
+    prv_parse_resp_header(retry, strlen(retry), &headers);
+    prv_parse_resp_header(codings, strlen(codings), &headers);
+    XCTAssertEqual(headers.content_length, -1L);
+    XCTAssertEqual(headers.retry_after, -1);
+    XCTAssertEqual(headers.chunked, KII_TRUE);
+
+    prv_parse_resp_header(notLast, strlen(notLast), &headers);
+    XCTAssertEqual(headers.chunked, KII_FALSE);
+}
+
+- (void)testParseJsonByteByByte
+{
+    prv_kii_json_parser_t parser;
+    const char text[] = "{\"a\":[1,-2.5e1,true,null],\"b\":\"\\u00e9\\ud83d\\ude00\"}";
+    json_t* expected = json_loads(text, 0, NULL);
+    json_t* parsed = NULL;
+    size_t i = 0;
+
+    prv_init_json_parser(&parser);
+    for (i = 0; i < strlen(text); ++i) {
+        XCTAssertEqual(prv_feed_json_parser(&parser, &text[i], 1), 0);
+    }
+    parsed = prv_finish_json_parser(&parser);
+
+    XCTAssertTrue(expected != NULL ? YES : NO);
+    XCTAssertTrue(json_equal(expected, parsed) ? YES : NO);
+    json_decref(expected);
+    json_decref(parsed);
+}
+
+- (void)testParseInvalidJson
+{
+    prv_kii_json_parser_t parser;
+    const char* texts[] = { "[1,]", "{\"a\" 1}", "[01]", "\"str\"", "[1] x",
+        "[\"\\ud83d\"]", "[\"\xc3\"]", "[1" };
+    size_t i = 0;
+
+    for (i = 0; i < sizeof(texts) / sizeof(texts[0]); ++i) {
+        prv_init_json_parser(&parser);
+        prv_feed_json_parser(&parser, texts[i], strlen(texts[i]));
+        XCTAssertTrue(prv_finish_json_parser(&parser) == NULL ? YES : NO,
+                @"parsed invalid json: %s", texts[i]);
+    }
+}
+
 @end